@@ -0,0 +1,32 @@
+#include "BlobDevice.h"
+
+#include <algorithm>
+
+BlobDevice::BlobDevice(ReadLease lease, sqlite3_blob* blob)
+    : lease(std::move(lease)), blob(blob), bytes(sqlite3_blob_bytes(blob)) {
+  // Unbuffered: QIODevice would otherwise stage reads in its own buffer
+  open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+BlobDevice::~BlobDevice() {
+  close();
+  sqlite3_blob_close(blob);
+}
+
+qint64 BlobDevice::readData(char* data, qint64 maxSize) {
+  qint64 count = std::min(maxSize, bytes - pos());
+  if (count <= 0) return 0;
+
+  int rc = sqlite3_blob_read(blob, data, static_cast<int>(count),
+                             static_cast<int>(pos()));
+  if (rc != SQLITE_OK) {
+    // SQLITE_ABORT: the row was changed or deleted since the blob was opened
+    setErrorString(QString::fromUtf8(sqlite3_errstr(rc)));
+    return -1;
+  }
+  return count;
+}
+
+qint64 BlobDevice::writeData(const char*, qint64) {
+  return -1;
+}
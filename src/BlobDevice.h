@@ -0,0 +1,34 @@
+#ifndef BLOBDEVICE_H
+#define BLOBDEVICE_H
+
+#include <sqlite3.h>
+
+#include <QIODevice>
+
+#include "ReadConnectionPool.h"
+
+// Read-only, random-access QIODevice over an open sqlite3_blob handle, so
+// QImageReader and friends can decode a BLOB in place. Reads go straight
+// from the database pages into the caller's buffer with sqlite3_blob_read;
+// the BLOB is never copied whole. The device keeps the connection it was
+// opened on checked out until it is destroyed, so keep it short-lived.
+class BlobDevice : public QIODevice {
+ public:
+  // Takes ownership of blob, which must have been opened on lease's connection
+  BlobDevice(ReadLease lease, sqlite3_blob* blob);
+  ~BlobDevice() override;
+
+  bool isSequential() const override { return false; }
+  qint64 size() const override { return bytes; }
+
+ protected:
+  qint64 readData(char* data, qint64 maxSize) override;
+  qint64 writeData(const char* data, qint64 maxSize) override;
+
+ private:
+  ReadLease lease;
+  sqlite3_blob* blob;
+  qint64 bytes;
+};
+
+#endif  // BLOBDEVICE_H
@@ -1,6 +1,7 @@
 #include "CADventory.h"
 
 #include <iostream>
+#include <string>
 
 #include <QPixmap>
 #include <QTimer>
@@ -11,6 +12,7 @@
 #include "MainWindow.h"
 #include "SplashDialog.h"
 #include "FilesystemIndexer.h"
+#include "Model.h"
 
 
 CADventory::CADventory(int &argc, char *argv[]) : QApplication (argc, argv), window(nullptr), splash(nullptr), loaded(false), gui(true)
@@ -36,10 +38,13 @@ CADventory::CADventory(int &argc, char *argv[]) : QApplication (argc, argv), win
     this->gui = false;
     connect(this, &CADventory::indexingComplete, this, &QCoreApplication::quit);
 
-    // could be separate setting, but let CLI-mode also wipe out all settings
-    QSettings settings;
-    settings.clear();
-    settings.sync();
+    // could be separate setting, but let CLI-mode also wipe out all settings;
+    // --stats only reads a catalog, so it leaves them alone
+    if (std::string(argv[1]) != "--stats") {
+      QSettings settings;
+      settings.clear();
+      settings.sync();
+    }
   }
 }
 
@@ -103,6 +108,29 @@ void CADventory::showSplash()
 }
 
 
+int CADventory::printStatistics(const char *path)
+{
+  QDir catalog(QDir(path).filePath(".cadventory"));
+  if (!catalog.exists("metadata.db")) {
+    qInfo().noquote() << "No CADventory catalog found in" << path;
+    return 1;
+  }
+
+  Model model(path);
+  CatalogStatistics stats = model.statistics();
+
+  qInfo().noquote() << "Models:   " << stats.total;
+  qInfo().noquote() << "Included: " << stats.included;
+  qInfo().noquote() << "Processed:" << stats.processed
+                    << "(" + QString::number(stats.includedProcessed) + " of included)";
+  qInfo().noquote() << "Selected: " << stats.selected;
+  for (const auto& [tag, count] : stats.tagCounts) {
+    qInfo().noquote() << "Tag" << QString::fromStdString(tag) + ":" << count;
+  }
+  return 0;
+}
+
+
 void CADventory::indexDirectory(const char *path)
 {
   qInfo() << "Indexing...";
@@ -19,6 +19,9 @@ public:
 
   void indexDirectory(const char *path);
 
+  // CLI: print catalog counters for the library at path; returns exit status
+  int printStatistics(const char *path);
+
 signals:
   void indexingComplete(const char *summary);
 
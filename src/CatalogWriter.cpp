@@ -0,0 +1,124 @@
+#include "CatalogWriter.h"
+
+#include <exception>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// A command that throws must not take the writer thread, and with it the
+// open batch and its lock, down with it
+void runCommand(const CatalogWriter::Command& cmd) {
+  try {
+    cmd();
+  } catch (const std::exception& e) {
+    std::cerr << "Catalog writer: command failed: " << e.what() << std::endl;
+  } catch (...) {
+    std::cerr << "Catalog writer: command failed" << std::endl;
+  }
+}
+
+}  // namespace
+
+CatalogWriter::CatalogWriter(Command begin, Command commit, size_t maxBatch,
+                             std::chrono::milliseconds maxDelay)
+    : begin(std::move(begin)),
+      commit(std::move(commit)),
+      maxBatch(maxBatch > 0 ? maxBatch : 1),
+      maxDelay(maxDelay) {
+  Node* stub = new Node();
+  head.store(stub);
+  tail = stub;
+  thread = std::thread(&CatalogWriter::run, this);
+}
+
+CatalogWriter::~CatalogWriter() {
+  stopping.store(true);
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    wake.notify_one();
+  }
+  thread.join();
+  delete tail;
+}
+
+void CatalogWriter::push(Node* node) {
+  // Vyukov's intrusive MPSC queue: one exchange claims the slot, then the
+  // previous node is linked to it. The consumer may briefly see the list
+  // cut at prev; it treats that as empty and is woken again below.
+  Node* prev = head.exchange(node);
+  prev->next.store(node);
+
+  if (sleeping.load()) {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    wake.notify_one();
+  }
+}
+
+CatalogWriter::Node* CatalogWriter::pop() {
+  Node* next = tail->next.load();
+  if (!next) return nullptr;
+  delete tail;
+  tail = next;
+  return next;  // stays allocated as the new tail; its command is moved out
+}
+
+bool CatalogWriter::empty() const { return tail->next.load() == nullptr; }
+
+void CatalogWriter::flush() {
+  auto done = std::make_shared<std::promise<void>>();
+  std::future<void> future = done->get_future();
+  push(new Node([done]() { done->set_value(); }, true));
+  future.wait();
+}
+
+void CatalogWriter::run() {
+  using Clock = std::chrono::steady_clock;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(wakeMutex);
+      sleeping.store(true);
+      wake.wait(lock, [this] { return !empty() || stopping.load(); });
+      sleeping.store(false);
+    }
+    if (empty() && stopping.load()) return;
+
+    // Collect the batch before opening it, so begin()'s lock is held only
+    // while commands run and never across the wait for more of them
+    auto deadline = Clock::now() + maxDelay;
+    std::vector<Command> batch;
+    std::vector<Command> afterCommit;
+
+    while (batch.size() < maxBatch) {
+      Node* node = pop();
+      if (node) {
+        Command cmd = std::move(node->cmd);
+        if (node->barrier) {
+          afterCommit.push_back(std::move(cmd));
+          break;
+        }
+        batch.push_back(std::move(cmd));
+        continue;
+      }
+      if (stopping.load() || Clock::now() >= deadline) break;
+
+      std::unique_lock<std::mutex> lock(wakeMutex);
+      sleeping.store(true);
+      wake.wait_until(lock, deadline,
+                      [this] { return !empty() || stopping.load(); });
+      sleeping.store(false);
+    }
+
+    if (!batch.empty()) {
+      begin();
+      for (auto& cmd : batch) {
+        runCommand(cmd);
+      }
+      commit();
+    }
+    for (auto& cmd : afterCommit) {
+      runCommand(cmd);
+    }
+  }
+}
@@ -0,0 +1,93 @@
+#ifndef CATALOGWRITER_H
+#define CATALOGWRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+// Single writer thread that group-commits queued catalog mutations.
+//
+// Producers push onto a lock-free multi-producer/single-consumer list. The
+// writer collects commands until it has maxBatch of them or maxDelay has
+// passed since the first one, then runs them between begin() and commit(),
+// so whatever begin() locks is held only while the batch runs. Commands
+// from one producer run in the order they were queued.
+class CatalogWriter {
+ public:
+  using Command = std::function<void()>;
+
+  CatalogWriter(Command begin, Command commit, size_t maxBatch,
+                std::chrono::milliseconds maxDelay);
+  CatalogWriter(const CatalogWriter&) = delete;
+  CatalogWriter& operator=(const CatalogWriter&) = delete;
+  // Runs and commits everything still queued, then joins the thread
+  ~CatalogWriter();
+
+  // The future resolves once fn has run inside its batch, which can be up
+  // to maxDelay after it was queued; the result is visible to other
+  // connections after that batch commits. If fn
+  // throws, the future rethrows and the batch carries on without it.
+  template <typename Fn>
+  auto submit(Fn fn) -> std::future<decltype(fn())> {
+    using Result = decltype(fn());
+    auto promise = std::make_shared<std::promise<Result>>();
+    std::future<Result> future = promise->get_future();
+    push(new Node([promise, fn = std::move(fn)]() mutable {
+      try {
+        if constexpr (std::is_void_v<Result>) {
+          fn();
+          promise->set_value();
+        } else {
+          promise->set_value(fn());
+        }
+      } catch (...) {
+        promise->set_exception(std::current_exception());
+      }
+    }));
+    return future;
+  }
+
+  // Blocks until everything this thread queued so far has been committed.
+  // Must not be called from a command or while holding the writer's lock.
+  void flush();
+
+  bool onWriterThread() const {
+    return std::this_thread::get_id() == thread.get_id();
+  }
+
+ private:
+  struct Node {
+    explicit Node(Command cmd = nullptr, bool barrier = false)
+        : cmd(std::move(cmd)), barrier(barrier) {}
+    std::atomic<Node*> next{nullptr};
+    Command cmd;
+    bool barrier;  // commit the open batch before running cmd
+  };
+
+  void push(Node* node);
+  Node* pop();
+  bool empty() const;
+  void run();
+
+  Command begin;
+  Command commit;
+  size_t maxBatch;
+  std::chrono::milliseconds maxDelay;
+
+  std::atomic<Node*> head;  // producers swap themselves in here
+  Node* tail;               // consumer side; always a spent node
+
+  std::atomic<bool> stopping{false};
+  std::atomic<bool> sleeping{false};
+  std::mutex wakeMutex;
+  std::condition_variable wake;
+  std::thread thread;
+};
+
+#endif  // CATALOGWRITER_H
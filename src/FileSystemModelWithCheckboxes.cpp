@@ -185,7 +185,7 @@ bool FileSystemModelWithCheckboxes::setData(const QModelIndex& index, const QVar
             if (modelData.id != 0)
             {
                 modelData.is_included = included;
-                model->updateModel(modelData.id, modelData);
+                model->updateModelFields(modelData.id, modelData, Model::IsIncludedField);
             }
             else if (included)
             {
@@ -274,7 +274,7 @@ void FileSystemModelWithCheckboxes::updateChildren(const QModelIndex& index, Qt:
             if (modelData.id != 0)
             {
                 modelData.is_included = included;
-                model->updateModel(modelData.id, modelData);
+                model->updateModelFields(modelData.id, modelData, Model::IsIncludedField);
             }
             else if (included)
             {
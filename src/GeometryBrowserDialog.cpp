@@ -11,6 +11,7 @@
 #include <array>
 #include <regex>
 #include <sstream>
+#include <unordered_map>
 
 GeometryBrowserDialog::GeometryBrowserDialog(int modelId, Model* model, QWidget* parent)
     : QDialog(parent), modelId(modelId), model(model) {
@@ -26,7 +27,13 @@ GeometryBrowserDialog::GeometryBrowserDialog(int modelId, Model* model, QWidget*
     treeWidget->setExpandsOnDoubleClick(false);
     treeWidget->setAnimated(true);
 
-    populateTreeWidget();
+    if (packedTree.isValid()) {
+        for (size_t node : packedTree.children(-1)) {
+            treeWidget->addTopLevelItem(createPackedItem(node));
+        }
+    } else {
+        populateTreeWidget();
+    }
 
     // layout
     QVBoxLayout* mainLayout = new QVBoxLayout();
@@ -36,12 +43,32 @@ GeometryBrowserDialog::GeometryBrowserDialog(int modelId, Model* model, QWidget*
 
     // connections
     connect(treeWidget, &QTreeWidget::itemChanged, this, &GeometryBrowserDialog::onItemChanged);
+    connect(treeWidget, &QTreeWidget::itemExpanded, this, &GeometryBrowserDialog::onItemExpanded);
 }
 
 void GeometryBrowserDialog::loadObjects() {
+    // Packed models keep the hierarchy in one blob and a single object row
+    packedTree = model->getObjectTree(modelId);
+    if (packedTree.isValid()) {
+        for (const auto& obj : model->getObjectsForModel(modelId)) {
+            selectedRowId = obj.object_id;
+            if (obj.is_selected) {
+                selectedName = obj.name;
+            }
+        }
+        return;
+    }
+
     // Get the objects from the model
     std::vector<ObjectData> objects = model->getObjectsForModel(modelId);
 
+    // Parent lookups by id, instead of scanning the list for every object
+    std::unordered_map<int, std::string> namesById;
+    namesById.reserve(objects.size());
+    for (const auto& obj : objects) {
+        namesById[obj.object_id] = obj.name;
+    }
+
     // Build the geometryData map and objectNameToIdMap
     for (const auto& obj : objects) {
         objectNameToIdMap[obj.name] = obj.object_id;
@@ -49,13 +76,8 @@ void GeometryBrowserDialog::loadObjects() {
         if (obj.parent_object_id == -1) {
             geometryData[obj.name] = std::vector<std::string>();
         } else {
-            std::string parentName;
-            for (const auto& potentialParent : objects) {
-                if (potentialParent.object_id == obj.parent_object_id) {
-                    parentName = potentialParent.name;
-                    break;
-                }
-            }
+            auto parent = namesById.find(obj.parent_object_id);
+            std::string parentName = parent != namesById.end() ? parent->second : std::string();
             if (!parentName.empty()) {
                 geometryData[parentName].push_back(obj.name);
             } else {
@@ -127,6 +149,19 @@ void GeometryBrowserDialog::onItemChanged(QTreeWidgetItem* item, int column) {
     QString itemName = item->text(0);
     std::string objectName = itemName.toStdString();
 
+    if (packedTree.isValid()) {
+        isUpdatingCheckState = true;
+        if (item->checkState(0) == Qt::Checked) {
+            uncheckAllExcept(item);
+            selectPackedObject(objectName);
+        } else if (objectName == selectedName && selectedRowId != -1) {
+            model->setObjectData(selectedRowId, false, Model::IsSelectedRole);
+            selectedName.clear();
+        }
+        isUpdatingCheckState = false;
+        return;
+    }
+
     if (objectNameToIdMap.find(objectName) != objectNameToIdMap.end()) {
         int objectId = objectNameToIdMap[objectName];
         bool isSelected = (item->checkState(0) == Qt::Checked);
@@ -177,3 +212,54 @@ void GeometryBrowserDialog::uncheckItemRecursively(QTreeWidgetItem* item, QTreeW
         uncheckItemRecursively(childItem, exceptItem);
     }
 }
+
+QTreeWidgetItem* GeometryBrowserDialog::createPackedItem(size_t node) {
+    QIcon folderClosedIcon = QApplication::style()->standardIcon(QStyle::SP_DirClosedIcon);
+    QIcon fileIcon = QApplication::style()->standardIcon(QStyle::SP_FileIcon);
+
+    std::string name(packedTree.name(node));
+    QTreeWidgetItem* item = new QTreeWidgetItem();
+    item->setText(0, QString::fromStdString(name));
+    item->setData(0, Qt::UserRole, static_cast<qulonglong>(node));
+    item->setCheckState(0, name == selectedName ? Qt::Checked : Qt::Unchecked);
+
+    // children are only created once the item is expanded
+    if (packedTree.hasChildren(node)) {
+        item->setIcon(0, folderClosedIcon);
+        item->setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
+    } else {
+        item->setIcon(0, fileIcon);
+    }
+    return item;
+}
+
+void GeometryBrowserDialog::onItemExpanded(QTreeWidgetItem* item) {
+    if (!packedTree.isValid() || item->childCount() > 0) {
+        return;
+    }
+
+    size_t node = item->data(0, Qt::UserRole).toULongLong();
+    isUpdatingCheckState = true;
+    for (size_t child : packedTree.children(static_cast<int>(node))) {
+        item->addChild(createPackedItem(child));
+    }
+    isUpdatingCheckState = false;
+    item->setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicatorWhenChildless);
+}
+
+void GeometryBrowserDialog::selectPackedObject(const std::string& name) {
+    // the model's one object row follows whatever is checked
+    ObjectData selected;
+    selected.object_id = selectedRowId;
+    selected.model_id = modelId;
+    selected.name = name;
+    selected.parent_object_id = -1;
+    selected.is_selected = true;
+
+    if (selectedRowId == -1) {
+        selectedRowId = model->insertObject(selected);
+    } else {
+        model->updateObject(selected);
+    }
+    selectedName = name;
+}
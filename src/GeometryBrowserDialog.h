@@ -15,6 +15,7 @@ public:
 
 private slots:
     void onItemChanged(QTreeWidgetItem* item, int column);
+    void onItemExpanded(QTreeWidgetItem* item);
 
 private:
     void loadObjects();
@@ -22,6 +23,11 @@ private:
     void uncheckAllExcept(QTreeWidgetItem* exceptItem);
     void uncheckItemRecursively(QTreeWidgetItem* item, QTreeWidgetItem* exceptItem);
 
+    // Packed models: items are decoded from the tree blob as their parent
+    // is expanded, and selection moves the model's single object row
+    QTreeWidgetItem* createPackedItem(size_t node);
+    void selectPackedObject(const std::string& name);
+
     int modelId;
     Model* model;
     QTreeWidget* treeWidget;
@@ -33,6 +39,10 @@ private:
     std::map<std::string, std::vector<std::string>> geometryData;
 
     bool isUpdatingCheckState = false;
+
+    ObjectTree packedTree;
+    int selectedRowId = -1;
+    std::string selectedName;
 };
 
 #endif // GEOMETRYBROWSERDIALOG_H
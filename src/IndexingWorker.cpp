@@ -2,7 +2,16 @@
 #include "ProcessGFiles.h"
 #include "Model.h"
 #include <QDebug>
+#include <QSettings>
+#include <QThread>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <filesystem>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <thread>
 
 namespace fs = std::filesystem;
 
@@ -18,11 +27,97 @@ void IndexingWorker::stop() {
     m_stopRequested.store(true);
 }
 
+int IndexingWorker::indexingThreadCount() {
+    // 0, the default, means one thread per core
+    QSettings settings;
+    int threads = settings.value("indexingThreads", 0).toInt();
+    if (threads <= 0) {
+        threads = QThread::idealThreadCount();
+    }
+    return std::max(threads, 1);
+}
+
 void IndexingWorker::requestReindex() {
     qDebug() << "Indexing reindex requested";
     m_reindexRequested.store(true);
 }
 
+std::vector<IndexingWorker::PendingFile> IndexingWorker::findChangedFiles(Model* model) {
+    std::vector<PendingFile> changed;
+    std::map<int, unsigned int> quarantined = model->getQuarantinedStages();
+
+    for (const auto& signature : model->getIncludedFileSignatures()) {
+        if (m_stopRequested.load()) {
+            break;
+        }
+
+        std::error_code ec;
+        fs::path path(signature.file_path);
+        auto size = fs::file_size(path, ec);
+        if (ec) {
+            qDebug() << "IndexingWorker: cannot stat" << QString::fromStdString(signature.file_path);
+            continue;
+        }
+        auto mtime = fs::last_write_time(path, ec);
+        if (ec) {
+            continue;
+        }
+
+        PendingFile pending;
+        pending.signature = signature;
+        pending.size = static_cast<int64_t>(size);
+        pending.mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            mtime.time_since_epoch()).count();
+
+        // Same size and mtime: trust it without reading the file. The
+        // signature is recorded before processing, so the stage table says
+        // how far the last pass got.
+        bool unchanged = signature.size == pending.size && signature.mtime == pending.mtime;
+        if (unchanged) {
+            pending.hash = signature.hash;
+        } else {
+            pending.hash = model->hashModel(signature.file_path);
+            if (pending.hash == 0) {
+                continue;
+            }
+
+            // Touched but not modified (copied, checked out again, ...)
+            if (signature.hash == pending.hash) {
+                model->setFileSignatureAsync(signature.model_id, pending.size, pending.mtime, pending.hash);
+                unchanged = true;
+            }
+        }
+
+        // An unchanged file only redoes the stages that did not finish: a
+        // crash or timeout last time, or a stage reset since
+        pending.stages = unchanged ? Model::IndexingStages & ~signature.stages_done
+                                   : Model::IndexingStages;
+        pending.changed = !unchanged;
+        // What the last full render took, while the contents are the same
+        pending.renderCost = (unchanged && signature.render_cost > 0)
+                                 ? signature.render_cost
+                                 : ProcessGFiles::estimateRenderCost(pending.size);
+        if (unchanged && (signature.stages_done & Model::ThumbnailStage)) {
+            // Already has its full-size thumbnail; a preview would replace it
+            pending.stages &= ~Model::PreviewStage;
+        }
+
+        // Stages that keep failing on these contents wait out their backoff;
+        // new contents always get a fresh try
+        auto quarantine = quarantined.find(signature.model_id);
+        if (unchanged && quarantine != quarantined.end()) {
+            pending.stages &= ~quarantine->second;
+        }
+        if (pending.stages == 0) {
+            continue;
+        }
+
+        changed.push_back(pending);
+    }
+
+    return changed;
+}
+
 void IndexingWorker::process() {
     qDebug() << "IndexingWorker::process() started";
 
@@ -30,12 +125,11 @@ void IndexingWorker::process() {
         // Reset reindex request for this iteration
         m_reindexRequested.store(false);
 
-        ProcessGFiles processor(library->model);
+        Model* model = library->getModel();
 
-        // Retrieve models that need processing
-        std::vector<ModelData> modelsToProcess = library->model->getIncludedNotProcessedModels();
-        int totalFiles = modelsToProcess.size();
-        int processedFiles = 0;
+        // Retrieve models whose files are new or have changed
+        std::vector<PendingFile> filesToProcess = findChangedFiles(model);
+        int totalFiles = filesToProcess.size();
 
         if (totalFiles == 0) {
             emit progressUpdated("No files to process", 100);
@@ -49,21 +143,144 @@ void IndexingWorker::process() {
             continue;
         }
 
-        for (const auto& modelData : modelsToProcess) {
-            if (m_stopRequested.load()) {
-                qDebug() << "IndexingWorker::process() stopping due to stop request";
-                break;
+        // Shortest job first on two levels: every file's first pass (all but
+        // the full-size thumbnail, so with a quick preview) before any full
+        // render, so one huge assembly can't hold the rest of the library
+        // back, and the cheapest job first within each level. A file's full
+        // render joins the second level once its first pass is done, with
+        // the cost that pass measured.
+        std::vector<WorkItem> firstPasses;
+        auto cheaperLast = [](const WorkItem& a, const WorkItem& b) { return a.cost > b.cost; };
+        std::priority_queue<WorkItem, std::vector<WorkItem>, decltype(cheaperLast)> refinements(cheaperLast);
+        int totalItems = 0;
+        for (int i = 0; i < totalFiles; ++i) {
+            const PendingFile& pending = filesToProcess[i];
+            unsigned int firstPass = pending.stages & ~Model::ThumbnailStage;
+            if (firstPass) {
+                firstPasses.push_back({i, firstPass, true,
+                                       ProcessGFiles::estimateFirstPassCost(pending.size, pending.renderCost)});
+            } else {
+                refinements.push({i, Model::ThumbnailStage, true, pending.renderCost});
+            }
+            totalItems += (firstPass ? 1 : 0) + ((pending.stages & Model::ThumbnailStage) ? 1 : 0);
+        }
+        std::stable_sort(firstPasses.begin(), firstPasses.end(),
+                         [](const WorkItem& a, const WorkItem& b) { return a.cost < b.cost; });
+
+        std::mutex queueMutex;
+        std::condition_variable queueChanged;
+        size_t nextFirstPass = 0;
+        int firstPassesRunning = 0;
+
+        // Blocks while only full renders of unfinished first passes are
+        // left; false once there is nothing more to do or a stop is requested
+        auto takeWork = [&](WorkItem& item) {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            while (!m_stopRequested.load()) {
+                if (nextFirstPass < firstPasses.size()) {
+                    item = firstPasses[nextFirstPass++];
+                    ++firstPassesRunning;
+                    return true;
+                }
+                if (!refinements.empty()) {
+                    item = refinements.top();
+                    refinements.pop();
+                    return true;
+                }
+                if (firstPassesRunning == 0) {
+                    return false;
+                }
+                // Stop requests don't notify; look again now and then
+                queueChanged.wait_for(lock, std::chrono::milliseconds(100));
             }
-            int percentage = (processedFiles * 100) / totalFiles;
+            return false;
+        };
 
-            // Emit progress signal before processing the file
-            QString currentObject = QString::fromStdString(modelData.short_name);
-            emit progressUpdated(currentObject, percentage);
-            emit modelProcessed(modelData.id);
+        // Each thread takes the cheapest waiting item until none are left or
+        // a stop is requested; the item in hand is always finished
+        std::atomic<int> processedItems(0);
+        auto processFiles = [&]() {
+            ProcessGFiles processor(model, &m_stopRequested);
+            WorkItem item;
+            while (takeWork(item)) {
+                const PendingFile& pending = filesToProcess[item.file];
 
-            processor.processGFile(modelData);
-            processedFiles++;
+                if (!item.prelude) {
+                    // Render from what the file's first pass stored
+                    model->flushWrites();
+
+                    // A preview that failed or timed out would fail at full
+                    // size too, only more slowly
+                    if (pending.stages & Model::PreviewStage) {
+                        std::string previewError;
+                        for (const auto& status : model->getStageStatus(pending.signature.model_id)) {
+                            if (status.stage == Model::PreviewStage && status.state == Model::StageFailed) {
+                                previewError = status.error.empty() ? "Preview failed" : status.error;
+                            }
+                        }
+                        if (!previewError.empty()) {
+                            model->setStageStateAsync(pending.signature.model_id, Model::ThumbnailStage,
+                                                      Model::StageFailed, previewError);
+                            processedItems.fetch_add(1);
+                            continue;
+                        }
+                    }
+                }
+                ModelData modelData = model->getModelById(pending.signature.model_id);
+
+                // Emit progress signal before processing the file
+                int percentage = (processedItems.load() * 100) / totalItems;
+                QString currentObject = QString::fromStdString(modelData.short_name);
+                emit progressUpdated(currentObject, percentage);
+                emit modelProcessed(modelData.id);
+
+                // Record the signature and count the attempt before BRL-CAD
+                // touches the file, so one that crashes or hangs the process is
+                // backed off next time instead of retried straight away. Stage
+                // results from older contents no longer apply.
+                if (item.prelude) {
+                    if (pending.changed) {
+                        model->resetStages(Model::IndexingStages, modelData.id);
+                    }
+                    model->setFileSignatureAsync(modelData.id, pending.size, pending.mtime, pending.hash);
+                    model->recordStageAttemptAsync(modelData.id, pending.stages);
+                    model->flushWrites();
+                }
+
+                processor.processGFile(modelData, item.stages);
+                processedItems.fetch_add(1);
+
+                if (item.stages != Model::ThumbnailStage) {
+                    {
+                        std::lock_guard<std::mutex> lock(queueMutex);
+                        --firstPassesRunning;
+                        if (pending.stages & Model::ThumbnailStage) {
+                            int64_t cost = processor.lastRenderCost() > 0 ? processor.lastRenderCost()
+                                                                          : pending.renderCost;
+                            refinements.push({item.file, Model::ThumbnailStage, false, cost});
+                        }
+                    }
+                    queueChanged.notify_all();
+                }
+            }
+        };
+
+        int threadCount = std::min(indexingThreadCount(), totalItems);
+        qDebug() << "IndexingWorker::process() indexing" << totalFiles << "files on" << threadCount << "threads";
+        std::vector<std::thread> threads;
+        for (int i = 1; i < threadCount; ++i) {
+            threads.emplace_back(processFiles);
+        }
+        processFiles();
+        for (auto& thread : threads) {
+            thread.join();
         }
+        if (m_stopRequested.load()) {
+            qDebug() << "IndexingWorker::process() stopping due to stop request";
+        }
+
+        // Make the queued writes visible to the UI before reporting completion
+        model->flushWrites();
 
         // Emit final progress signal to indicate completion
         emit progressUpdated("Processing complete", 100);
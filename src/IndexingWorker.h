@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <atomic>
+#include <vector>
 #include "Library.h"
 
 class IndexingWorker : public QObject {
@@ -21,6 +22,29 @@ signals:
     void finished();
 
 private:
+    // A file due for processing, the stages to run and the signature to
+    // record for it
+    struct PendingFile {
+        FileSignature signature;
+        int64_t size = 0;
+        int64_t mtime = 0;
+        uint64_t hash = 0;
+        unsigned int stages = Model::IndexingStages;
+        bool changed = true;  // contents differ from the recorded signature
+        int64_t renderCost = 0;  // expected full-size render time, ms
+    };
+    // One processGFile call: a file's first pass, or its full-size
+    // thumbnail queued behind every first pass
+    struct WorkItem {
+        int file;             // index into the pending files
+        unsigned int stages;
+        bool prelude;         // first item for the file: record its signature
+        int64_t cost;         // estimated ms, for shortest-job-first
+    };
+    std::vector<PendingFile> findChangedFiles(Model* model);
+    // Files processed at once, from the "indexingThreads" setting
+    static int indexingThreadCount();
+
     Library* library;
     std::atomic<bool> m_stopRequested;
     std::atomic<bool> m_reindexRequested;
@@ -14,8 +14,8 @@ namespace fs = std::filesystem;
 Library::Library(const char* _label, const char* _path)
     : shortName(_label ? _label : ""),
     fullPath(_path ? _path : ""),
-    model(new Model(_path)),
-    index(nullptr)
+    index(nullptr),
+    model(nullptr)
 {
 }
 
@@ -43,7 +43,15 @@ size_t Library::indexFiles()
 
 void Library::loadDatabase()
 {
+    getModel();
+}
 
+Model* Library::getModel()
+{
+    if (!model) {
+        model = new Model(fullPath);
+    }
+    return model;
 }
 
 std::vector<std::string> Library::getModels()
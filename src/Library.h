@@ -19,6 +19,8 @@ public:
     const char* path();
 
     void loadDatabase();
+    // Opens the library's database on first use
+    Model* getModel();
     std::vector<std::string> getModels();
     std::vector<std::string> getGeometry();
     std::vector<std::string> getImages();
@@ -27,10 +29,10 @@ public:
 
     std::string shortName;
     std::string fullPath;
-    Model* model;
 
 private:
     FilesystemIndexer* index;
+    Model* model;
 };
 
 #endif // LIBRARY_H
@@ -19,8 +19,10 @@
 #include <QMenuBar>
 #include <QLineEdit>
 #include <QLabel>
+#include <QStringList>
 #include <QFileSystemWatcher>
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -73,7 +75,7 @@ void LibraryWindow::loadFromLibrary(Library* _library) {
     ui.currentLibrary->setText(library->name());
 
     // Load models from the library
-    model = library->model;
+    model = library->getModel();
 
     // Set the source model for proxy models
     availableModelsProxyModel->setSourceModel(model);
@@ -132,6 +134,41 @@ void LibraryWindow::setMainWindow(MainWindow* mainWindow) {
 
     this->mainWindow->editMenu->addAction(reload);
     connect(reload, &QAction::triggered, this, &LibraryWindow::reloadLibrary);
+
+    regenerateThumbnails = new QAction(tr("Regenerate &Thumbnails"), this);
+    this->mainWindow->editMenu->addAction(regenerateThumbnails);
+    connect(regenerateThumbnails, &QAction::triggered, this, &LibraryWindow::regenerateAllThumbnails);
+
+    retryQuarantined = new QAction(tr("Retry &Quarantined"), this);
+    this->mainWindow->editMenu->addAction(retryQuarantined);
+    connect(retryQuarantined, &QAction::triggered, this, &LibraryWindow::retryQuarantinedFiles);
+
+    cleanCache = new QAction(tr("Clean Render &Cache"), this);
+    this->mainWindow->editMenu->addAction(cleanCache);
+    connect(cleanCache, &QAction::triggered, this, &LibraryWindow::cleanRenderCache);
+}
+
+void LibraryWindow::regenerateAllThumbnails() {
+    // Only the thumbnail stage is redone; titles and hierarchies are kept
+    model->resetStages(Model::ThumbnailStage);
+    startIndexing();
+}
+
+void LibraryWindow::retryQuarantinedFiles() {
+    // Files backed off after repeated failures are tried on the next pass
+    model->clearQuarantine();
+    startIndexing();
+}
+
+void LibraryWindow::cleanRenderCache() {
+    // Renders of contents no model in the library has any more
+    RenderCache& cache = model->renderCache();
+    size_t removed = cache.collectGarbage(model->getContentHashes());
+    QMessageBox::information(this, "Render Cache",
+                             QString("Removed %1 stale renders; %2 renders (%3 MB) remain.")
+                                 .arg(removed)
+                                 .arg(cache.entryCount())
+                                 .arg(cache.totalBytes() / (1024 * 1024)));
 }
 
 void LibraryWindow::setupModelsAndViews() {
@@ -236,6 +273,113 @@ void LibraryWindow::setupConnections() {
 }
 
 void LibraryWindow::onSearchTextChanged(const QString& text) {
+    ui.searchLineEdit->setToolTip(QString());
+
+    // "All Fields" goes through the full-text index instead of a per-row scan
+    if (ui.searchFieldComboBox->currentIndex() == 0) {
+        availableModelsProxyModel->setFilterRole(Model::IsSelectedRole);
+        availableModelsProxyModel->setFilterFixedString("0"); // Show unselected models
+
+        if (text.trimmed().isEmpty()) {
+            availableModelsProxyModel->clearModelIdFilter();
+            return;
+        }
+
+        // Listed best match first, as searchModels ranks them
+        std::vector<int> ids = model->searchModels(text.toStdString());
+        int maxId = 0;
+        for (int id : ids) {
+            maxId = std::max(maxId, id);
+        }
+        // Hits past the rows fetched so far would otherwise stay hidden
+        model->fetchThrough(maxId);
+        availableModelsProxyModel->setModelIdOrder(ids);
+        return;
+    }
+
+    // "Tags" takes a boolean tag expression, answered from the tag bitmaps
+    if (ui.searchFieldComboBox->currentText() == "Tags") {
+        availableModelsProxyModel->setFilterRole(Model::IsSelectedRole);
+        availableModelsProxyModel->setFilterFixedString("0"); // Show unselected models
+
+        // Facet counts for the current matches, so the next tag to add or
+        // exclude is visible before typing it
+        QStringList facets;
+        for (const auto& [tag, count] : model->tagFacets(text.toStdString())) {
+            if (count > 0) {
+                facets << QString("%1 (%2)").arg(QString::fromStdString(tag)).arg(count);
+            }
+        }
+        ui.searchLineEdit->setToolTip(facets.join("\n"));
+
+        if (text.trimmed().isEmpty()) {
+            availableModelsProxyModel->clearModelIdFilter();
+            return;
+        }
+
+        QSet<int> ids;
+        int maxId = 0;
+        for (int id : model->modelsMatchingTags(text.toStdString())) {
+            ids.insert(id);
+            maxId = std::max(maxId, id);
+        }
+        model->fetchThrough(maxId);
+        availableModelsProxyModel->setModelIdFilter(ids);
+        return;
+    }
+
+    // "Attributes" takes terms like "material_id=7 region_id", matched
+    // against the attributes harvested from each .g file
+    if (ui.searchFieldComboBox->currentText() == "Attributes") {
+        availableModelsProxyModel->setFilterRole(Model::IsSelectedRole);
+        availableModelsProxyModel->setFilterFixedString("0"); // Show unselected models
+
+        QStringList keys;
+        for (const auto& [key, count] : model->attributeKeys()) {
+            keys << QString("%1 (%2)").arg(QString::fromStdString(key)).arg(count);
+        }
+        ui.searchLineEdit->setToolTip(keys.join("\n"));
+
+        if (text.trimmed().isEmpty()) {
+            availableModelsProxyModel->clearModelIdFilter();
+            return;
+        }
+
+        QSet<int> ids;
+        int maxId = 0;
+        for (int id : model->modelsMatchingAttributes(text.toStdString())) {
+            ids.insert(id);
+            maxId = std::max(maxId, id);
+        }
+        model->fetchThrough(maxId);
+        availableModelsProxyModel->setModelIdFilter(ids);
+        return;
+    }
+
+    // "Geometry" takes terms like "size>1000 shader=plastic"; matches are
+    // listed in the order of the first numeric field named
+    if (ui.searchFieldComboBox->currentText() == "Geometry") {
+        availableModelsProxyModel->setFilterRole(Model::IsSelectedRole);
+        availableModelsProxyModel->setFilterFixedString("0"); // Show unselected models
+        ui.searchLineEdit->setToolTip("primitives, regions, combinations, size, width, depth, height (mm)\n"
+                                      "with < <= > >= = !=; units, type, shader, material with = !=");
+
+        if (text.trimmed().isEmpty()) {
+            availableModelsProxyModel->clearModelIdFilter();
+            return;
+        }
+
+        std::vector<int> ids = model->modelsMatchingGeometry(text.toStdString());
+        int maxId = 0;
+        for (int id : ids) {
+            maxId = std::max(maxId, id);
+        }
+        model->fetchThrough(maxId);
+        availableModelsProxyModel->setModelIdOrder(ids);
+        return;
+    }
+
+    availableModelsProxyModel->clearModelIdFilter();
     int role = ui.searchFieldComboBox->currentData().toInt();
     availableModelsProxyModel->setFilterRole(role);
     availableModelsProxyModel->setFilterCaseSensitivity(Qt::CaseInsensitive);
@@ -244,11 +388,8 @@ void LibraryWindow::onSearchTextChanged(const QString& text) {
 
 void LibraryWindow::onSearchFieldChanged(const QString& field) {
     Q_UNUSED(field);
-    // Update filter role based on selected field
-    int role = ui.searchFieldComboBox->currentData().toInt();
-    availableModelsProxyModel->setFilterRole(role);
-    // Re-apply filter
-    availableModelsProxyModel->invalidate();
+    // Re-apply the current search text against the selected field
+    onSearchTextChanged(ui.searchLineEdit->text());
 }
 
 
@@ -276,7 +417,7 @@ void LibraryWindow::onSelectedModelClicked(const QModelIndex& index) {
 }
 
 void LibraryWindow::onGenerateReportButtonClicked() {
-    if (model->getSelectedModels().empty()) {
+    if (model->countSelected() == 0) {
         QMessageBox::information(this, "Report",
                                  "No models selected for the report.");
         return;
@@ -319,6 +460,12 @@ void LibraryWindow::on_backButton_clicked() {
     if (mainWindow) {
         this->mainWindow->editMenu->removeAction(reload);
         disconnect(reload, nullptr, nullptr, nullptr);
+        this->mainWindow->editMenu->removeAction(regenerateThumbnails);
+        disconnect(regenerateThumbnails, nullptr, nullptr, nullptr);
+        this->mainWindow->editMenu->removeAction(retryQuarantined);
+        disconnect(retryQuarantined, nullptr, nullptr, nullptr);
+        this->mainWindow->editMenu->removeAction(cleanCache);
+        disconnect(cleanCache, nullptr, nullptr, nullptr);
         this->mainWindow->returnCentralWidget();
         qDebug() << "MainWindow shown";
     } else {
@@ -371,11 +518,21 @@ void LibraryWindow::onGeometryBrowserClicked(int modelId) {
 void LibraryWindow::onProgressUpdated(const QString& currentObject, int percentage) {
     ui.progressBar->setValue(percentage);
 
+    if (percentage >= 100 || !progressStatsAge.isValid() ||
+        progressStatsAge.elapsed() >= kProgressStatsInterval) {
+        CatalogStatistics stats = model->statistics();
+        progressCounts = QString("%1 of %2 included models processed")
+                             .arg(stats.includedProcessed)
+                             .arg(stats.included);
+        progressStatsAge.start();
+    }
+
     if (percentage >= 100) {
-        ui.statusLabel->setText("Processing complete");
+        ui.statusLabel->setText(QString("Processing complete (%1)").arg(progressCounts));
         ui.progressBar->setVisible(false);
+        progressStatsAge.invalidate();  // the next run starts with fresh counts
     } else {
-        ui.statusLabel->setText(QString("Processing: %1").arg(currentObject));
+        ui.statusLabel->setText(QString("Processing: %1 (%2)").arg(currentObject, progressCounts));
         ui.progressBar->setVisible(true);
     }
 }
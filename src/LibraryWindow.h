@@ -7,6 +7,7 @@
 #include <QComboBox>
 #include <QLineEdit>
 #include <QSortFilterProxyModel>
+#include <QElapsedTimer>
 #include <QThread>
 
 #include "ui_librarywindow.h"
@@ -29,6 +30,9 @@ public:
 
     void loadFromLibrary(Library* _library);
     void reloadLibrary();
+    void regenerateAllThumbnails();
+    void retryQuarantinedFiles();
+    void cleanRenderCache();
     void setMainWindow(MainWindow* mainWindow);
 
 
@@ -61,6 +65,9 @@ private:
     Library* library;
     MainWindow* mainWindow;
     QAction* reload;
+    QAction* regenerateThumbnails;
+    QAction* retryQuarantined;
+    QAction* cleanCache;
     Ui::LibraryWindow ui;
     Model* model;
 
@@ -75,6 +82,12 @@ private:
     QThread* indexingThread;
     IndexingWorker* indexingWorker;
 
+    // Catalog counts shown with indexing progress; statistics() scans the
+    // catalog, so they are refreshed at most every kProgressStatsInterval ms
+    static constexpr qint64 kProgressStatsInterval = 1000;
+    QElapsedTimer progressStatsAge;
+    QString progressCounts;
+
     FileSystemModelWithCheckboxes* fileSystemModel;
     FileSystemFilterProxyModel* fileSystemProxyModel;
 };
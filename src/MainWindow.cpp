@@ -3,6 +3,7 @@
 #include "SettingWindow.h"
 #include "MainWindow.h"
 #include "LibraryWindow.h"
+#include "QueryStatsDialog.h"
 
 #include <iostream>
 #include <QFileDialog>
@@ -62,6 +63,9 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     viewMenu->addAction(test);
     helpMenu->addAction(test);
 
+    QAction *dbStats = new QAction(tr("&Database Statistics..."),this);
+    helpMenu->addAction(dbStats);
+
 
     menuBar()->addMenu(fileMenu);
     menuBar()->addMenu(editMenu);
@@ -72,6 +76,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     settingWindow = new SettingWindow(this);
     connect(set,&QAction::triggered,this,&MainWindow::showSettingsWindow);
     connect(reset,&QAction::triggered,this,&MainWindow::resetting);
+    connect(dbStats,&QAction::triggered,this,&MainWindow::showDatabaseStatistics);
 
 
 
@@ -284,6 +289,12 @@ void MainWindow::showSettingsWindow()
     settingWindow->show();
 }
 
+void MainWindow::showDatabaseStatistics()
+{
+    QueryStatsDialog dialog(this);
+    dialog.exec();
+}
+
 void MainWindow::setPreviewFlag(bool state)
 {
     previewFlag = state;
@@ -34,6 +34,7 @@ public:
     void clearLibraries();
 
     void showSettingsWindow();
+    void showDatabaseStatistics();
     void setPreviewFlag(bool state);
     bool previewFlag = true;
     QMenu * fileMenu;
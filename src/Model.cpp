@@ -1,19 +1,130 @@
 #include "Model.h"
+#include "QueryStats.h"
 
 #include <QBuffer>
 #include <QDebug>
+#include <QFile>
 #include <QImageReader>
 #include <QImageWriter>
+#include <QMetaObject>
 #include <QPixmap>
+#include <QSettings>
+#include <QThread>
 #include <QVariant>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
 #include <set>
 #include <sstream>
 
 namespace fs = std::filesystem;
 
+namespace {
+
+// Streaming XXH64 (https://github.com/Cyan4973/xxHash), inlined so hashing
+// needs no extra dependency
+class Xxh64 {
+ public:
+  void update(const void* input, size_t length) {
+    const uint8_t* p = static_cast<const uint8_t*>(input);
+    const uint8_t* end = p + length;
+    total += length;
+
+    if (buffered + length < sizeof(buffer)) {
+      std::memcpy(buffer + buffered, p, length);
+      buffered += length;
+      return;
+    }
+    if (buffered > 0) {
+      size_t fill = sizeof(buffer) - buffered;
+      std::memcpy(buffer + buffered, p, fill);
+      stripe(buffer);
+      p += fill;
+      buffered = 0;
+    }
+    while (end - p >= 32) {
+      stripe(p);
+      p += 32;
+    }
+    buffered = static_cast<size_t>(end - p);
+    std::memcpy(buffer, p, buffered);
+  }
+
+  uint64_t digest() const {
+    uint64_t h;
+    if (total >= 32) {
+      h = rotl(v[0], 1) + rotl(v[1], 7) + rotl(v[2], 12) + rotl(v[3], 18);
+      for (uint64_t lane : v) {
+        h ^= round(0, lane);
+        h = h * P1 + P4;
+      }
+    } else {
+      h = P5;
+    }
+    h += total;
+
+    const uint8_t* p = buffer;
+    const uint8_t* end = buffer + buffered;
+    for (; end - p >= 8; p += 8) {
+      h ^= round(0, read64(p));
+      h = rotl(h, 27) * P1 + P4;
+    }
+    if (end - p >= 4) {
+      h ^= static_cast<uint64_t>(read32(p)) * P1;
+      h = rotl(h, 23) * P2 + P3;
+      p += 4;
+    }
+    for (; p < end; ++p) {
+      h ^= *p * P5;
+      h = rotl(h, 11) * P1;
+    }
+
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+  }
+
+ private:
+  static constexpr uint64_t P1 = 11400714785074694791ULL;
+  static constexpr uint64_t P2 = 14029467366897019727ULL;
+  static constexpr uint64_t P3 = 1609587929392839161ULL;
+  static constexpr uint64_t P4 = 9650029242287828579ULL;
+  static constexpr uint64_t P5 = 2870177450012600261ULL;
+
+  static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+  static uint64_t round(uint64_t acc, uint64_t input) {
+    acc += input * P2;
+    return rotl(acc, 31) * P1;
+  }
+  // The format is defined little-endian
+  static uint64_t read64(const uint8_t* p) {
+    uint64_t x = 0;
+    for (int i = 7; i >= 0; --i) x = (x << 8) | p[i];
+    return x;
+  }
+  static uint32_t read32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+  }
+
+  void stripe(const uint8_t* p) {
+    for (int i = 0; i < 4; ++i) v[i] = round(v[i], read64(p + 8 * i));
+  }
+
+  uint64_t v[4] = {P1 + P2, P2, 0, 0 - P1};
+  uint8_t buffer[32];
+  size_t buffered = 0;
+  uint64_t total = 0;
+};
+
+}  // namespace
+
 Model::Model(const std::string& libraryPath, QObject* parent)
     : QAbstractListModel(parent), db(nullptr) {
   // Create a hidden directory inside the library path
@@ -22,6 +133,10 @@ Model::Model(const std::string& libraryPath, QObject* parent)
   if (!fs::exists(hiddenDir)) {
     fs::create_directory(hiddenDir);
   }
+  QSettings settings;
+  renderCachePtr = std::make_unique<RenderCache>(
+      (hiddenDir / "render-cache").string(),
+      settings.value("renderCacheMB", 256).toULongLong() * 1024 * 1024);
 
   // Set the database path inside the hidden directory
   dbPath = (hiddenDir / "metadata.db").string();
@@ -32,13 +147,25 @@ Model::Model(const std::string& libraryPath, QObject* parent)
   } else {
     std::cout << "Opened database at " << dbPath << " successfully"
               << std::endl;
+    QueryStats::global().attach(db);
+    // WAL lets the read connections below run alongside the writer
+    executeSQL("PRAGMA journal_mode=WAL;");
+    executeSQL("PRAGMA synchronous=NORMAL;");
+    sqlite3_busy_timeout(db, 5000);
     createTables();
 
+    readPool = std::make_unique<ReadConnectionPool>(dbPath, kReadConnections);
+    writer = std::make_unique<CatalogWriter>(
+        [this]() { beginWriteBatch(); }, [this]() { commitWriteBatch(); },
+        kWriteBatchSize, kWriteBatchDelay);
+
     loadModelsFromDatabase();
   }
 }
 
 Model::~Model() {
+  writer.reset();  // commits whatever is still queued
+  readPool.reset();
   if (db) {
     sqlite3_close(db);
   }
@@ -59,7 +186,11 @@ bool Model::createTables() {
             library_name TEXT,
             is_selected INTEGER DEFAULT 0,
             is_processed INTEGER DEFAULT 0,
-            is_included INTEGER DEFAULT 0
+            is_included INTEGER DEFAULT 0,
+            file_size INTEGER,
+            file_mtime INTEGER,
+            content_hash INTEGER,
+            render_cost INTEGER
         );
     )";
 
@@ -91,55 +222,451 @@ bool Model::createTables() {
       );
   )";
 
-  return executeSQL(sqlModels) && executeSQL(sqlObjects) &&
-         executeSQL(sqlTags) && executeSQL(sqlModelTags);
+  // Packed hierarchies (see ObjectTree.h); the rowid is the model id so the
+  // blob can be opened directly with sqlite3_blob_open
+  std::string sqlObjectTrees = R"(
+        CREATE TABLE IF NOT EXISTS object_trees (
+            model_id INTEGER PRIMARY KEY,
+            tree BLOB NOT NULL
+        );
+    )";
+
+  bool created = executeSQL(sqlModels) && executeSQL(sqlObjects) &&
+                 executeSQL(sqlTags) && executeSQL(sqlModelTags) &&
+                 executeSQL(sqlObjectTrees);
+
+  // Databases created before change tracking lack the signature columns
+  created = created && addColumnIfMissing("models", "file_size", "INTEGER") &&
+            addColumnIfMissing("models", "file_mtime", "INTEGER") &&
+            addColumnIfMissing("models", "content_hash", "INTEGER") &&
+            addColumnIfMissing("models", "render_cost", "INTEGER");
+
+  created = created && createObjectClosure() && createStageTable() &&
+            createThumbnailLevelTable() && createGeometryTables() &&
+            createAttributeTable();
+
+  // The search index is optional; searchModels() falls back to LIKE
+  // when SQLite was built without FTS5
+  searchIndexAvailable = created && createSearchIndex();
+  return created;
+}
+
+bool Model::tableExists(const std::string& name) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  bool exists = false;
+  sqlite3_stmt* stmt =
+      prepareStatement("SELECT COUNT(*) FROM sqlite_master WHERE name = ?;");
+  if (stmt) {
+    sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+      exists = sqlite3_column_int(stmt, 0) > 0;
+    }
+    sqlite3_finalize(stmt);
+  }
+  return exists;
+}
+
+bool Model::createStageTable() {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  bool existed = tableExists("model_stages");
+
+  std::string sqlStages = R"(
+        CREATE TABLE IF NOT EXISTS model_stages (
+            model_id INTEGER NOT NULL,
+            stage INTEGER NOT NULL,
+            state INTEGER NOT NULL,
+            updated_at INTEGER NOT NULL,
+            error TEXT,
+            PRIMARY KEY (model_id, stage),
+            FOREIGN KEY (model_id) REFERENCES models(id) ON DELETE CASCADE
+        ) WITHOUT ROWID;
+    )";
+  if (!executeSQL(sqlStages)) return false;
+
+  // Keyed by content rather than model, see recordStageAttempt()
+  std::string sqlFailures = R"(
+        CREATE TABLE IF NOT EXISTS stage_failures (
+            content_hash INTEGER NOT NULL,
+            stage INTEGER NOT NULL,
+            attempts INTEGER NOT NULL,
+            last_attempt INTEGER NOT NULL,
+            error TEXT,
+            PRIMARY KEY (content_hash, stage)
+        ) WITHOUT ROWID;
+        CREATE INDEX IF NOT EXISTS idx_models_content_hash ON models(content_hash);
+    )";
+  if (!executeSQL(sqlFailures)) return false;
+
+  // Catalogs from before stage tracking: a processed model finished its
+  // metadata and hierarchy; only a stored thumbnail proves that stage ran
+  if (!existed) {
+    std::string sqlBackfill = R"(
+        INSERT INTO model_stages (model_id, stage, state, updated_at)
+        SELECT id, 1, 1, strftime('%s', 'now') FROM models WHERE is_processed = 1
+        UNION ALL
+        SELECT id, 2, 1, strftime('%s', 'now') FROM models WHERE is_processed = 1
+        UNION ALL
+        SELECT id, 4, 1, strftime('%s', 'now') FROM models
+        WHERE is_processed = 1 AND thumbnail IS NOT NULL;
+    )";
+    return executeSQL(sqlBackfill);
+  }
+  return true;
+}
+
+bool Model::createThumbnailLevelTable() {
+  // Levels are derived from the thumbnail column, so the triggers drop them
+  // whenever it changes; writers add the new ones afterwards. Catalogs from
+  // before levels existed simply fall back to the full thumbnail.
+  std::string sqlLevels = R"(
+        CREATE TABLE IF NOT EXISTS thumbnail_levels (
+            id INTEGER PRIMARY KEY,
+            model_id INTEGER NOT NULL,
+            size INTEGER NOT NULL,
+            image BLOB NOT NULL,
+            UNIQUE (model_id, size)
+        );
+        CREATE TRIGGER IF NOT EXISTS thumbnail_levels_au
+        AFTER UPDATE OF thumbnail ON models BEGIN
+            DELETE FROM thumbnail_levels WHERE model_id = new.id;
+        END;
+        CREATE TRIGGER IF NOT EXISTS thumbnail_levels_ad AFTER DELETE ON models BEGIN
+            DELETE FROM thumbnail_levels WHERE model_id = old.id;
+        END;
+    )";
+  return executeSQL(sqlLevels);
+}
+
+bool Model::createGeometryTables() {
+  // One row of indexed columns per model for sorting and range filters, and
+  // the per-name counts (primitive types, shaders, materials) beside it
+  std::string sqlGeometry = R"(
+        CREATE TABLE IF NOT EXISTS model_geometry (
+            model_id INTEGER PRIMARY KEY,
+            primitives INTEGER NOT NULL,
+            regions INTEGER NOT NULL,
+            combinations INTEGER NOT NULL,
+            min_x REAL, min_y REAL, min_z REAL,
+            max_x REAL, max_y REAL, max_z REAL,
+            size_x REAL, size_y REAL, size_z REAL,
+            max_size REAL,
+            units TEXT,
+            FOREIGN KEY (model_id) REFERENCES models(id) ON DELETE CASCADE
+        ) WITHOUT ROWID;
+        CREATE INDEX IF NOT EXISTS idx_model_geometry_primitives
+            ON model_geometry(primitives);
+        CREATE INDEX IF NOT EXISTS idx_model_geometry_regions
+            ON model_geometry(regions);
+        CREATE INDEX IF NOT EXISTS idx_model_geometry_max_size
+            ON model_geometry(max_size);
+        CREATE TABLE IF NOT EXISTS model_geometry_counts (
+            model_id INTEGER NOT NULL,
+            kind TEXT NOT NULL,
+            name TEXT NOT NULL,
+            count INTEGER NOT NULL,
+            PRIMARY KEY (model_id, kind, name)
+        ) WITHOUT ROWID;
+        CREATE INDEX IF NOT EXISTS idx_model_geometry_counts_name
+            ON model_geometry_counts(kind, name);
+        CREATE TRIGGER IF NOT EXISTS model_geometry_ad AFTER DELETE ON models BEGIN
+            DELETE FROM model_geometry WHERE model_id = old.id;
+            DELETE FROM model_geometry_counts WHERE model_id = old.id;
+        END;
+    )";
+  return executeSQL(sqlGeometry);
+}
+
+bool Model::createAttributeTable() {
+  // The rowid lets attributes_fts index the values as external content
+  std::string sqlAttributes = R"(
+        CREATE TABLE IF NOT EXISTS model_attributes (
+            id INTEGER PRIMARY KEY,
+            model_id INTEGER NOT NULL,
+            object TEXT NOT NULL,
+            key TEXT NOT NULL,
+            value TEXT NOT NULL,
+            UNIQUE (model_id, object, key),
+            FOREIGN KEY (model_id) REFERENCES models(id) ON DELETE CASCADE
+        );
+        CREATE INDEX IF NOT EXISTS idx_model_attributes_key_value
+            ON model_attributes(key, value);
+        CREATE TRIGGER IF NOT EXISTS model_attributes_ad AFTER DELETE ON models BEGIN
+            DELETE FROM model_attributes WHERE model_id = old.id;
+        END;
+    )";
+  return executeSQL(sqlAttributes);
+}
+
+bool Model::createObjectClosure() {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  bool existed = tableExists("object_closure");
+
+  // One row per (ancestor, descendant) pair, including each object paired
+  // with itself at depth 0, so subtree and ancestor queries are a single
+  // index range scan. The triggers keep it in step with parent_object_id.
+  std::string sqlClosure = R"(
+        CREATE TABLE IF NOT EXISTS object_closure (
+            ancestor_id INTEGER NOT NULL,
+            descendant_id INTEGER NOT NULL,
+            depth INTEGER NOT NULL,
+            PRIMARY KEY (ancestor_id, descendant_id)
+        ) WITHOUT ROWID;
+        CREATE INDEX IF NOT EXISTS idx_object_closure_descendant
+            ON object_closure (descendant_id, depth);
+        CREATE INDEX IF NOT EXISTS idx_objects_parent ON objects (parent_object_id);
+        CREATE INDEX IF NOT EXISTS idx_objects_name ON objects (name, model_id);
+
+        CREATE TRIGGER IF NOT EXISTS objects_closure_ai AFTER INSERT ON objects BEGIN
+            INSERT INTO object_closure (ancestor_id, descendant_id, depth)
+            SELECT ancestor_id, new.object_id, depth + 1 FROM object_closure
+            WHERE descendant_id = new.parent_object_id
+            UNION ALL
+            SELECT new.object_id, new.object_id, 0;
+        END;
+        CREATE TRIGGER IF NOT EXISTS objects_closure_ad AFTER DELETE ON objects BEGIN
+            DELETE FROM object_closure
+            WHERE descendant_id = old.object_id OR ancestor_id = old.object_id;
+        END;
+        CREATE TRIGGER IF NOT EXISTS objects_closure_au
+        AFTER UPDATE OF parent_object_id ON objects
+        WHEN old.parent_object_id IS NOT new.parent_object_id BEGIN
+            DELETE FROM object_closure
+            WHERE descendant_id IN (SELECT descendant_id FROM object_closure
+                                    WHERE ancestor_id = new.object_id)
+              AND ancestor_id NOT IN (SELECT descendant_id FROM object_closure
+                                      WHERE ancestor_id = new.object_id);
+            INSERT INTO object_closure (ancestor_id, descendant_id, depth)
+            SELECT p.ancestor_id, c.descendant_id, p.depth + c.depth + 1
+            FROM object_closure p, object_closure c
+            WHERE p.descendant_id = new.parent_object_id
+              AND c.ancestor_id = new.object_id;
+        END;
+    )";
+
+  if (!executeSQL(sqlClosure)) return false;
+
+  if (!existed) {
+    std::string sqlBackfill = R"(
+        INSERT INTO object_closure (ancestor_id, descendant_id, depth)
+        WITH RECURSIVE closure (ancestor_id, descendant_id, depth) AS (
+            SELECT object_id, object_id, 0 FROM objects
+            UNION ALL
+            SELECT c.ancestor_id, o.object_id, c.depth + 1
+            FROM closure c JOIN objects o ON o.parent_object_id = c.descendant_id
+        )
+        SELECT ancestor_id, descendant_id, depth FROM closure;
+    )";
+    return executeSQL(sqlBackfill);
+  }
+  return true;
+}
+
+bool Model::addColumnIfMissing(const std::string& table,
+                               const std::string& column,
+                               const std::string& type) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement("PRAGMA table_info(" + table + ");");
+  if (!stmt) return false;
+
+  bool exists = false;
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    const char* name =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    if (name && column == name) {
+      exists = true;
+      break;
+    }
+  }
+  sqlite3_finalize(stmt);
+
+  if (exists) return true;
+  return executeSQL("ALTER TABLE " + table + " ADD COLUMN " + column + " " +
+                    type + ";");
+}
+
+bool Model::createSearchIndex() {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+
+  // Remember whether the index is new so existing rows can be backfilled
+  bool existed = false;
+  sqlite3_stmt* stmt = prepareStatement(
+      "SELECT COUNT(*) FROM sqlite_master WHERE name = 'models_fts';");
+  if (stmt) {
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+      existed = sqlite3_column_int(stmt, 0) > 0;
+    }
+    sqlite3_finalize(stmt);
+  }
+
+  // models_fts rowid is the model id; the tags column is the space
+  // separated tag list, maintained by the model_tags triggers
+  std::string sqlModelsFts = R"(
+        CREATE VIRTUAL TABLE IF NOT EXISTS models_fts USING fts5(
+            short_name, title, author, file_path, tags,
+            prefix = '2 3'
+        );
+        CREATE VIRTUAL TABLE IF NOT EXISTS models_fts_vocab
+            USING fts5vocab(models_fts, 'row');
+
+        CREATE TRIGGER IF NOT EXISTS models_fts_ai AFTER INSERT ON models BEGIN
+            INSERT INTO models_fts (rowid, short_name, title, author, file_path, tags)
+            VALUES (new.id, new.short_name, new.title, new.author, new.file_path, '');
+        END;
+        CREATE TRIGGER IF NOT EXISTS models_fts_au
+        AFTER UPDATE OF short_name, title, author, file_path ON models BEGIN
+            UPDATE models_fts SET short_name = new.short_name, title = new.title,
+                author = new.author, file_path = new.file_path
+            WHERE rowid = new.id;
+        END;
+        CREATE TRIGGER IF NOT EXISTS models_fts_ad AFTER DELETE ON models BEGIN
+            DELETE FROM models_fts WHERE rowid = old.id;
+        END;
+
+        CREATE TRIGGER IF NOT EXISTS model_tags_fts_ai AFTER INSERT ON model_tags BEGIN
+            UPDATE models_fts SET tags = (
+                SELECT COALESCE(group_concat(t.name, ' '), '')
+                FROM model_tags mt JOIN tags t ON t.id = mt.tag_id
+                WHERE mt.model_id = new.model_id)
+            WHERE rowid = new.model_id;
+        END;
+        CREATE TRIGGER IF NOT EXISTS model_tags_fts_ad AFTER DELETE ON model_tags BEGIN
+            UPDATE models_fts SET tags = (
+                SELECT COALESCE(group_concat(t.name, ' '), '')
+                FROM model_tags mt JOIN tags t ON t.id = mt.tag_id
+                WHERE mt.model_id = old.model_id)
+            WHERE rowid = old.model_id;
+        END;
+    )";
+
+  // Object names are indexed per row through an external-content table so
+  // inserting one object never re-aggregates the whole hierarchy
+  std::string sqlObjectsFts = R"(
+        CREATE VIRTUAL TABLE IF NOT EXISTS objects_fts USING fts5(
+            name, content = 'objects', content_rowid = 'object_id',
+            prefix = '2 3'
+        );
+        CREATE VIRTUAL TABLE IF NOT EXISTS objects_fts_vocab
+            USING fts5vocab(objects_fts, 'row');
+
+        CREATE TRIGGER IF NOT EXISTS objects_fts_ai AFTER INSERT ON objects BEGIN
+            INSERT INTO objects_fts (rowid, name) VALUES (new.object_id, new.name);
+        END;
+        CREATE TRIGGER IF NOT EXISTS objects_fts_ad AFTER DELETE ON objects BEGIN
+            INSERT INTO objects_fts (objects_fts, rowid, name)
+            VALUES ('delete', old.object_id, old.name);
+        END;
+        CREATE TRIGGER IF NOT EXISTS objects_fts_au AFTER UPDATE OF name ON objects BEGIN
+            INSERT INTO objects_fts (objects_fts, rowid, name)
+            VALUES ('delete', old.object_id, old.name);
+            INSERT INTO objects_fts (rowid, name) VALUES (new.object_id, new.name);
+        END;
+    )";
+
+  // Attribute keys and values, indexed the same way as object names
+  std::string sqlAttributesFts = R"(
+        CREATE VIRTUAL TABLE IF NOT EXISTS attributes_fts USING fts5(
+            key, value, content = 'model_attributes', content_rowid = 'id',
+            prefix = '2 3'
+        );
+        CREATE VIRTUAL TABLE IF NOT EXISTS attributes_fts_vocab
+            USING fts5vocab(attributes_fts, 'row');
+
+        CREATE TRIGGER IF NOT EXISTS attributes_fts_ai AFTER INSERT ON model_attributes BEGIN
+            INSERT INTO attributes_fts (rowid, key, value)
+            VALUES (new.id, new.key, new.value);
+        END;
+        CREATE TRIGGER IF NOT EXISTS attributes_fts_ad AFTER DELETE ON model_attributes BEGIN
+            INSERT INTO attributes_fts (attributes_fts, rowid, key, value)
+            VALUES ('delete', old.id, old.key, old.value);
+        END;
+        CREATE TRIGGER IF NOT EXISTS attributes_fts_au
+        AFTER UPDATE OF key, value ON model_attributes BEGIN
+            INSERT INTO attributes_fts (attributes_fts, rowid, key, value)
+            VALUES ('delete', old.id, old.key, old.value);
+            INSERT INTO attributes_fts (rowid, key, value)
+            VALUES (new.id, new.key, new.value);
+        END;
+    )";
+
+  if (!executeSQL(sqlModelsFts) || !executeSQL(sqlObjectsFts) ||
+      !executeSQL(sqlAttributesFts)) {
+    std::cerr << "Full-text search index unavailable, falling back to LIKE"
+              << std::endl;
+    return false;
+  }
+
+  if (!existed) {
+    std::string sqlBackfill = R"(
+        INSERT INTO models_fts (rowid, short_name, title, author, file_path, tags)
+        SELECT m.id, m.short_name, m.title, m.author, m.file_path,
+               (SELECT COALESCE(group_concat(t.name, ' '), '')
+                FROM model_tags mt JOIN tags t ON t.id = mt.tag_id
+                WHERE mt.model_id = m.id)
+        FROM models m;
+        INSERT INTO objects_fts (objects_fts) VALUES ('rebuild');
+        INSERT INTO attributes_fts (attributes_fts) VALUES ('rebuild');
+    )";
+    return executeSQL(sqlBackfill);
+  }
+  return true;
 }
 
 int Model::rowCount(const QModelIndex& parent) const {
   Q_UNUSED(parent);
-  return static_cast<int>(models.size());
+  return static_cast<int>(rows.size());
 }
 
 QVariant Model::data(const QModelIndex& index, int role) const {
   if (!index.isValid() || index.row() < 0 ||
-      index.row() >= static_cast<int>(models.size()))
+      index.row() >= static_cast<int>(rows.size()))
     return QVariant();
 
-  const ModelData& modelData = models.at(static_cast<size_t>(index.row()));
+  const RowKey& key = rows[static_cast<size_t>(index.row())];
+
+  // Answered from the row key without touching the database
+  switch (role) {
+    case IdRole:
+      return key.id;
+    case IsSelectedRole:
+      return key.is_selected;
+    case IsIncludedRole:
+      return key.is_included;
+    case IsProcessedRole:
+      return key.is_processed;
+    case ThumbnailRole: {
+      // Decoded once per row rather than on every repaint
+      if (const QPixmap* cached = thumbnailCache.object(key.id)) {
+        return *cached;
+      }
+      QImage thumbnail =
+          readThumbnail(key.id, QSize(kListThumbnailSize, kListThumbnailSize));
+      if (thumbnail.isNull()) return QVariant();
+      QPixmap pixmap = QPixmap::fromImage(thumbnail);
+      thumbnailCache.insert(key.id, new QPixmap(pixmap));
+      return pixmap;
+    }
+    default:
+      break;
+  }
+
+  ModelData modelData = cachedRow(key.id);
 
   switch (role) {
     case Qt::DisplayRole:
     case ShortNameRole:
       return QString::fromStdString(modelData.short_name);
-    case IdRole:
-      return modelData.id;
     case PrimaryFileRole:
       return QString::fromStdString(modelData.primary_file);
     case OverrideInfoRole:
       return QString::fromStdString(modelData.override_info);
     case TitleRole:
       return QString::fromStdString(modelData.title);
-    case ThumbnailRole:
-      if (!modelData.thumbnail.empty()) {
-        QPixmap thumbnail;
-        thumbnail.loadFromData(
-            reinterpret_cast<const uchar*>(modelData.thumbnail.data()),
-            static_cast<uint>(modelData.thumbnail.size()), "PNG");
-        return thumbnail;
-      }
-      return QVariant();
     case AuthorRole:
       return QString::fromStdString(modelData.author);
     case FilePathRole:
       return QString::fromStdString(modelData.file_path);
     case LibraryNameRole:
       return QString::fromStdString(modelData.library_name);
-    case IsSelectedRole:
-      return modelData.is_selected;
-    case IsIncludedRole:
-      return modelData.is_included;
-    case IsProcessedRole:
-      return modelData.is_processed;
     default:
       return QVariant();
   }
@@ -162,6 +689,104 @@ QHash<int, QByteArray> Model::roleNames() const {
   return roles;
 }
 
+bool Model::canFetchMore(const QModelIndex& parent) const {
+  return !parent.isValid() && moreRows;
+}
+
+void Model::fetchMore(const QModelIndex& parent) {
+  if (parent.isValid()) return;
+  fetchRows(kFetchBatchSize);
+}
+
+void Model::fetchThrough(int id) {
+  while (moreRows && lastFetchedId < id) {
+    if (fetchRows(kFetchBatchSize) == 0) break;
+  }
+}
+
+size_t Model::fetchRows(size_t count) {
+  if (!moreRows || count == 0) return 0;
+
+  // Keyset pagination: seek past the last fetched id instead of OFFSET, so
+  // every page costs the same however deep the view has scrolled
+  std::string sql = R"(
+        SELECT id, is_selected, is_processed, is_included
+        FROM models WHERE id > ? ORDER BY id LIMIT ?;
+    )";
+  std::vector<RowKey> page;
+  page.reserve(count);
+  {
+    ReadLease reader = acquireReader();
+    sqlite3* conn = reader.get();
+    sqlite3_stmt* stmt = prepareStatement(conn, sql);
+    if (!stmt) return 0;
+    sqlite3_bind_int(stmt, 1, lastFetchedId);
+    sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(count));
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      page.push_back({sqlite3_column_int(stmt, 0),
+                      sqlite3_column_int(stmt, 1) != 0,
+                      sqlite3_column_int(stmt, 2) != 0,
+                      sqlite3_column_int(stmt, 3) != 0});
+    }
+    sqlite3_finalize(stmt);
+  }
+
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  moreRows = page.size() == count;
+  if (page.empty()) return 0;
+
+  int first = static_cast<int>(rows.size());
+  beginInsertRows(QModelIndex(), first, first + static_cast<int>(page.size()) - 1);
+  for (const RowKey& key : page) {
+    rowById[key.id] = rows.size();
+    rows.push_back(key);
+  }
+  lastFetchedId = page.back().id;
+  endInsertRows();
+  return page.size();
+}
+
+ModelData Model::cachedRow(int id) const {
+  uint64_t generation;
+  {
+    std::lock_guard<std::mutex> cacheLock(rowCacheMutex);
+    auto it = rowCacheIndex.find(id);
+    if (it != rowCacheIndex.end()) {
+      rowCache.splice(rowCache.begin(), rowCache, it->second);
+      return rowCache.front();
+    }
+    generation = rowCacheGeneration;
+  }
+
+  // Read without rowCacheMutex: it is a leaf lock, never held while
+  // waiting for a reader lease or db_mutex
+  ModelData modelData = readModel(id, false);
+  modelData.id = id;  // keep the LRU key valid even if the row vanished
+
+  std::lock_guard<std::mutex> cacheLock(rowCacheMutex);
+  // An eviction since the read may mean it is already stale
+  if (generation != rowCacheGeneration || rowCacheIndex.count(id)) {
+    return modelData;
+  }
+  rowCache.push_front(modelData);
+  rowCacheIndex[id] = rowCache.begin();
+  if (rowCache.size() > kRowCacheSize) {
+    rowCacheIndex.erase(rowCache.back().id);
+    rowCache.pop_back();
+  }
+  return modelData;
+}
+
+void Model::evictCachedRow(int id) {
+  std::lock_guard<std::mutex> cacheLock(rowCacheMutex);
+  ++rowCacheGeneration;
+  auto it = rowCacheIndex.find(id);
+  if (it != rowCacheIndex.end()) {
+    rowCache.erase(it->second);
+    rowCacheIndex.erase(it);
+  }
+}
+
 bool Model::insertModel(const ModelData& modelData) {
   std::string sql = R"(
         INSERT INTO models
@@ -228,14 +853,19 @@ bool Model::insertModel(const ModelData& modelData) {
     }
     int id = static_cast<int>(sqlite3_last_insert_rowid(db));
     sqlite3_finalize(stmt);
-
-    ModelData modelDataWithId = modelData;
-    modelDataWithId.id = id;
-    modelDataWithId.short_name = short_name;
-
-    beginInsertRows(QModelIndex(), models.size(), models.size());
-    models.push_back(modelDataWithId);
-    endInsertRows();
+    tagIndexChanged(id, [this, id]() { tagIndex.addModel(id); });
+
+    // Ids only grow, so the new row belongs at the end; if pages are still
+    // pending it arrives with the last one instead
+    if (!moreRows) {
+      int row = static_cast<int>(rows.size());
+      beginInsertRows(QModelIndex(), row, row);
+      rowById[id] = rows.size();
+      rows.push_back({id, modelData.is_selected, modelData.is_processed,
+                      modelData.is_included});
+      lastFetchedId = id;
+      endInsertRows();
+    }
 
     qDebug() << "Model inserted successfully with id:" << id
              << ", short_name:" << QString::fromStdString(short_name);
@@ -248,14 +878,16 @@ bool Model::insertModel(const ModelData& modelData) {
   }
 }
 
-bool Model::shortNameExists(const std::string& short_name) {
-  std::string sql = "SELECT COUNT(*) FROM models WHERE short_name = ?;";
+bool Model::shortNameExists(const std::string& short_name, int excludeId) {
+  std::string sql =
+      "SELECT COUNT(*) FROM models WHERE short_name = ? AND id != ?;";
   sqlite3_stmt* stmt;
   int count = 0;
   std::lock_guard<std::recursive_mutex> lock(db_mutex);
 
   if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
     sqlite3_bind_text(stmt, 1, short_name.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, excludeId);
 
     if (sqlite3_step(stmt) == SQLITE_ROW) {
       count = sqlite3_column_int(stmt, 0);
@@ -271,8 +903,9 @@ bool Model::shortNameExists(const std::string& short_name) {
   return count > 0;
 }
 
-bool Model::filePathExists(const std::string& file_path) {
-  std::string sql = "SELECT COUNT(*) FROM models WHERE file_path = ?;";
+bool Model::filePathExists(const std::string& file_path, int excludeId) {
+  std::string sql =
+      "SELECT COUNT(*) FROM models WHERE file_path = ? AND id != ?;";
   sqlite3_stmt* stmt;
   int count = 0;
   std::lock_guard<std::recursive_mutex> lock(db_mutex);
@@ -282,6 +915,7 @@ bool Model::filePathExists(const std::string& file_path) {
 
   if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
     sqlite3_bind_text(stmt, 1, file_path.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, excludeId);
 
     if (sqlite3_step(stmt) == SQLITE_ROW) {
       count = sqlite3_column_int(stmt, 0);
@@ -298,117 +932,210 @@ bool Model::filePathExists(const std::string& file_path) {
 }
 
 bool Model::updateModel(int id, const ModelData& modelData) {
-  std::string sql = R"(
-        UPDATE models SET
-            short_name = ?,
-            primary_file = ?,
-            override_info = ?,
-            title = ?,
-            thumbnail = ?,
-            author = ?,
-            file_path = ?,
-            library_name = ?,
-            is_selected = ?,
-            is_processed = ?,
-            is_included = ?
-        WHERE id = ?;
-    )";
-
-  // Remove existing tags for the model
-  std::string sqlDeleteTags = "DELETE FROM model_tags WHERE model_id = ?;";
-  sqlite3_stmt* deleteStmt;
-  if (sqlite3_prepare_v2(db, sqlDeleteTags.c_str(), -1, &deleteStmt, nullptr) ==
-      SQLITE_OK) {
-    sqlite3_bind_int(deleteStmt, 1, id);
-    if (sqlite3_step(deleteStmt) != SQLITE_DONE) {
-      std::cerr << "Failed to delete existing tags: " << sqlite3_errmsg(db)
-                << std::endl;
-    }
-    sqlite3_finalize(deleteStmt);
-  } else {
-    std::cerr << "SQL error in delete existing tags: " << sqlite3_errmsg(db)
-              << std::endl;
-  }
-
-  // Insert new tags for the model
-  for (const auto& tag : modelData.tags) {
-    addTagToModel(id, tag);
-  }
+  return updateModelFields(id, modelData, AllFields);
+}
 
-  sqlite3_stmt* stmt;
+namespace {
+// Column and role backing each scalar bit of Model::ModelField, in the
+// order they are bound in updateModelFields()
+struct FieldColumn {
+  unsigned int field;
+  const char* column;
+  int role;
+};
+
+const FieldColumn kFieldColumns[] = {
+    {Model::ShortNameField, "short_name", Model::ShortNameRole},
+    {Model::PrimaryFileField, "primary_file", Model::PrimaryFileRole},
+    {Model::OverrideInfoField, "override_info", Model::OverrideInfoRole},
+    {Model::TitleField, "title", Model::TitleRole},
+    {Model::ThumbnailField, "thumbnail", Model::ThumbnailRole},
+    {Model::AuthorField, "author", Model::AuthorRole},
+    {Model::FilePathField, "file_path", Model::FilePathRole},
+    {Model::LibraryNameField, "library_name", Model::LibraryNameRole},
+    {Model::IsSelectedField, "is_selected", Model::IsSelectedRole},
+    {Model::IsProcessedField, "is_processed", Model::IsProcessedRole},
+    {Model::IsIncludedField, "is_included", Model::IsIncludedRole},
+};
+}  // namespace
+
+bool Model::updateModelFields(int id, const ModelData& modelData,
+                              unsigned int fields) {
   std::lock_guard<std::recursive_mutex> lock(db_mutex);
 
-  // Ensure short_name is unique if it's changed
+  // Ensure short_name is unique among the other models if it's changing
   std::string short_name = modelData.short_name;
-  int suffix = 1;
-  while (shortNameExists(short_name) &&
-         getModelById(id).short_name != short_name) {
-    short_name = modelData.short_name + "_" + std::to_string(suffix++);
+  if (fields & ShortNameField) {
+    int suffix = 1;
+    while (shortNameExists(short_name, id)) {
+      short_name = modelData.short_name + "_" + std::to_string(suffix++);
+    }
   }
 
-  // Ensure file_path is unique if it's changed
-  if (filePathExists(modelData.file_path) &&
-      getModelById(id).file_path != modelData.file_path) {
+  // Ensure file_path is unique if it's changing
+  if ((fields & FilePathField) && filePathExists(modelData.file_path, id)) {
     std::cerr << "Another model with file_path " << modelData.file_path
               << " already exists." << std::endl;
     return false;
   }
 
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-    sqlite3_bind_text(stmt, 1, short_name.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, modelData.primary_file.c_str(), -1,
-                      SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 3, modelData.override_info.c_str(), -1,
-                      SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 4, modelData.title.c_str(), -1, SQLITE_STATIC);
+  // Build an UPDATE covering only the requested columns
+  std::string sql = "UPDATE models SET ";
+  int columnCount = 0;
+  for (const auto& fc : kFieldColumns) {
+    if (fields & fc.field) {
+      if (columnCount++ > 0) sql += ", ";
+      sql += std::string(fc.column) + " = ?";
+    }
+  }
+  sql += " WHERE id = ?;";
 
-    if (!modelData.thumbnail.empty()) {
-      sqlite3_bind_blob(stmt, 5, modelData.thumbnail.data(),
-                        static_cast<int>(modelData.thumbnail.size()),
-                        SQLITE_STATIC);
-    } else {
-      sqlite3_bind_null(stmt, 5);
+  if (fields & TagsField) {
+    executeSQL("SAVEPOINT update_model_fields;");
+    enterTransaction();
+  }
+
+  if (columnCount > 0) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+      std::cerr << "SQL error in updateModelFields: " << sqlite3_errmsg(db)
+                << std::endl;
+      if (fields & TagsField) {
+        executeSQL("ROLLBACK TO update_model_fields;");
+        executeSQL("RELEASE update_model_fields;");
+        leaveTransaction();
+      }
+      return false;
     }
 
-    sqlite3_bind_text(stmt, 6, modelData.author.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 7, modelData.file_path.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 8, modelData.library_name.c_str(), -1,
-                      SQLITE_STATIC);
-    sqlite3_bind_int(stmt, 9, modelData.is_selected ? 1 : 0);
-    sqlite3_bind_int(stmt, 10, modelData.is_processed ? 1 : 0);
-    sqlite3_bind_int(stmt, 11, modelData.is_included ? 1 : 0);
-    sqlite3_bind_int(stmt, 12, id);
+    int param = 1;
+    for (const auto& fc : kFieldColumns) {
+      if (!(fields & fc.field)) continue;
+
+      switch (fc.field) {
+        case ShortNameField:
+          sqlite3_bind_text(stmt, param, short_name.c_str(), -1, SQLITE_STATIC);
+          break;
+        case PrimaryFileField:
+          sqlite3_bind_text(stmt, param, modelData.primary_file.c_str(), -1,
+                            SQLITE_STATIC);
+          break;
+        case OverrideInfoField:
+          sqlite3_bind_text(stmt, param, modelData.override_info.c_str(), -1,
+                            SQLITE_STATIC);
+          break;
+        case TitleField:
+          sqlite3_bind_text(stmt, param, modelData.title.c_str(), -1,
+                            SQLITE_STATIC);
+          break;
+        case ThumbnailField:
+          if (!modelData.thumbnail.empty()) {
+            sqlite3_bind_blob(stmt, param, modelData.thumbnail.data(),
+                              static_cast<int>(modelData.thumbnail.size()),
+                              SQLITE_STATIC);
+          } else {
+            sqlite3_bind_null(stmt, param);
+          }
+          break;
+        case AuthorField:
+          sqlite3_bind_text(stmt, param, modelData.author.c_str(), -1,
+                            SQLITE_STATIC);
+          break;
+        case FilePathField:
+          sqlite3_bind_text(stmt, param, modelData.file_path.c_str(), -1,
+                            SQLITE_STATIC);
+          break;
+        case LibraryNameField:
+          sqlite3_bind_text(stmt, param, modelData.library_name.c_str(), -1,
+                            SQLITE_STATIC);
+          break;
+        case IsSelectedField:
+          sqlite3_bind_int(stmt, param, modelData.is_selected ? 1 : 0);
+          break;
+        case IsProcessedField:
+          sqlite3_bind_int(stmt, param, modelData.is_processed ? 1 : 0);
+          break;
+        case IsIncludedField:
+          sqlite3_bind_int(stmt, param, modelData.is_included ? 1 : 0);
+          break;
+      }
+      ++param;
+    }
+    sqlite3_bind_int(stmt, param, id);
 
     int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
     if (rc != SQLITE_DONE) {
       std::cerr << "Update model failed: " << sqlite3_errmsg(db) << std::endl;
-      sqlite3_finalize(stmt);
+      if (fields & TagsField) {
+        executeSQL("ROLLBACK TO update_model_fields;");
+        executeSQL("RELEASE update_model_fields;");
+        leaveTransaction();
+      }
       return false;
     }
-    sqlite3_finalize(stmt);
+  }
 
-    // Update the models vector
-    for (int row = 0; row < static_cast<int>(models.size()); ++row) {
-      if (models[row].id == id) {
-        models[row] = modelData;
-        models[row].short_name = short_name;
-        QModelIndex modelIndex = index(row);
-        emit dataChanged(modelIndex, modelIndex);
-        break;
-      }
+  if (fields & TagsField) {
+    if (!syncTagsForModel(id, modelData.tags)) {
+      executeSQL("ROLLBACK TO update_model_fields;");
+      executeSQL("RELEASE update_model_fields;");
+      leaveTransaction();
+      return false;
     }
+    executeSQL("RELEASE update_model_fields;");
+    leaveTransaction();
+  }
 
-    return true;
-  } else {
-    std::cerr << "SQL error in updateModel: " << sqlite3_errmsg(db)
-              << std::endl;
-    return false;
+  // Patch the row key in place; the materialized row is re-read on demand
+  evictCachedRow(id);
+  QList<int> roles;
+  for (const auto& fc : kFieldColumns) {
+    if (fields & fc.field) roles.append(fc.role);
+  }
+  bool selected = modelData.is_selected;
+  bool processed = modelData.is_processed;
+  bool included = modelData.is_included;
+  runOnModelThread([this, id, fields, roles, selected, processed, included]() {
+    auto it = rowById.find(id);
+    if (it == rowById.end()) return;
+    RowKey& key = rows[it->second];
+    if (fields & IsSelectedField) key.is_selected = selected;
+    if (fields & IsProcessedField) key.is_processed = processed;
+    if (fields & IsIncludedField) key.is_included = included;
+    if (fields & ThumbnailField) thumbnailCache.remove(id);
+
+    if (!roles.isEmpty()) {
+      QModelIndex modelIndex = index(static_cast<int>(it->second));
+      emit dataChanged(modelIndex, modelIndex, roles);
+    }
+  });
+
+  return true;
+}
+
+bool Model::syncTagsForModel(int modelId,
+                             const std::vector<std::string>& tags) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+
+  std::set<std::string> wanted(tags.begin(), tags.end());
+  std::set<std::string> current;
+  for (const auto& tag : getTagsForModel(modelId)) {
+    current.insert(tag);
+  }
+
+  for (const auto& tag : current) {
+    if (!wanted.count(tag) && !removeTagFromModel(modelId, tag)) return false;
+  }
+  for (const auto& tag : wanted) {
+    if (!current.count(tag) && !addTagToModel(modelId, tag)) return false;
   }
+  return true;
 }
 
 bool Model::deleteModel(int id) {
-  // First, delete associated objects
-  if (!deleteObjectsForModel(id)) {
+  // First, delete associated objects and the stage history
+  if (!deleteObjectsForModel(id) || !resetStages(IndexingStages | GistStage, id)) {
     return false;
   }
 
@@ -425,15 +1152,18 @@ bool Model::deleteModel(int id) {
       return false;
     }
     sqlite3_finalize(stmt);
-
-    // Remove from models vector
-    for (int row = 0; row < static_cast<int>(models.size()); ++row) {
-      if (models[row].id == id) {
-        beginRemoveRows(QModelIndex(), row, row);
-        models.erase(models.begin() + row);
-        endRemoveRows();
-        break;
-      }
+    tagIndexChanged(id, [this, id]() { tagIndex.removeModel(id); });
+
+    // Remove the loaded row, if it was fetched
+    evictCachedRow(id);
+    thumbnailCache.remove(id);
+    auto it = rowById.find(id);
+    if (it != rowById.end()) {
+      int row = static_cast<int>(it->second);
+      beginRemoveRows(QModelIndex(), row, row);
+      rows.erase(rows.begin() + row);
+      rebuildRowIndex();
+      endRemoveRows();
     }
 
     return true;
@@ -448,9 +1178,10 @@ bool Model::modelExists(int id) {
   std::string sql = "SELECT COUNT(*) FROM models WHERE id = ?;";
   sqlite3_stmt* stmt;
   int count = 0;
-  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
 
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+  if (sqlite3_prepare_v2(conn, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
     sqlite3_bind_int(stmt, 1, id);
 
     if (sqlite3_step(stmt) == SQLITE_ROW) {
@@ -458,55 +1189,75 @@ bool Model::modelExists(int id) {
     }
     sqlite3_finalize(stmt);
   } else {
-    std::cerr << "SQL error in modelExists: " << sqlite3_errmsg(db)
+    std::cerr << "SQL error in modelExists: " << sqlite3_errmsg(conn)
               << std::endl;
   }
 
   return count > 0;
 }
 
-ModelData Model::getModelById(int id) {
-  std::string sql = R"(
-        SELECT id, short_name, primary_file, override_info, title, thumbnail, author, file_path, library_name, is_selected, is_processed, is_included
-        FROM models WHERE id = ?;
-    )";
+ModelData Model::getModelById(int id) const {
+  return readModel(id, true);
+}
+
+namespace {
+
+// The columns readModel() and getSelectedModels() select, in the order
+// readModelRow() expects them
+std::string modelColumns(bool withThumbnail) {
+  return std::string("id, short_name, primary_file, override_info, title, ") +
+         (withThumbnail ? "thumbnail" : "NULL") +
+         ", author, file_path, library_name, is_selected, is_processed,"
+         " is_included";
+}
+
+ModelData readModelRow(sqlite3_stmt* stmt) {
+  auto text = [stmt](int column) {
+    const char* value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+    return std::string(value ? value : "");
+  };
+  ModelData model;
+  model.id = sqlite3_column_int(stmt, 0);
+  model.short_name = text(1);
+  model.primary_file = text(2);
+  model.override_info = text(3);
+  model.title = text(4);
+
+  const void* blob = sqlite3_column_blob(stmt, 5);
+  int blob_size = sqlite3_column_bytes(stmt, 5);
+  if (blob && blob_size > 0) {
+    model.thumbnail.assign(static_cast<const char*>(blob),
+                           static_cast<const char*>(blob) + blob_size);
+  }
+
+  model.author = text(6);
+  model.file_path = text(7);
+  model.library_name = text(8);
+  model.is_selected = sqlite3_column_int(stmt, 9) != 0;
+  model.is_processed = sqlite3_column_int(stmt, 10) != 0;
+  model.is_included = sqlite3_column_int(stmt, 11) != 0;
+  return model;
+}
+
+}  // namespace
+
+ModelData Model::readModel(int id, bool withThumbnail) const {
+  std::string sql = "SELECT " + modelColumns(withThumbnail) +
+                    " FROM models WHERE id = ?;";
   sqlite3_stmt* stmt;
   ModelData model;
-  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
 
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+  if (sqlite3_prepare_v2(conn, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
     sqlite3_bind_int(stmt, 1, id);
     if (sqlite3_step(stmt) == SQLITE_ROW) {
-      model.id = sqlite3_column_int(stmt, 0);
-      model.short_name =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-      model.primary_file =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-      model.override_info =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-      model.title = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-
-      const void* blob = sqlite3_column_blob(stmt, 5);
-      int blob_size = sqlite3_column_bytes(stmt, 5);
-      if (blob && blob_size > 0) {
-        model.thumbnail.assign(static_cast<const char*>(blob),
-                               static_cast<const char*>(blob) + blob_size);
-      }
-
-      model.author =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
-      model.file_path =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7));
-      model.library_name =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
-      model.is_selected = sqlite3_column_int(stmt, 9) != 0;
-      model.is_processed = sqlite3_column_int(stmt, 10) != 0;
-      model.is_included = sqlite3_column_int(stmt, 11) != 0;
-    }
-    sqlite3_finalize(stmt);
-  } else {
-    std::cerr << "Failed to select model: " << sqlite3_errmsg(db) << std::endl;
-  }
+      model = readModelRow(stmt);
+    }
+    sqlite3_finalize(stmt);
+  } else {
+    std::cerr << "Failed to select model: " << sqlite3_errmsg(conn) << std::endl;
+  }
 
   return model;
 }
@@ -520,9 +1271,10 @@ ModelData Model::getModelByFilePath(const std::string& filePath) {
         FROM models WHERE file_path = ?;
     )";
   sqlite3_stmt* stmt;
-  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
 
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+  if (sqlite3_prepare_v2(conn, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
     // Use SQLITE_TRANSIENT to ensure SQLite makes its own copy of the data
     sqlite3_bind_text(stmt, 1, filePath.c_str(), -1, SQLITE_TRANSIENT);
 
@@ -578,7 +1330,7 @@ ModelData Model::getModelByFilePath(const std::string& filePath) {
 
     sqlite3_finalize(stmt);
   } else {
-    std::cerr << "Failed to select model by file path: " << sqlite3_errmsg(db)
+    std::cerr << "Failed to select model by file path: " << sqlite3_errmsg(conn)
               << std::endl;
   }
 
@@ -586,78 +1338,304 @@ ModelData Model::getModelByFilePath(const std::string& filePath) {
 }
 
 void Model::loadModelsFromDatabase() {
-  std::vector<ModelData> loadedModels;
+  // Refetch as many rows as were loaded, so views keep their scroll position
+  size_t loaded = 0;
+  {
+    std::lock_guard<std::recursive_mutex> lock(db_mutex);
+    loaded = rows.size();
+    beginResetModel();
+    rows.clear();
+    rowById.clear();
+    lastFetchedId = 0;
+    moreRows = true;
+    {
+      std::lock_guard<std::mutex> cacheLock(rowCacheMutex);
+      ++rowCacheGeneration;
+      rowCache.clear();
+      rowCacheIndex.clear();
+    }
+    thumbnailCache.clear();
+    endResetModel();
+  }
+  rebuildTagIndex();
+  fetchRows(std::max(loaded, kFetchBatchSize));
+}
+
+void Model::rebuildRowIndex() {
+  rowById.clear();
+  rowById.reserve(rows.size());
+  for (size_t row = 0; row < rows.size(); ++row) {
+    rowById[rows[row].id] = row;
+  }
+}
+
+uint64_t Model::hashModel(const std::string& modelDir) {
+  QFile file(QString::fromStdString(modelDir));
+  if (!file.open(QIODevice::ReadOnly)) {
+    std::cerr << "Could not open file for hashing: " << modelDir << std::endl;
+    return 0;
+  }
+
+  // Map a window at a time so huge databases never have to be resident
+  const qint64 window = qint64(64) << 20;
+  const qint64 size = file.size();
+  Xxh64 hasher;
+  for (qint64 offset = 0; offset < size; offset += window) {
+    qint64 length = std::min(window, size - offset);
+    uchar* mapped = file.map(offset, length);
+    if (mapped) {
+      hasher.update(mapped, static_cast<size_t>(length));
+      file.unmap(mapped);
+      continue;
+    }
+
+    // Some filesystems cannot be mapped; stream the window instead
+    std::vector<char> buffer(1 << 20);
+    file.seek(offset);
+    qint64 remaining = length;
+    while (remaining > 0) {
+      qint64 got = file.read(buffer.data(),
+                             std::min<qint64>(remaining, buffer.size()));
+      if (got <= 0) {
+        std::cerr << "Read failed while hashing: " << modelDir << std::endl;
+        return 0;
+      }
+      hasher.update(buffer.data(), static_cast<size_t>(got));
+      remaining -= got;
+    }
+  }
+
+  uint64_t hash = hasher.digest();
+  return hash == 0 ? 1 : hash;  // 0 is reserved for "could not hash"
+}
+
+std::vector<FileSignature> Model::getIncludedFileSignatures() {
+  std::vector<FileSignature> signatures;
   std::string sql = R"(
-        SELECT id, short_name, primary_file, override_info, title, thumbnail, author, file_path, library_name, is_selected, is_processed, is_included
-        FROM models;
+        SELECT id, file_path, is_processed, file_size, file_mtime, content_hash,
+               render_cost,
+               (SELECT COALESCE(SUM(s.stage), 0) FROM model_stages s
+                WHERE s.model_id = models.id AND s.state = 1)
+        FROM models
+        WHERE is_included = 1;
+    )";
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
+  sqlite3_stmt* stmt = prepareStatement(conn, sql);
+  if (!stmt) return signatures;
+
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    FileSignature signature;
+    signature.model_id = sqlite3_column_int(stmt, 0);
+    const char* path =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    signature.file_path = path ? path : "";
+    signature.is_processed = sqlite3_column_int(stmt, 2) != 0;
+    // NULL columns read as 0, which never matches a real signature
+    signature.size = sqlite3_column_int64(stmt, 3);
+    signature.mtime = sqlite3_column_int64(stmt, 4);
+    signature.hash = static_cast<uint64_t>(sqlite3_column_int64(stmt, 5));
+    signature.render_cost = sqlite3_column_int64(stmt, 6);
+    signature.stages_done = static_cast<unsigned int>(sqlite3_column_int(stmt, 7));
+    signatures.push_back(signature);
+  }
+  sqlite3_finalize(stmt);
+  return signatures;
+}
+
+bool Model::setFileSignature(int modelId, int64_t size, int64_t mtime,
+                             uint64_t hash) {
+  std::string sql = R"(
+        UPDATE models SET file_size = ?, file_mtime = ?, content_hash = ?
+        WHERE id = ?;
     )";
-  sqlite3_stmt* stmt;
   std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement(sql);
+  if (!stmt) return false;
 
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-      ModelData model;
-      model.id = sqlite3_column_int(stmt, 0);
-      model.short_name =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-      model.primary_file =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-      model.override_info =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-      model.title = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+  sqlite3_bind_int64(stmt, 1, size);
+  sqlite3_bind_int64(stmt, 2, mtime);
+  // SQLite integers are signed; the hash round-trips through the same bits
+  sqlite3_bind_int64(stmt, 3, static_cast<sqlite3_int64>(hash));
+  sqlite3_bind_int(stmt, 4, modelId);
+  return executePreparedStatement(stmt);
+}
 
-      const void* blob = sqlite3_column_blob(stmt, 5);
-      int blob_size = sqlite3_column_bytes(stmt, 5);
-      if (blob && blob_size > 0) {
-        model.thumbnail.assign(static_cast<const char*>(blob),
-                               static_cast<const char*>(blob) + blob_size);
-      }
+int64_t Model::getRenderCost(int modelId) {
+  std::string sql = "SELECT render_cost FROM models WHERE id = ?;";
+  ReadLease reader = acquireReader();
+  sqlite3_stmt* stmt = prepareStatement(reader.get(), sql);
+  if (!stmt) return 0;
 
-      model.author =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
-      model.file_path =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7));
-      model.library_name =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
-      model.is_selected = sqlite3_column_int(stmt, 9) != 0;
-      model.is_processed = sqlite3_column_int(stmt, 10) != 0;
-      model.is_included = sqlite3_column_int(stmt, 11) != 0;
+  sqlite3_bind_int(stmt, 1, modelId);
+  int64_t cost = 0;
+  if (sqlite3_step(stmt) == SQLITE_ROW) cost = sqlite3_column_int64(stmt, 0);
+  sqlite3_finalize(stmt);
+  return cost;
+}
 
-      loadedModels.push_back(model);
+bool Model::setRenderCost(int modelId, int64_t milliseconds) {
+  std::string sql = "UPDATE models SET render_cost = ? WHERE id = ?;";
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement(sql);
+  if (!stmt) return false;
+
+  sqlite3_bind_int64(stmt, 1, milliseconds);
+  sqlite3_bind_int(stmt, 2, modelId);
+  return executePreparedStatement(stmt);
+}
+
+bool Model::setStageState(int modelId, unsigned int stages, StageState state,
+                          const std::string& error) {
+  std::string sql = R"(
+        INSERT OR REPLACE INTO model_stages (model_id, stage, state, updated_at, error)
+        VALUES (?, ?, ?, strftime('%s', 'now'), ?);
+    )";
+  std::string sqlClearFailure = R"(
+        DELETE FROM stage_failures
+        WHERE content_hash = (SELECT content_hash FROM models WHERE id = ?1)
+          AND stage = ?2;
+    )";
+  std::string sqlNoteFailure = R"(
+        UPDATE stage_failures SET error = ?3
+        WHERE content_hash = (SELECT content_hash FROM models WHERE id = ?1)
+          AND stage = ?2;
+    )";
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+
+  for (unsigned int bit = 1; bit != 0 && bit <= stages; bit <<= 1) {
+    if (!(stages & bit)) continue;
+    sqlite3_stmt* stmt = prepareStatement(sql);
+    if (!stmt) return false;
+
+    sqlite3_bind_int(stmt, 1, modelId);
+    sqlite3_bind_int(stmt, 2, static_cast<int>(bit));
+    sqlite3_bind_int(stmt, 3, state);
+    if (error.empty()) {
+      sqlite3_bind_null(stmt, 4);
+    } else {
+      sqlite3_bind_text(stmt, 4, error.c_str(), -1, SQLITE_TRANSIENT);
     }
-    sqlite3_finalize(stmt);
+    if (!executePreparedStatement(stmt)) return false;
+
+    // Success lifts any quarantine on these contents; a failure explains
+    // the attempt recorded before the stage ran
+    if (state == StageDone || state == StageFailed) {
+      sqlite3_stmt* failure =
+          prepareStatement(state == StageDone ? sqlClearFailure : sqlNoteFailure);
+      if (!failure) return false;
+      sqlite3_bind_int(failure, 1, modelId);
+      sqlite3_bind_int(failure, 2, static_cast<int>(bit));
+      if (state == StageFailed) {
+        sqlite3_bind_text(failure, 3, error.c_str(), -1, SQLITE_TRANSIENT);
+      }
+      if (!executePreparedStatement(failure)) return false;
+    }
+  }
+  return true;
+}
 
-    // Update the models vector
-    beginResetModel();
-    models = std::move(loadedModels);
-    endResetModel();
+std::vector<StageStatus> Model::getStageStatus(int modelId) {
+  std::vector<StageStatus> stages;
+  std::string sql = R"(
+        SELECT model_id, stage, state, updated_at, error
+        FROM model_stages WHERE model_id = ? ORDER BY stage;
+    )";
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
+  sqlite3_stmt* stmt = prepareStatement(conn, sql);
+  if (!stmt) return stages;
 
-  } else {
-    std::cerr << "Failed to select models: " << sqlite3_errmsg(db) << std::endl;
+  sqlite3_bind_int(stmt, 1, modelId);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    StageStatus status;
+    status.model_id = sqlite3_column_int(stmt, 0);
+    status.stage = static_cast<unsigned int>(sqlite3_column_int(stmt, 1));
+    status.state = sqlite3_column_int(stmt, 2);
+    status.updated_at = sqlite3_column_int64(stmt, 3);
+    const char* error =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+    status.error = error ? error : "";
+    stages.push_back(status);
   }
+  sqlite3_finalize(stmt);
+  return stages;
 }
 
-int Model::hashModel(const std::string& modelDir) {
-  qDebug() << "hashModel called with modelDir:"
-           << QString::fromStdString(modelDir);
+bool Model::resetStages(unsigned int stages, int modelId) {
+  std::string sql = R"(
+        DELETE FROM model_stages
+        WHERE (stage & ?1) != 0 AND (?2 = -1 OR model_id = ?2);
+    )";
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement(sql);
+  if (!stmt) return false;
+
+  sqlite3_bind_int(stmt, 1, static_cast<int>(stages));
+  sqlite3_bind_int(stmt, 2, modelId);
+  return executePreparedStatement(stmt);
+}
 
-  std::ifstream file(modelDir, std::ios::binary);
-  if (!file.is_open()) {
-    std::cerr << "Could not open file for hashing: " << modelDir << std::endl;
-    return 0;
+int64_t Model::quarantineDelay(int attempts) {
+  int64_t delay = kQuarantineBaseDelay;
+  for (int i = 1; i < attempts && delay < kQuarantineMaxDelay; ++i) {
+    delay *= 2;
   }
+  return std::min(delay, kQuarantineMaxDelay);
+}
 
-  std::stringstream buffer;
-  buffer << file.rdbuf();
-  std::string fileContents = buffer.str();
+bool Model::recordStageAttempt(int modelId, unsigned int stages) {
+  // Models that were never hashed have nothing to key the attempt on
+  std::string sql = R"(
+        INSERT INTO stage_failures (content_hash, stage, attempts, last_attempt)
+        SELECT content_hash, ?, 1, strftime('%s', 'now') FROM models
+        WHERE id = ? AND content_hash IS NOT NULL AND content_hash != 0
+        ON CONFLICT (content_hash, stage) DO UPDATE
+        SET attempts = attempts + 1, last_attempt = excluded.last_attempt;
+    )";
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
 
-  std::hash<std::string> hasher;
-  int hashValue = static_cast<int>(hasher(fileContents));
+  for (unsigned int bit = 1; bit != 0 && bit <= stages; bit <<= 1) {
+    if (!(stages & bit)) continue;
+    sqlite3_stmt* stmt = prepareStatement(sql);
+    if (!stmt) return false;
 
-  qDebug() << "Hash value for" << QString::fromStdString(modelDir) << ":"
-           << hashValue;
+    sqlite3_bind_int(stmt, 1, static_cast<int>(bit));
+    sqlite3_bind_int(stmt, 2, modelId);
+    if (!executePreparedStatement(stmt)) return false;
+  }
+  return true;
+}
+
+std::map<int, unsigned int> Model::getQuarantinedStages() {
+  std::map<int, unsigned int> quarantined;
+  std::string sql = R"(
+        SELECT m.id, f.stage, f.attempts, f.last_attempt
+        FROM stage_failures f JOIN models m ON m.content_hash = f.content_hash;
+    )";
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
+  sqlite3_stmt* stmt = prepareStatement(conn, sql);
+  if (!stmt) return quarantined;
+
+  int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::system_clock::now().time_since_epoch())
+                    .count();
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    int64_t retryAt = sqlite3_column_int64(stmt, 3) +
+                      quarantineDelay(sqlite3_column_int(stmt, 2));
+    if (now < retryAt) {
+      quarantined[sqlite3_column_int(stmt, 0)] |=
+          static_cast<unsigned int>(sqlite3_column_int(stmt, 1));
+    }
+  }
+  sqlite3_finalize(stmt);
+  return quarantined;
+}
 
-  return hashValue;
+bool Model::clearQuarantine() {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  return executeSQL("DELETE FROM stage_failures;");
 }
 
 void Model::printModel(const ModelData& modelData) {
@@ -677,6 +1655,38 @@ void Model::printModel(const ModelData& modelData) {
 
 std::string Model::getHiddenDirectoryPath() const { return hiddenDirPath; }
 
+uint64_t Model::getContentHash(int modelId) {
+  std::string sql = "SELECT content_hash FROM models WHERE id = ?;";
+  ReadLease reader = acquireReader();
+  sqlite3_stmt* stmt = prepareStatement(reader.get(), sql);
+  if (!stmt) return 0;
+
+  sqlite3_bind_int(stmt, 1, modelId);
+  uint64_t hash = 0;
+  if (sqlite3_step(stmt) == SQLITE_ROW) {
+    hash = static_cast<uint64_t>(sqlite3_column_int64(stmt, 0));
+  }
+  sqlite3_finalize(stmt);
+  return hash;
+}
+
+std::set<uint64_t> Model::getContentHashes() {
+  std::set<uint64_t> hashes;
+  std::string sql = R"(
+        SELECT DISTINCT content_hash FROM models
+        WHERE content_hash IS NOT NULL AND content_hash != 0;
+    )";
+  ReadLease reader = acquireReader();
+  sqlite3_stmt* stmt = prepareStatement(reader.get(), sql);
+  if (!stmt) return hashes;
+
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    hashes.insert(static_cast<uint64_t>(sqlite3_column_int64(stmt, 0)));
+  }
+  sqlite3_finalize(stmt);
+  return hashes;
+}
+
 bool Model::executeSQL(const std::string& sql) {
   char* errMsg = nullptr;
   std::lock_guard<std::recursive_mutex> lock(db_mutex);
@@ -693,21 +1703,21 @@ void Model::refreshModelData() { loadModelsFromDatabase(); }
 
 bool Model::setData(const QModelIndex& index, const QVariant& value, int role) {
   if (!index.isValid() || index.row() < 0 ||
-      index.row() >= static_cast<int>(models.size()))
+      index.row() >= static_cast<int>(rows.size()))
     return false;
 
-  ModelData& modelData = models[index.row()];
+  RowKey& key = rows[index.row()];
 
   if (role == IsSelectedRole) {
-    modelData.is_selected = value.toBool();
+    key.is_selected = value.toBool();
 
     std::string sql = "UPDATE models SET is_selected = ? WHERE id = ?;";
     sqlite3_stmt* stmt;
     std::lock_guard<std::recursive_mutex> lock(db_mutex);
 
     if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-      sqlite3_bind_int(stmt, 1, modelData.is_selected ? 1 : 0);
-      sqlite3_bind_int(stmt, 2, modelData.id);
+      sqlite3_bind_int(stmt, 1, key.is_selected ? 1 : 0);
+      sqlite3_bind_int(stmt, 2, key.id);
 
       if (sqlite3_step(stmt) != SQLITE_DONE) {
         std::cerr << "Failed to update is_selected in database: "
@@ -725,15 +1735,15 @@ bool Model::setData(const QModelIndex& index, const QVariant& value, int role) {
     emit dataChanged(index, index, {IsSelectedRole});
     return true;
   } else if (role == IsIncludedRole) {
-    modelData.is_included = value.toBool();
+    key.is_included = value.toBool();
 
     std::string sql = "UPDATE models SET is_included = ? WHERE id = ?;";
     sqlite3_stmt* stmt;
     std::lock_guard<std::recursive_mutex> lock(db_mutex);
 
     if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-      sqlite3_bind_int(stmt, 1, modelData.is_included ? 1 : 0);
-      sqlite3_bind_int(stmt, 2, modelData.id);
+      sqlite3_bind_int(stmt, 1, key.is_included ? 1 : 0);
+      sqlite3_bind_int(stmt, 2, key.id);
 
       if (sqlite3_step(stmt) != SQLITE_DONE) {
         std::cerr << "Failed to update is_included in database: "
@@ -799,6 +1809,63 @@ int Model::insertObject(const ObjectData& obj) {
   return object_id;
 }
 
+std::vector<int> Model::insertObjects(const std::vector<ObjectData>& objects) {
+  std::vector<int> ids;
+  if (objects.empty()) return ids;
+
+  std::string sql = R"(
+        INSERT INTO objects (model_id, name, parent_object_id, is_selected)
+        VALUES (?, ?, ?, ?);
+    )";
+
+  sqlite3_stmt* stmt;
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+
+  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    std::cerr << "SQL error in insertObjects: " << sqlite3_errmsg(db)
+              << std::endl;
+    return ids;
+  }
+
+  executeSQL("SAVEPOINT insert_objects;");
+  enterTransaction();
+
+  ids.reserve(objects.size());
+  for (const auto& obj : objects) {
+    int parent = obj.parent_object_id;
+    if (parent >= static_cast<int>(ids.size())) {
+      std::cerr << "insertObjects: parent of " << obj.name
+                << " does not come before it" << std::endl;
+      break;
+    }
+
+    sqlite3_bind_int(stmt, 1, obj.model_id);
+    sqlite3_bind_text(stmt, 2, obj.name.c_str(), -1, SQLITE_STATIC);
+    if (parent >= 0) {
+      sqlite3_bind_int(stmt, 3, ids[parent]);
+    } else {
+      sqlite3_bind_null(stmt, 3);
+    }
+    sqlite3_bind_int(stmt, 4, obj.is_selected ? 1 : 0);
+
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+      std::cerr << "Insert object failed: " << sqlite3_errmsg(db) << std::endl;
+      break;
+    }
+    ids.push_back(static_cast<int>(sqlite3_last_insert_rowid(db)));
+    sqlite3_reset(stmt);
+  }
+  sqlite3_finalize(stmt);
+
+  if (ids.size() != objects.size()) {
+    executeSQL("ROLLBACK TO insert_objects;");
+    ids.clear();
+  }
+  executeSQL("RELEASE insert_objects;");
+  leaveTransaction();
+  return ids;
+}
+
 bool Model::deleteObjectsForModel(int model_id) {
   std::string sql = "DELETE FROM objects WHERE model_id = ?;";
   sqlite3_stmt* stmt;
@@ -813,7 +1880,12 @@ bool Model::deleteObjectsForModel(int model_id) {
       return false;
     }
     sqlite3_finalize(stmt);
-    return true;
+
+    // The packed hierarchy, if the model was stored that way
+    stmt = prepareStatement("DELETE FROM object_trees WHERE model_id = ?;");
+    if (!stmt) return false;
+    sqlite3_bind_int(stmt, 1, model_id);
+    return executePreparedStatement(stmt);
   } else {
     std::cerr << "SQL error in deleteObjectsForModel: " << sqlite3_errmsg(db)
               << std::endl;
@@ -830,9 +1902,10 @@ std::vector<ObjectData> Model::getObjectsForModel(int model_id) {
     )";
 
   sqlite3_stmt* stmt;
-  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
 
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+  if (sqlite3_prepare_v2(conn, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
     sqlite3_bind_int(stmt, 1, model_id);
 
     while (sqlite3_step(stmt) == SQLITE_ROW) {
@@ -852,7 +1925,7 @@ std::vector<ObjectData> Model::getObjectsForModel(int model_id) {
     }
     sqlite3_finalize(stmt);
   } else {
-    std::cerr << "Failed to retrieve objects: " << sqlite3_errmsg(db)
+    std::cerr << "Failed to retrieve objects: " << sqlite3_errmsg(conn)
               << std::endl;
   }
 
@@ -939,9 +2012,10 @@ ObjectData Model::getObjectById(int object_id) {
     )";
 
   sqlite3_stmt* stmt;
-  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
 
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+  if (sqlite3_prepare_v2(conn, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
     sqlite3_bind_int(stmt, 1, object_id);
 
     if (sqlite3_step(stmt) == SQLITE_ROW) {
@@ -963,68 +2037,733 @@ ObjectData Model::getObjectById(int object_id) {
 
     sqlite3_finalize(stmt);
   } else {
-    std::cerr << "SQL error in getObjectById: " << sqlite3_errmsg(db)
+    std::cerr << "SQL error in getObjectById: " << sqlite3_errmsg(conn)
               << std::endl;
   }
 
-  return obj;
+  return obj;
+}
+
+namespace {
+// Reads object_id, model_id, name, parent_object_id, is_selected
+ObjectData readObjectRow(sqlite3_stmt* stmt) {
+  ObjectData obj;
+  obj.object_id = sqlite3_column_int(stmt, 0);
+  obj.model_id = sqlite3_column_int(stmt, 1);
+  const char* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+  obj.name = name ? name : "";
+  obj.parent_object_id = sqlite3_column_type(stmt, 3) != SQLITE_NULL
+                             ? sqlite3_column_int(stmt, 3)
+                             : -1;
+  obj.is_selected = sqlite3_column_int(stmt, 4) != 0;
+  return obj;
+}
+}  // namespace
+
+std::vector<ObjectData> Model::getSubtree(int object_id) {
+  std::vector<ObjectData> objects;
+  std::string sql = R"(
+        SELECT o.object_id, o.model_id, o.name, o.parent_object_id, o.is_selected
+        FROM object_closure c JOIN objects o ON o.object_id = c.descendant_id
+        WHERE c.ancestor_id = ?
+        ORDER BY c.depth, o.object_id;
+    )";
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
+  sqlite3_stmt* stmt = prepareStatement(conn, sql);
+  if (!stmt) return objects;
+
+  sqlite3_bind_int(stmt, 1, object_id);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    objects.push_back(readObjectRow(stmt));
+  }
+  sqlite3_finalize(stmt);
+  return objects;
+}
+
+std::vector<ObjectData> Model::getAncestors(int object_id) {
+  std::vector<ObjectData> objects;
+  std::string sql = R"(
+        SELECT o.object_id, o.model_id, o.name, o.parent_object_id, o.is_selected
+        FROM object_closure c JOIN objects o ON o.object_id = c.ancestor_id
+        WHERE c.descendant_id = ? AND c.depth > 0
+        ORDER BY c.depth;
+    )";
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
+  sqlite3_stmt* stmt = prepareStatement(conn, sql);
+  if (!stmt) return objects;
+
+  sqlite3_bind_int(stmt, 1, object_id);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    objects.push_back(readObjectRow(stmt));
+  }
+  sqlite3_finalize(stmt);
+  return objects;
+}
+
+int Model::getObjectDepth(int object_id) {
+  std::string sql =
+      "SELECT MAX(depth) FROM object_closure WHERE descendant_id = ?;";
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
+  sqlite3_stmt* stmt = prepareStatement(conn, sql);
+  if (!stmt) return -1;
+
+  sqlite3_bind_int(stmt, 1, object_id);
+  int depth = -1;
+  if (sqlite3_step(stmt) == SQLITE_ROW &&
+      sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+    depth = sqlite3_column_int(stmt, 0);
+  }
+  sqlite3_finalize(stmt);
+  return depth;
+}
+
+std::vector<int> Model::getModelsContainingObject(const std::string& name) {
+  std::vector<int> ids;
+  std::string sql =
+      "SELECT DISTINCT model_id FROM objects WHERE name = ? ORDER BY model_id;";
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
+  sqlite3_stmt* stmt = prepareStatement(conn, sql);
+  if (!stmt) return ids;
+
+  sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_TRANSIENT);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    ids.push_back(sqlite3_column_int(stmt, 0));
+  }
+  sqlite3_finalize(stmt);
+  return ids;
+}
+
+bool Model::setObjectTree(int model_id, const std::vector<char>& tree) {
+  std::string sql =
+      "INSERT OR REPLACE INTO object_trees (model_id, tree) VALUES (?, ?);";
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement(sql);
+  if (!stmt) return false;
+
+  sqlite3_bind_int(stmt, 1, model_id);
+  sqlite3_bind_blob(stmt, 2, tree.data(), static_cast<int>(tree.size()),
+                    SQLITE_STATIC);
+  return executePreparedStatement(stmt);
+}
+
+ObjectTree Model::getObjectTree(int model_id) {
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
+
+  // Read the BLOB in one piece straight into the buffer the tree decodes
+  // from, without going through a result row
+  sqlite3_blob* blob = nullptr;
+  if (sqlite3_blob_open(conn, "main", "object_trees", "tree", model_id, 0,
+                        &blob) != SQLITE_OK) {
+    sqlite3_blob_close(blob);
+    return ObjectTree();  // not stored packed
+  }
+
+  std::vector<char> bytes(static_cast<size_t>(sqlite3_blob_bytes(blob)));
+  int rc = sqlite3_blob_read(blob, bytes.data(), static_cast<int>(bytes.size()), 0);
+  sqlite3_blob_close(blob);
+  if (rc != SQLITE_OK) {
+    std::cerr << "Failed to read object tree for model " << model_id << ": "
+              << sqlite3_errmsg(conn) << std::endl;
+    return ObjectTree();
+  }
+  return ObjectTree(std::move(bytes));
+}
+
+std::unique_ptr<BlobDevice> Model::openBlob(const char* table,
+                                            const char* column,
+                                            sqlite3_int64 rowid) const {
+  return openBlob(acquireReader(), table, column, rowid);
+}
+
+std::unique_ptr<BlobDevice> Model::openBlob(ReadLease reader, const char* table,
+                                            const char* column,
+                                            sqlite3_int64 rowid) const {
+  sqlite3* conn = reader.get();
+  if (!conn) return nullptr;
+
+  sqlite3_blob* blob = nullptr;
+  if (sqlite3_blob_open(conn, "main", table, column, rowid, 0, &blob) !=
+      SQLITE_OK) {
+    // No such row, or the column holds NULL or text rather than a BLOB
+    sqlite3_blob_close(blob);
+    return nullptr;
+  }
+  if (sqlite3_blob_bytes(blob) == 0) {
+    sqlite3_blob_close(blob);
+    return nullptr;
+  }
+  return std::make_unique<BlobDevice>(std::move(reader), blob);
+}
+
+std::unique_ptr<BlobDevice> Model::openThumbnail(int modelId,
+                                                 int minSize) const {
+  ReadLease reader = acquireReader();
+  if (minSize > 0 && reader.get()) {
+    sqlite3_stmt* stmt = prepareStatement(reader.get(), R"(
+        SELECT id FROM thumbnail_levels WHERE model_id = ? AND size >= ?
+        ORDER BY size LIMIT 1;
+    )");
+    sqlite3_int64 level = 0;
+    if (stmt) {
+      sqlite3_bind_int(stmt, 1, modelId);
+      sqlite3_bind_int(stmt, 2, minSize);
+      if (sqlite3_step(stmt) == SQLITE_ROW) level = sqlite3_column_int64(stmt, 0);
+      sqlite3_finalize(stmt);
+    }
+    if (level != 0) {
+      return openBlob(std::move(reader), "thumbnail_levels", "image", level);
+    }
+  }
+  return openBlob(std::move(reader), "models", "thumbnail", modelId);
+}
+
+QImage Model::readThumbnail(int modelId, const QSize& size) const {
+  std::unique_ptr<BlobDevice> device = openThumbnail(
+      modelId,
+      size.isValid() ? std::max(size.width(), size.height()) : 0);
+  if (!device) return QImage();
+
+  QImageReader reader(device.get());
+  if (size.isValid()) {
+    // Only the header is read to learn the full size
+    QSize full = reader.size();
+    if (full.isValid() && (full.width() > size.width() ||
+                           full.height() > size.height())) {
+      reader.setScaledSize(full.scaled(size, Qt::KeepAspectRatio));
+    }
+  }
+  QImage image = reader.read();
+  if (image.isNull()) {
+    qDebug() << "Could not decode thumbnail for model" << modelId << ":"
+             << reader.errorString();
+  }
+  return image;
+}
+
+bool Model::writeThumbnail(int modelId, QIODevice& source) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  qint64 length = source.size() - source.pos();
+  if (source.isSequential() || length <= 0 ||
+      length > sqlite3_limit(db, SQLITE_LIMIT_LENGTH, -1)) {
+    std::cerr << "Thumbnail source for model " << modelId
+              << " is empty, too large or not seekable" << std::endl;
+    return false;
+  }
+
+  // Size the BLOB first, then fill it in place
+  sqlite3_stmt* stmt =
+      prepareStatement("UPDATE models SET thumbnail = zeroblob(?) WHERE id = ?;");
+  if (!stmt) return false;
+  sqlite3_bind_int64(stmt, 1, length);
+  sqlite3_bind_int(stmt, 2, modelId);
+  if (!executePreparedStatement(stmt) || sqlite3_changes(db) == 0) return false;
+
+  sqlite3_blob* blob = nullptr;
+  bool ok = sqlite3_blob_open(db, "main", "models", "thumbnail", modelId, 1,
+                              &blob) == SQLITE_OK;
+  std::vector<char> chunk(kBlobChunkSize);
+  for (qint64 offset = 0; ok && offset < length;) {
+    qint64 got = source.read(chunk.data(),
+                             std::min<qint64>(length - offset, chunk.size()));
+    ok = got > 0 && sqlite3_blob_write(blob, chunk.data(), static_cast<int>(got),
+                                       static_cast<int>(offset)) == SQLITE_OK;
+    offset += got;
+  }
+  sqlite3_blob_close(blob);
+
+  if (!ok) {
+    std::cerr << "Failed to write thumbnail for model " << modelId << ": "
+              << sqlite3_errmsg(db) << std::endl;
+    // Leave no half-written image behind
+    sqlite3_stmt* clear =
+        prepareStatement("UPDATE models SET thumbnail = NULL WHERE id = ?;");
+    if (clear) {
+      sqlite3_bind_int(clear, 1, modelId);
+      executePreparedStatement(clear);
+    }
+    return false;
+  }
+
+  notifyRowsChanged({modelId}, {ThumbnailRole});
+  return true;
+}
+
+std::map<int, QByteArray> Model::encodeThumbnailLevels(const QImage& image) {
+  std::map<int, QByteArray> levels;
+  int fullSize = std::max(image.width(), image.height());
+  for (int size : kThumbnailLevels) {
+    if (size >= fullSize) break;
+
+    // Renders are opaque, so JPEG loses nothing that shows at these sizes
+    QImage level = image.scaled(size, size, Qt::KeepAspectRatio,
+                                Qt::SmoothTransformation);
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    if (!level.save(&buffer, "JPG", 85) && !level.save(&buffer, "PNG")) {
+      std::cerr << "Could not encode a " << size << " px thumbnail level"
+                << std::endl;
+      continue;
+    }
+    levels[size] = bytes;
+  }
+  return levels;
+}
+
+bool Model::writeThumbnailLevels(int modelId,
+                                 const std::map<int, QByteArray>& levels) {
+  if (levels.empty()) return true;
+
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement(R"(
+        INSERT OR REPLACE INTO thumbnail_levels (model_id, size, image)
+        VALUES (?, ?, ?);
+    )");
+  if (!stmt) return false;
+
+  executeSQL("SAVEPOINT thumbnail_levels;");
+  enterTransaction();
+
+  bool ok = true;
+  for (const auto& [size, bytes] : levels) {
+    sqlite3_bind_int(stmt, 1, modelId);
+    sqlite3_bind_int(stmt, 2, size);
+    sqlite3_bind_blob(stmt, 3, bytes.constData(), static_cast<int>(bytes.size()),
+                      SQLITE_STATIC);
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+      std::cerr << "Failed to store thumbnail level " << size << " for model "
+                << modelId << ": " << sqlite3_errmsg(db) << std::endl;
+      ok = false;
+      break;
+    }
+    sqlite3_reset(stmt);
+  }
+  sqlite3_finalize(stmt);
+
+  if (!ok) executeSQL("ROLLBACK TO thumbnail_levels;");
+  executeSQL("RELEASE thumbnail_levels;");
+  leaveTransaction();
+  return ok;
+}
+
+std::vector<ModelData> Model::getSelectedModels() {
+  // Not every row is loaded any more, so ask the database: one statement
+  // seeking page by page past the last id, rather than a query per model
+  std::vector<ModelData> selectedModels;
+  std::string sql = "SELECT " + modelColumns(true) +
+                    " FROM models WHERE is_selected = 1 AND id > ?"
+                    " ORDER BY id LIMIT ?;";
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
+  sqlite3_stmt* stmt = prepareStatement(conn, sql);
+  if (!stmt) return selectedModels;
+
+  int lastId = 0;
+  size_t pageRows;
+  do {
+    sqlite3_bind_int(stmt, 1, lastId);
+    sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(kFetchBatchSize));
+    pageRows = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      selectedModels.push_back(readModelRow(stmt));
+      lastId = selectedModels.back().id;
+      ++pageRows;
+    }
+    sqlite3_reset(stmt);
+  } while (pageRows == kFetchBatchSize);
+  sqlite3_finalize(stmt);
+  return selectedModels;
+}
+
+std::vector<int> Model::getSelectedModelIds() {
+  std::vector<int> ids;
+  std::string sql = "SELECT id FROM models WHERE is_selected = 1 ORDER BY id;";
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
+  sqlite3_stmt* stmt = prepareStatement(conn, sql);
+  if (!stmt) return ids;
+
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    ids.push_back(sqlite3_column_int(stmt, 0));
+  }
+  sqlite3_finalize(stmt);
+  return ids;
+}
+
+int Model::countSelected() {
+  std::string sql = "SELECT COUNT(*) FROM models WHERE is_selected = 1;";
+  int count = 0;
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
+  sqlite3_stmt* stmt = prepareStatement(conn, sql);
+  if (!stmt) return count;
+
+  if (sqlite3_step(stmt) == SQLITE_ROW) {
+    count = sqlite3_column_int(stmt, 0);
+  }
+  sqlite3_finalize(stmt);
+  return count;
+}
+
+std::vector<ModelSummary> Model::getSelectedModelSummaries() {
+  std::vector<ModelSummary> summaries;
+  std::string sql = R"(
+        SELECT id, short_name, title, file_path
+        FROM models
+        WHERE is_selected = 1
+        ORDER BY id;
+    )";
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
+  sqlite3_stmt* stmt = prepareStatement(conn, sql);
+  if (!stmt) return summaries;
+
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    ModelSummary summary;
+    summary.id = sqlite3_column_int(stmt, 0);
+    const char* text;
+    text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    summary.short_name = text ? text : "";
+    text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+    summary.title = text ? text : "";
+    text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+    summary.file_path = text ? text : "";
+    summaries.push_back(summary);
+  }
+  sqlite3_finalize(stmt);
+  return summaries;
+}
+
+CatalogStatistics Model::statistics() {
+  CatalogStatistics stats;
+  std::string sqlCounts = R"(
+        SELECT COUNT(*),
+               COALESCE(SUM(is_included != 0), 0),
+               COALESCE(SUM(is_processed != 0), 0),
+               COALESCE(SUM(is_selected != 0), 0),
+               COALESCE(SUM(is_included != 0 AND is_processed != 0), 0)
+        FROM models;
+    )";
+  std::string sqlTags = R"(
+        SELECT t.name, COUNT(mt.model_id)
+        FROM tags t LEFT JOIN model_tags mt ON mt.tag_id = t.id
+        GROUP BY t.id;
+    )";
+
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
+
+  sqlite3_stmt* stmt = prepareStatement(conn, sqlCounts);
+  if (!stmt) return stats;
+  if (sqlite3_step(stmt) == SQLITE_ROW) {
+    stats.total = sqlite3_column_int(stmt, 0);
+    stats.included = sqlite3_column_int(stmt, 1);
+    stats.processed = sqlite3_column_int(stmt, 2);
+    stats.selected = sqlite3_column_int(stmt, 3);
+    stats.includedProcessed = sqlite3_column_int(stmt, 4);
+  }
+  sqlite3_finalize(stmt);
+
+  stmt = prepareStatement(conn, sqlTags);
+  if (!stmt) return stats;
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    const char* name =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    if (name) {
+      stats.tagCounts[name] = sqlite3_column_int(stmt, 1);
+    }
+  }
+  sqlite3_finalize(stmt);
+  return stats;
+}
+
+std::vector<ObjectData> Model::getSelectedObjectsForModel(int model_id) {
+  std::vector<ObjectData> selectedObjects;
+  std::string sql = R"(
+        SELECT object_id, model_id, name, parent_object_id, is_selected
+        FROM objects
+        WHERE model_id = ? AND is_selected = 1;
+    )";
+
+  sqlite3_stmt* stmt;
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
+
+  if (sqlite3_prepare_v2(conn, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+    sqlite3_bind_int(stmt, 1, model_id);
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      ObjectData obj;
+      obj.object_id = sqlite3_column_int(stmt, 0);
+      obj.model_id = sqlite3_column_int(stmt, 1);
+      obj.name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+
+      if (sqlite3_column_type(stmt, 3) != SQLITE_NULL) {
+        obj.parent_object_id = sqlite3_column_int(stmt, 3);
+      } else {
+        obj.parent_object_id = -1;
+      }
+
+      obj.is_selected = sqlite3_column_int(stmt, 4) != 0;
+      selectedObjects.push_back(obj);
+    }
+    sqlite3_finalize(stmt);
+  } else {
+    std::cerr << "Failed to prepare statement in getSelectedObjectsForModel: "
+              << sqlite3_errmsg(conn) << std::endl;
+  }
+
+  return selectedObjects;
+}
+
+void Model::beginTransaction() {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  executeSQL("BEGIN TRANSACTION;");
+  enterTransaction();
+}
+
+void Model::commitTransaction() {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  if (!executeSQL("COMMIT;")) {
+    // Don't leave it open for the next writer to commit by accident
+    executeSQL("ROLLBACK;");
+  }
+  leaveTransaction();
+}
+
+void Model::enterTransaction() {
+  if (transactionDepth++ == 0) {
+    transactionOwner = std::this_thread::get_id();
+  }
+}
+
+void Model::leaveTransaction() {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  if (transactionDepth > 0 && --transactionDepth == 0) {
+    transactionOwner = std::thread::id();
+
+    // Committed or rolled back, model_tags now says what the index should
+    std::set<int> pending;
+    pending.swap(tagIndexPending);
+    for (int modelId : pending) reindexTagsForModel(modelId);
+  }
+}
+
+void Model::beginWriteBatch() {
+  // Held until commit so no other writer's statement joins the batch; the
+  // writer collects the batch first, so that is only while it runs
+  db_mutex.lock();
+  beginTransaction();
+}
+
+void Model::commitWriteBatch() {
+  // Taken in beginWriteBatch; released on the way out whatever happens
+  std::unique_lock<std::recursive_mutex> batchLock(db_mutex, std::adopt_lock);
+  commitTransaction();
+  std::vector<int> touched;
+  touched.swap(batchTouchedRows);
+  batchLock.unlock();
+
+  // Views were told about these rows before the batch was visible to the
+  // read connections. The row cache has its own lock, so stale rows go
+  // now, before any thread re-reads them; the views hear on their thread.
+  for (int id : touched) evictCachedRow(id);
+  if (!touched.empty()) notifyRowsChanged(std::move(touched));
+}
+
+void Model::runOnModelThread(std::function<void()> fn) {
+  // rows, rowById and the views belong to the thread the model lives on;
+  // the writer thread and indexing workers hand their changes over to it
+  if (QThread::currentThread() == thread()) {
+    fn();
+  } else {
+    QMetaObject::invokeMethod(this, std::move(fn), Qt::QueuedConnection);
+  }
+}
+
+void Model::notifyRowsChanged(std::vector<int> ids, QList<int> roles) {
+  runOnModelThread([this, ids = std::move(ids), roles]() {
+    for (int id : ids) {
+      if (roles.isEmpty() || roles.contains(ThumbnailRole)) {
+        thumbnailCache.remove(id);
+      }
+      auto it = rowById.find(id);
+      if (it != rowById.end()) {
+        QModelIndex modelIndex = index(static_cast<int>(it->second));
+        emit dataChanged(modelIndex, modelIndex, roles);
+      }
+    }
+  });
+}
+
+namespace {
+
+// What a queued write returns when it failed
+bool writeFailed(bool ok) { return !ok; }
+bool writeFailed(int id) { return id < 0; }
+bool writeFailed(const std::vector<int>& ids) { return ids.empty(); }
+
+}  // namespace
+
+template <typename Fn>
+auto Model::queueWrite(std::string what, Fn fn) -> std::future<decltype(fn())> {
+  // Most callers don't wait on the future, so failures are logged here
+  auto logged = [what = std::move(what), fn = std::move(fn)]() mutable {
+    try {
+      auto result = fn();
+      if (writeFailed(result)) {
+        std::cerr << "Queued catalog write failed: " << what << std::endl;
+      }
+      return result;
+    } catch (const std::exception& e) {
+      std::cerr << "Queued catalog write threw: " << what << ": " << e.what()
+                << std::endl;
+      throw;
+    }
+  };
+  if (writer) {
+    return writer->submit(std::move(logged));
+  }
+  // No database, so no writer thread: run in place
+  std::promise<decltype(fn())> done;
+  done.set_value(logged());
+  return done.get_future();
+}
+
+std::future<int> Model::insertObjectAsync(const ObjectData& obj) {
+  return queueWrite("insert object " + obj.name + " of model " + std::to_string(obj.model_id),
+                    [this, obj]() { return insertObject(obj); });
+}
+
+std::future<std::vector<int>> Model::insertObjectsAsync(std::vector<ObjectData> objects) {
+  std::string what = "insert " + std::to_string(objects.size()) + " objects";
+  return queueWrite(std::move(what), [this, objects = std::move(objects)]() {
+    return insertObjects(objects);
+  });
+}
+
+std::future<bool> Model::updateModelFieldsAsync(int id,
+                                                const ModelData& modelData,
+                                                unsigned int fields) {
+  return queueWrite("update model " + std::to_string(id),
+                    [this, id, modelData, fields]() {
+    bool ok = updateModelFields(id, modelData, fields);
+    if (writer && writer->onWriterThread()) batchTouchedRows.push_back(id);
+    return ok;
+  });
+}
+
+std::future<bool> Model::writeThumbnailFileAsync(
+    int modelId, const std::string& path, std::map<int, QByteArray> levels) {
+  return queueWrite("thumbnail " + path + " for model " + std::to_string(modelId),
+                    [this, modelId, path, levels = std::move(levels)]() {
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly)) {
+      std::cerr << "Can't open thumbnail " << path << std::endl;
+      return false;
+    }
+    // A missing level only costs a larger decode later
+    bool ok = writeThumbnail(modelId, file);
+    if (ok) writeThumbnailLevels(modelId, levels);
+    if (ok && writer && writer->onWriterThread()) batchTouchedRows.push_back(modelId);
+    return ok;
+  });
+}
+
+std::future<bool> Model::writeThumbnailAsync(int modelId, QByteArray image,
+                                             std::map<int, QByteArray> levels) {
+  return queueWrite("thumbnail for model " + std::to_string(modelId),
+                    [this, modelId, image = std::move(image),
+                     levels = std::move(levels)]() mutable {
+    QBuffer buffer(&image);
+    buffer.open(QIODevice::ReadOnly);
+    bool ok = writeThumbnail(modelId, buffer);
+    if (ok) writeThumbnailLevels(modelId, levels);
+    if (ok && writer && writer->onWriterThread()) batchTouchedRows.push_back(modelId);
+    return ok;
+  });
 }
 
-std::vector<ModelData> Model::getSelectedModels() {
-  std::vector<ModelData> selectedModels;
-  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+std::future<bool> Model::deleteObjectsForModelAsync(int model_id) {
+  return queueWrite("delete objects of model " + std::to_string(model_id),
+                    [this, model_id]() { return deleteObjectsForModel(model_id); });
+}
 
-  for (const auto& modelData : models) {
-    if (modelData.is_selected) {
-      selectedModels.push_back(modelData);
-    }
-  }
+std::future<bool> Model::recordStageAttemptAsync(int modelId,
+                                                 unsigned int stages) {
+  return queueWrite("stage attempt for model " + std::to_string(modelId),
+                    [this, modelId, stages]() {
+    return recordStageAttempt(modelId, stages);
+  });
+}
 
-  return selectedModels;
+std::future<bool> Model::setStageStateAsync(int modelId, unsigned int stages,
+                                            StageState state,
+                                            const std::string& error) {
+  return queueWrite("stage state for model " + std::to_string(modelId),
+                    [this, modelId, stages, state, error]() {
+    return setStageState(modelId, stages, state, error);
+  });
 }
 
-std::vector<ObjectData> Model::getSelectedObjectsForModel(int model_id) {
-  std::vector<ObjectData> selectedObjects;
-  std::string sql = R"(
-        SELECT object_id, model_id, name, parent_object_id, is_selected
-        FROM objects
-        WHERE model_id = ? AND is_selected = 1;
-    )";
+std::future<bool> Model::setObjectTreeAsync(int model_id,
+                                            std::vector<char> tree) {
+  return queueWrite("object tree of model " + std::to_string(model_id),
+                    [this, model_id, tree = std::move(tree)]() {
+    return setObjectTree(model_id, tree);
+  });
+}
 
-  sqlite3_stmt* stmt;
-  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+std::future<bool> Model::setFileSignatureAsync(int modelId, int64_t size,
+                                               int64_t mtime, uint64_t hash) {
+  return queueWrite("file signature of model " + std::to_string(modelId),
+                    [this, modelId, size, mtime, hash]() {
+    return setFileSignature(modelId, size, mtime, hash);
+  });
+}
 
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-    sqlite3_bind_int(stmt, 1, model_id);
+std::future<bool> Model::setRenderCostAsync(int modelId, int64_t milliseconds) {
+  return queueWrite("render cost of model " + std::to_string(modelId),
+                    [this, modelId, milliseconds]() {
+    return setRenderCost(modelId, milliseconds);
+  });
+}
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-      ObjectData obj;
-      obj.object_id = sqlite3_column_int(stmt, 0);
-      obj.model_id = sqlite3_column_int(stmt, 1);
-      obj.name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+std::future<bool> Model::setModelAttributesAsync(
+    int modelId, std::vector<ObjectAttribute> attributes) {
+  return queueWrite("attributes of model " + std::to_string(modelId),
+                    [this, modelId, attributes = std::move(attributes)]() {
+    return setModelAttributes(modelId, attributes);
+  });
+}
 
-      if (sqlite3_column_type(stmt, 3) != SQLITE_NULL) {
-        obj.parent_object_id = sqlite3_column_int(stmt, 3);
-      } else {
-        obj.parent_object_id = -1;
-      }
+std::future<bool> Model::setModelGeometryAsync(int modelId, ModelGeometry geometry) {
+  return queueWrite("geometry of model " + std::to_string(modelId),
+                    [this, modelId, geometry = std::move(geometry)]() {
+    return setModelGeometry(modelId, geometry);
+  });
+}
 
-      obj.is_selected = sqlite3_column_int(stmt, 4) != 0;
-      selectedObjects.push_back(obj);
+void Model::flushWrites() {
+  if (writer) writer->flush();
+}
+
+ReadLease Model::acquireReader() const {
+  // A thread with a write open must read through the writer, or it would
+  // miss its own uncommitted rows
+  if (readPool && transactionOwner.load() != std::this_thread::get_id()) {
+    if (sqlite3* conn = readPool->acquire()) {
+      return ReadLease(readPool.get(), conn);
     }
-    sqlite3_finalize(stmt);
-  } else {
-    std::cerr << "Failed to prepare statement in getSelectedObjectsForModel: "
-              << sqlite3_errmsg(db) << std::endl;
   }
-
-  return selectedObjects;
+  return ReadLease(db_mutex, db);
 }
 
-void Model::beginTransaction() { executeSQL("BEGIN TRANSACTION;"); }
-
-void Model::commitTransaction() { executeSQL("COMMIT;"); }
-
 bool Model::updateObjectParentId(int object_id, int parent_object_id) {
   std::string sql =
       "UPDATE objects SET parent_object_id = ? WHERE object_id = ?;";
@@ -1053,10 +2792,24 @@ bool Model::updateObjectParentId(int object_id, int parent_object_id) {
 
 bool Model::deleteTables() {
   std::string sqlDeleteModels = "DROP TABLE IF EXISTS models;";
-  std::string sqlDeleteObjects = "DROP TABLE IF EXISTS objects;";
+  std::string sqlDeleteObjects =
+      "DROP TABLE IF EXISTS objects; DROP TABLE IF EXISTS object_closure;"
+      "DROP TABLE IF EXISTS object_trees; DROP TABLE IF EXISTS model_stages;"
+      "DROP TABLE IF EXISTS stage_failures; DROP TABLE IF EXISTS model_geometry;"
+      "DROP TABLE IF EXISTS model_geometry_counts;"
+      "DROP TABLE IF EXISTS model_attributes;";
+  std::string sqlDeleteSearch = R"(
+        DROP TABLE IF EXISTS models_fts_vocab;
+        DROP TABLE IF EXISTS models_fts;
+        DROP TABLE IF EXISTS objects_fts_vocab;
+        DROP TABLE IF EXISTS objects_fts;
+        DROP TABLE IF EXISTS attributes_fts_vocab;
+        DROP TABLE IF EXISTS attributes_fts;
+    )";
 
   // Execute SQL commands to delete tables
-  return executeSQL(sqlDeleteModels) && executeSQL(sqlDeleteObjects);
+  return executeSQL(sqlDeleteModels) && executeSQL(sqlDeleteObjects) &&
+         executeSQL(sqlDeleteSearch);
 }
 
 void Model::resetDatabase() {
@@ -1070,6 +2823,8 @@ void Model::resetDatabase() {
 
 // Tag Operations
 bool Model::addTagToModel(int modelId, const std::string& tagName) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+
   // Insert the tag if it doesn't already exist
   std::string sqlTagInsert = "INSERT OR IGNORE INTO tags (name) VALUES (?);";
   sqlite3_stmt* stmt = prepareStatement(sqlTagInsert);
@@ -1091,7 +2846,9 @@ bool Model::addTagToModel(int modelId, const std::string& tagName) {
   sqlite3_bind_int(stmt, 1, modelId);
   sqlite3_bind_int(stmt, 2, tagId);
 
-  return executePreparedStatement(stmt);
+  if (!executePreparedStatement(stmt)) return false;
+  tagIndexChanged(modelId, [this, modelId, tagName]() { tagIndex.tag(modelId, tagName); });
+  return true;
 }
 
 int Model::getTagId(const std::string& tagName) {
@@ -1110,8 +2867,10 @@ int Model::getTagId(const std::string& tagName) {
 
 std::vector<std::string> Model::getAllTags() {
   std::vector<std::string> tags;
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
   std::string sql = "SELECT name FROM tags;";
-  sqlite3_stmt* stmt = prepareStatement(sql);
+  sqlite3_stmt* stmt = prepareStatement(conn, sql);
   if (!stmt) return tags;
 
   while (sqlite3_step(stmt) == SQLITE_ROW) {
@@ -1127,10 +2886,12 @@ std::vector<std::string> Model::getAllTags() {
 
 std::vector<std::string> Model::getTagsForModel(int modelId) {
   std::vector<std::string> tags;
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
   std::string sql =
       "SELECT name FROM tags t JOIN model_tags mt ON t.id = mt.tag_id WHERE "
       "mt.model_id = ?;";
-  sqlite3_stmt* stmt = prepareStatement(sql);
+  sqlite3_stmt* stmt = prepareStatement(conn, sql);
   if (!stmt) return tags;
 
   sqlite3_bind_int(stmt, 1, modelId);
@@ -1147,6 +2908,7 @@ std::vector<std::string> Model::getTagsForModel(int modelId) {
 }
 
 bool Model::removeTagFromModel(int modelId, const std::string& tagName) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
   int tagId = getTagId(tagName);
   if (tagId == -1) return false;
 
@@ -1161,28 +2923,689 @@ bool Model::removeTagFromModel(int modelId, const std::string& tagName) {
   std::cout << "Removing tag " << tagName << " from model " << modelId
             << std::endl;
 
-  return executePreparedStatement(stmt);
+  if (!executePreparedStatement(stmt)) return false;
+  tagIndexChanged(modelId, [this, modelId, tagName]() { tagIndex.untag(modelId, tagName); });
+  return true;
 }
 
 bool Model::removeAllTagsFromModel(int modelId) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
   std::string sql = "DELETE FROM model_tags WHERE model_id = ?;";
   sqlite3_stmt* stmt = prepareStatement(sql);
   if (!stmt) return false;
 
   sqlite3_bind_int(stmt, 1, modelId);
 
-  return executePreparedStatement(stmt);
+  if (!executePreparedStatement(stmt)) return false;
+  tagIndexChanged(modelId, [this, modelId]() { tagIndex.untagAll(modelId); });
+  return true;
+}
+
+std::vector<int> Model::modelsMatchingTags(const std::string& expression) {
+  std::vector<int> modelIds;
+  if (!tagIndex.match(expression, modelIds)) modelIds.clear();
+  return modelIds;
+}
+
+namespace {
+
+// Fields of modelsMatchingGeometry() expressions; empty column means the
+// field names a model_geometry_counts kind instead
+struct GeometryField {
+  const char* name;
+  const char* column;
+  const char* kind;
+};
+
+constexpr GeometryField kGeometryFields[] = {
+    {"primitives", "g.primitives", nullptr},
+    {"regions", "g.regions", nullptr},
+    {"combinations", "g.combinations", nullptr},
+    {"size", "g.max_size", nullptr},
+    {"width", "g.size_x", nullptr},
+    {"depth", "g.size_y", nullptr},
+    {"height", "g.size_z", nullptr},
+    {"units", "g.units", nullptr},
+    {"type", nullptr, "primitive"},
+    {"shader", nullptr, "shader"},
+    {"material", nullptr, "material"},
+};
+
+const GeometryField* geometryField(const std::string& name) {
+  for (const auto& field : kGeometryFields) {
+    if (name == field.name) return &field;
+  }
+  return nullptr;
+}
+
+bool isNumericField(const GeometryField& field) {
+  return field.column && std::string(field.column) != "g.units";
+}
+
+}  // namespace
+
+bool Model::setModelGeometry(int modelId, const ModelGeometry& geometry) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* row = prepareStatement(R"(
+        INSERT OR REPLACE INTO model_geometry (model_id, primitives, regions,
+            combinations, min_x, min_y, min_z, max_x, max_y, max_z,
+            size_x, size_y, size_z, max_size, units)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);
+    )");
+  sqlite3_stmt* clear =
+      prepareStatement("DELETE FROM model_geometry_counts WHERE model_id = ?;");
+  sqlite3_stmt* count = prepareStatement(R"(
+        INSERT INTO model_geometry_counts (model_id, kind, name, count)
+        VALUES (?, ?, ?, ?);
+    )");
+  if (!row || !clear || !count) {
+    sqlite3_finalize(row);
+    sqlite3_finalize(clear);
+    sqlite3_finalize(count);
+    return false;
+  }
+
+  executeSQL("SAVEPOINT model_geometry;");
+  enterTransaction();
+
+  // Cached and rt renders prepare no tree to measure; the bounds of this
+  // model's last pass or of a duplicate file still hold
+  ModelGeometry bounded = geometry;
+  if (!bounded.has_bounds) {
+    bounded.has_bounds = knownBounds(modelId, bounded.min, bounded.max);
+  }
+
+  sqlite3_bind_int(row, 1, modelId);
+  sqlite3_bind_int(row, 2, geometry.primitives);
+  sqlite3_bind_int(row, 3, geometry.regions);
+  sqlite3_bind_int(row, 4, geometry.combinations);
+  if (bounded.has_bounds) {
+    double largest = 0.0;
+    for (int axis = 0; axis < 3; ++axis) {
+      double extent = bounded.max[axis] - bounded.min[axis];
+      sqlite3_bind_double(row, 5 + axis, bounded.min[axis]);
+      sqlite3_bind_double(row, 8 + axis, bounded.max[axis]);
+      sqlite3_bind_double(row, 11 + axis, extent);
+      largest = std::max(largest, extent);
+    }
+    sqlite3_bind_double(row, 14, largest);
+  }
+  if (!geometry.units.empty()) {
+    sqlite3_bind_text(row, 15, geometry.units.c_str(), -1, SQLITE_TRANSIENT);
+  }
+  bool ok = sqlite3_step(row) == SQLITE_DONE;
+
+  sqlite3_bind_int(clear, 1, modelId);
+  ok = ok && sqlite3_step(clear) == SQLITE_DONE;
+
+  const std::pair<const char*, const std::map<std::string, int>*> kinds[] = {
+      {"primitive", &geometry.primitive_types},
+      {"shader", &geometry.shaders},
+      {"material", &geometry.materials}};
+  for (const auto& [kind, names] : kinds) {
+    for (const auto& [name, n] : *names) {
+      if (!ok) break;
+      sqlite3_bind_int(count, 1, modelId);
+      sqlite3_bind_text(count, 2, kind, -1, SQLITE_STATIC);
+      sqlite3_bind_text(count, 3, name.c_str(), -1, SQLITE_TRANSIENT);
+      sqlite3_bind_int(count, 4, n);
+      ok = sqlite3_step(count) == SQLITE_DONE;
+      sqlite3_reset(count);
+    }
+  }
+  if (!ok) {
+    std::cerr << "Failed to store geometry for model " << modelId << ": "
+              << sqlite3_errmsg(db) << std::endl;
+  }
+  sqlite3_finalize(row);
+  sqlite3_finalize(clear);
+  sqlite3_finalize(count);
+
+  if (!ok) executeSQL("ROLLBACK TO model_geometry;");
+  executeSQL("RELEASE model_geometry;");
+  leaveTransaction();
+  return ok;
+}
+
+bool Model::knownBounds(int modelId, double min[3], double max[3]) {
+  // Read on the writer connection: this runs inside its batches
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement(R"(
+        SELECT g.min_x, g.min_y, g.min_z, g.max_x, g.max_y, g.max_z
+        FROM model_geometry g JOIN models m ON m.id = g.model_id
+        WHERE g.min_x IS NOT NULL
+          AND (g.model_id = ?1
+               OR m.content_hash = (SELECT content_hash FROM models
+                                    WHERE id = ?1 AND content_hash != 0))
+        ORDER BY g.model_id = ?1 DESC
+        LIMIT 1;
+    )");
+  if (!stmt) return false;
+
+  sqlite3_bind_int(stmt, 1, modelId);
+  bool found = sqlite3_step(stmt) == SQLITE_ROW;
+  for (int axis = 0; axis < 3 && found; ++axis) {
+    min[axis] = sqlite3_column_double(stmt, axis);
+    max[axis] = sqlite3_column_double(stmt, 3 + axis);
+  }
+  sqlite3_finalize(stmt);
+  return found;
+}
+
+ModelGeometry Model::getModelGeometry(int modelId) {
+  ModelGeometry geometry;
+  ReadLease reader = acquireReader();
+  sqlite3_stmt* stmt = prepareStatement(reader.get(), R"(
+        SELECT primitives, regions, combinations, min_x, min_y, min_z,
+               max_x, max_y, max_z, units
+        FROM model_geometry WHERE model_id = ?;
+    )");
+  if (!stmt) return geometry;
+
+  sqlite3_bind_int(stmt, 1, modelId);
+  if (sqlite3_step(stmt) == SQLITE_ROW) {
+    geometry.primitives = sqlite3_column_int(stmt, 0);
+    geometry.regions = sqlite3_column_int(stmt, 1);
+    geometry.combinations = sqlite3_column_int(stmt, 2);
+    geometry.has_bounds = sqlite3_column_type(stmt, 3) != SQLITE_NULL;
+    for (int axis = 0; axis < 3 && geometry.has_bounds; ++axis) {
+      geometry.min[axis] = sqlite3_column_double(stmt, 3 + axis);
+      geometry.max[axis] = sqlite3_column_double(stmt, 6 + axis);
+    }
+    if (sqlite3_column_type(stmt, 9) != SQLITE_NULL) {
+      geometry.units =
+          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 9));
+    }
+  }
+  sqlite3_finalize(stmt);
+
+  stmt = prepareStatement(reader.get(), R"(
+        SELECT kind, name, count FROM model_geometry_counts WHERE model_id = ?;
+    )");
+  if (!stmt) return geometry;
+  sqlite3_bind_int(stmt, 1, modelId);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    std::string kind = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    std::string name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    int n = sqlite3_column_int(stmt, 2);
+    if (kind == "primitive") geometry.primitive_types[name] = n;
+    else if (kind == "shader") geometry.shaders[name] = n;
+    else if (kind == "material") geometry.materials[name] = n;
+  }
+  sqlite3_finalize(stmt);
+  return geometry;
+}
+
+std::vector<int> Model::modelsMatchingGeometry(const std::string& expression) {
+  // Each term becomes one condition with its value bound, so names and
+  // numbers never reach the SQL text
+  std::vector<std::string> conditions;
+  std::vector<std::pair<std::string, bool>> values;  // text, is a number
+  std::string orderBy;
+
+  std::istringstream terms(expression);
+  std::string term;
+  while (terms >> term) {
+    size_t opStart = term.find_first_of("<>=!");
+    if (opStart == 0 || opStart == std::string::npos) return {};
+    size_t opEnd = term.find_first_not_of("<>=!", opStart);
+    if (opEnd == std::string::npos) return {};
+
+    std::string name = term.substr(0, opStart);
+    std::string op = term.substr(opStart, opEnd - opStart);
+    std::string value = term.substr(opEnd);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+    const GeometryField* field = geometryField(name);
+    if (!field) return {};
+    bool numeric = isNumericField(*field);
+    bool equality = op == "=" || op == "!=";
+    if (!equality && !(numeric && (op == "<" || op == ">" || op == "<=" ||
+                                   op == ">="))) {
+      return {};
+    }
+
+    if (numeric) {
+      char* end = nullptr;
+      std::strtod(value.c_str(), &end);
+      if (end == value.c_str() || *end != '\0') return {};
+      if (orderBy.empty()) orderBy = field->column;
+    }
+
+    if (field->column) {
+      conditions.push_back(std::string(field->column) + " " + op + " ?");
+    } else {
+      conditions.push_back(
+          std::string(op == "!=" ? "NOT " : "") +
+          "EXISTS (SELECT 1 FROM model_geometry_counts c WHERE c.model_id = "
+          "g.model_id AND c.kind = '" + field->kind + "' AND c.name = ?)");
+    }
+    values.emplace_back(value, numeric);
+  }
+
+  std::string sql = "SELECT g.model_id FROM model_geometry g";
+  for (size_t i = 0; i < conditions.size(); ++i) {
+    sql += (i == 0 ? " WHERE " : " AND ") + conditions[i];
+  }
+  sql += " ORDER BY " + (orderBy.empty() ? "" : orderBy + ", ") + "g.model_id;";
+
+  std::vector<int> modelIds;
+  ReadLease reader = acquireReader();
+  sqlite3_stmt* stmt = prepareStatement(reader.get(), sql);
+  if (!stmt) return modelIds;
+
+  for (size_t i = 0; i < values.size(); ++i) {
+    // Numbers bind as numbers so they compare numerically with the columns
+    const auto& [value, numeric] = values[i];
+    if (numeric) {
+      sqlite3_bind_double(stmt, static_cast<int>(i + 1),
+                          std::strtod(value.c_str(), nullptr));
+    } else {
+      sqlite3_bind_text(stmt, static_cast<int>(i + 1), value.c_str(), -1,
+                        SQLITE_TRANSIENT);
+    }
+  }
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    modelIds.push_back(sqlite3_column_int(stmt, 0));
+  }
+  sqlite3_finalize(stmt);
+  return modelIds;
+}
+
+bool Model::setModelAttributes(int modelId,
+                               const std::vector<ObjectAttribute>& attributes) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* clear =
+      prepareStatement("DELETE FROM model_attributes WHERE model_id = ?;");
+  sqlite3_stmt* insert = prepareStatement(R"(
+        INSERT OR REPLACE INTO model_attributes (model_id, object, key, value)
+        VALUES (?, ?, ?, ?);
+    )");
+  if (!clear || !insert) {
+    sqlite3_finalize(clear);
+    sqlite3_finalize(insert);
+    return false;
+  }
+
+  executeSQL("SAVEPOINT model_attributes;");
+  enterTransaction();
+
+  sqlite3_bind_int(clear, 1, modelId);
+  bool ok = sqlite3_step(clear) == SQLITE_DONE;
+  for (const auto& attribute : attributes) {
+    if (!ok) break;
+    sqlite3_bind_int(insert, 1, modelId);
+    sqlite3_bind_text(insert, 2, attribute.object.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(insert, 3, attribute.key.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(insert, 4, attribute.value.c_str(), -1, SQLITE_STATIC);
+    ok = sqlite3_step(insert) == SQLITE_DONE;
+    sqlite3_reset(insert);
+  }
+  if (!ok) {
+    std::cerr << "Failed to store attributes for model " << modelId << ": "
+              << sqlite3_errmsg(db) << std::endl;
+  }
+  sqlite3_finalize(clear);
+  sqlite3_finalize(insert);
+
+  if (!ok) executeSQL("ROLLBACK TO model_attributes;");
+  executeSQL("RELEASE model_attributes;");
+  leaveTransaction();
+  return ok;
+}
+
+std::vector<ObjectAttribute> Model::getAttributesForModel(
+    int modelId, const std::string& object) {
+  std::vector<ObjectAttribute> attributes;
+  ReadLease reader = acquireReader();
+  sqlite3_stmt* stmt = prepareStatement(reader.get(), R"(
+        SELECT object, key, value FROM model_attributes
+        WHERE model_id = ?1 AND (?2 = '' OR object = ?2)
+        ORDER BY object, key;
+    )");
+  if (!stmt) return attributes;
+
+  sqlite3_bind_int(stmt, 1, modelId);
+  sqlite3_bind_text(stmt, 2, object.c_str(), -1, SQLITE_TRANSIENT);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    attributes.push_back(
+        {reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)),
+         reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+         reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2))});
+  }
+  sqlite3_finalize(stmt);
+  return attributes;
+}
+
+std::vector<int> Model::modelsMatchingAttributes(const std::string& expression) {
+  // One condition per term over the (key, value) index; keys and values
+  // are bound, never spliced into the SQL
+  std::vector<std::string> conditions;
+  std::vector<std::string> values;
+
+  std::istringstream terms(expression);
+  std::string term;
+  while (terms >> term) {
+    size_t op = term.find('=');
+    bool negated = op != std::string::npos && op > 0 && term[op - 1] == '!';
+    std::string key = term.substr(0, negated ? op - 1 : op);
+    if (key.empty() || key.find('!') != std::string::npos) return {};
+
+    std::string exists = "EXISTS (SELECT 1 FROM model_attributes a "
+                         "WHERE a.model_id = m.id AND a.key = ?";
+    values.push_back(key);
+    if (op == std::string::npos) {
+      conditions.push_back(exists + ")");
+      continue;
+    }
+    std::string value = term.substr(op + 1);
+    if (value.empty()) return {};
+    conditions.push_back((negated ? "NOT " : "") + exists + " AND a.value GLOB ?)");
+    values.push_back(value);
+  }
+  if (conditions.empty()) return {};
+
+  std::string sql = "SELECT m.id FROM models m";
+  for (size_t i = 0; i < conditions.size(); ++i) {
+    sql += (i == 0 ? " WHERE " : " AND ") + conditions[i];
+  }
+  sql += " ORDER BY m.id;";
+
+  std::vector<int> modelIds;
+  ReadLease reader = acquireReader();
+  sqlite3_stmt* stmt = prepareStatement(reader.get(), sql);
+  if (!stmt) return modelIds;
+
+  for (size_t i = 0; i < values.size(); ++i) {
+    sqlite3_bind_text(stmt, static_cast<int>(i + 1), values[i].c_str(), -1,
+                      SQLITE_TRANSIENT);
+  }
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    modelIds.push_back(sqlite3_column_int(stmt, 0));
+  }
+  sqlite3_finalize(stmt);
+  return modelIds;
+}
+
+std::map<std::string, int> Model::attributeKeys() {
+  std::map<std::string, int> counts;
+  ReadLease reader = acquireReader();
+  sqlite3_stmt* stmt = prepareStatement(reader.get(), R"(
+        SELECT key, COUNT(DISTINCT model_id) FROM model_attributes GROUP BY key;
+    )");
+  if (!stmt) return counts;
+
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    counts[reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))] =
+        sqlite3_column_int(stmt, 1);
+  }
+  sqlite3_finalize(stmt);
+  return counts;
+}
+
+std::map<std::string, int> Model::tagFacets(const std::string& expression) {
+  std::map<std::string, int> counts;
+  if (!tagIndex.facets(expression, counts)) counts.clear();
+  return counts;
+}
+
+void Model::rebuildTagIndex() {
+  // Held so no tag write lands between the read and the swap. Read through
+  // the writer connection: a reader lease is never taken under db_mutex.
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3* conn = db;
+
+  std::vector<int> modelIds;
+  sqlite3_stmt* stmt = prepareStatement(conn, "SELECT id FROM models;");
+  if (!stmt) return;
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    modelIds.push_back(sqlite3_column_int(stmt, 0));
+  }
+  sqlite3_finalize(stmt);
+
+  std::vector<std::pair<int, std::string>> modelTags;
+  stmt = prepareStatement(
+      conn,
+      "SELECT mt.model_id, t.name FROM model_tags mt "
+      "JOIN tags t ON t.id = mt.tag_id;");
+  if (!stmt) return;
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    const char* tagText =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    if (tagText) {
+      modelTags.emplace_back(sqlite3_column_int(stmt, 0), tagText);
+    }
+  }
+  sqlite3_finalize(stmt);
+
+  tagIndex.assign(modelIds, modelTags);
+}
+
+void Model::reindexTagsForModel(int modelId) {
+  // As in rebuildTagIndex(), no reader lease under db_mutex
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement("SELECT 1 FROM models WHERE id = ?;");
+  if (!stmt) return;
+  sqlite3_bind_int(stmt, 1, modelId);
+  bool exists = sqlite3_step(stmt) == SQLITE_ROW;
+  sqlite3_finalize(stmt);
+  if (!exists) {
+    tagIndex.removeModel(modelId);
+    return;
+  }
+
+  stmt = prepareStatement(
+      "SELECT t.name FROM model_tags mt JOIN tags t ON t.id = mt.tag_id "
+      "WHERE mt.model_id = ?;");
+  if (!stmt) return;
+  sqlite3_bind_int(stmt, 1, modelId);
+  tagIndex.addModel(modelId);
+  tagIndex.untagAll(modelId);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    const char* tagText =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    if (tagText) tagIndex.tag(modelId, tagText);
+  }
+  sqlite3_finalize(stmt);
+}
+
+void Model::tagIndexChanged(int modelId, const std::function<void()>& change) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  if (transactionDepth > 0) {
+    tagIndexPending.insert(modelId);
+  } else {
+    change();
+  }
+}
+
+// Search Operations
+namespace {
+// Splits a query the same way FTS5's unicode61 tokenizer splits text:
+// runs of ASCII alphanumerics (and any non-ASCII byte), lowercased
+std::vector<std::string> tokenizeQuery(const std::string& query) {
+  std::vector<std::string> terms;
+  std::string current;
+  for (unsigned char c : query) {
+    if (std::isalnum(c) || c >= 0x80) {
+      current += static_cast<char>(std::tolower(c));
+    } else if (!current.empty()) {
+      terms.push_back(current);
+      current.clear();
+    }
+  }
+  if (!current.empty()) terms.push_back(current);
+  return terms;
+}
+
+// Wraps a term as an FTS5 string literal
+std::string quoteTerm(const std::string& term) {
+  std::string quoted = "\"";
+  for (char c : term) {
+    if (c == '"') quoted += '"';
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+// Makes % and _ in a LIKE pattern match themselves, with '\' as the escape
+std::string escapeLike(const std::string& text) {
+  std::string escaped;
+  for (char c : text) {
+    if (c == '\\' || c == '%' || c == '_') escaped += '\\';
+    escaped += c;
+  }
+  return escaped;
+}
+
+size_t editDistance(const std::string& a, const std::string& b) {
+  std::vector<size_t> prev(b.size() + 1), curr(b.size() + 1);
+  for (size_t j = 0; j <= b.size(); ++j) prev[j] = j;
+  for (size_t i = 1; i <= a.size(); ++i) {
+    curr[0] = i;
+    for (size_t j = 1; j <= b.size(); ++j) {
+      size_t cost = a[i - 1] == b[j - 1] ? 0 : 1;
+      curr[j] = std::min({prev[j] + 1, curr[j - 1] + 1, prev[j - 1] + cost});
+    }
+    std::swap(prev, curr);
+  }
+  return prev[b.size()];
+}
+}  // namespace
+
+std::vector<std::string> Model::fuzzyTermsFor(sqlite3* conn,
+                                               const std::string& term) {
+  std::vector<std::string> candidates;
+  if (term.size() < 3) return candidates;
+
+  const size_t maxDistance = term.size() >= 6 ? 2 : 1;
+  const size_t maxCandidates = 16;
+
+  // Typos rarely hit the first character, so only scan that slice of the
+  // vocabulary; fts5vocab serves the term range without a full scan. A
+  // 0xFF first byte has no next byte to stop at, so its slice is open.
+  unsigned char first = static_cast<unsigned char>(term[0]);
+  std::string lower(1, term[0]);
+  std::string upper(1, static_cast<char>(first + 1));
+  std::string range = first == 0xFF ? "term >= ?1" : "term >= ?1 AND term < ?2";
+  std::string sql = "SELECT term FROM models_fts_vocab WHERE " + range +
+                    " UNION SELECT term FROM objects_fts_vocab WHERE " + range +
+                    " UNION SELECT term FROM attributes_fts_vocab WHERE " + range + ";";
+
+  sqlite3_stmt* stmt = prepareStatement(conn, sql);
+  if (!stmt) return candidates;
+
+  sqlite3_bind_text(stmt, 1, lower.c_str(), -1, SQLITE_TRANSIENT);
+  if (first != 0xFF) sqlite3_bind_text(stmt, 2, upper.c_str(), -1, SQLITE_TRANSIENT);
+
+  // Every near spelling in the slice, so the closest are kept rather than
+  // the first few alphabetically
+  std::vector<std::pair<size_t, std::string>> near;
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    const char* text =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    if (!text) continue;
+    std::string candidate(text);
+    if (candidate.compare(0, term.size(), term) == 0) continue;  // prefix hit
+
+    // Compare against the candidate's prefix too, so "whel" finds "wheelbase"
+    std::string head = candidate.substr(0, term.size());
+    size_t distance = std::min(editDistance(term, candidate), editDistance(term, head));
+    if (distance <= maxDistance) near.emplace_back(distance, std::move(candidate));
+  }
+  sqlite3_finalize(stmt);
+
+  std::sort(near.begin(), near.end());
+  for (size_t i = 0; i < near.size() && i < maxCandidates; ++i) {
+    candidates.push_back(std::move(near[i].second));
+  }
+  return candidates;
+}
+
+std::vector<int> Model::searchModels(const std::string& query, int limit) {
+  std::vector<int> ids;
+  std::vector<std::string> terms = tokenizeQuery(query);
+  if (terms.empty()) return ids;
+
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
+
+  if (!searchIndexAvailable) {
+    std::string sql = R"(
+        SELECT id FROM models
+        WHERE short_name LIKE ?1 ESCAPE '\' OR title LIKE ?1 ESCAPE '\'
+              OR author LIKE ?1 ESCAPE '\' OR file_path LIKE ?1 ESCAPE '\'
+              OR id IN (SELECT model_id FROM model_attributes
+                        WHERE value LIKE ?1 ESCAPE '\')
+        ORDER BY short_name LIMIT ?2;
+    )";
+    sqlite3_stmt* stmt = prepareStatement(conn, sql);
+    if (!stmt) return ids;
+    std::string pattern = "%" + escapeLike(query) + "%";
+    sqlite3_bind_text(stmt, 1, pattern.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, limit);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      ids.push_back(sqlite3_column_int(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+    return ids;
+  }
+
+  // Every term must match, either as a prefix or as a near spelling
+  std::string matchExpr;
+  for (const auto& term : terms) {
+    std::string group = quoteTerm(term) + "*";
+    for (const auto& alt : fuzzyTermsFor(conn, term)) {
+      group += " OR " + quoteTerm(alt);
+    }
+    if (!matchExpr.empty()) matchExpr += " AND ";
+    matchExpr += "(" + group + ")";
+  }
+
+  // bm25 is lower-is-better; names and titles outweigh paths, and hits
+  // that only come from an object name or attribute rank behind direct
+  // model hits
+  std::string sql = R"(
+        SELECT id FROM (
+            SELECT rowid AS id,
+                   bm25(models_fts, 10.0, 5.0, 2.0, 1.0, 4.0) AS score
+            FROM models_fts WHERE models_fts MATCH ?1
+            UNION ALL
+            SELECT o.model_id AS id, bm25(objects_fts) * 0.5 AS score
+            FROM objects_fts JOIN objects o ON o.object_id = objects_fts.rowid
+            WHERE objects_fts MATCH ?1
+            UNION ALL
+            SELECT a.model_id AS id, bm25(attributes_fts) * 0.5 AS score
+            FROM attributes_fts JOIN model_attributes a ON a.id = attributes_fts.rowid
+            WHERE attributes_fts MATCH ?1
+        )
+        GROUP BY id
+        ORDER BY MIN(score)
+        LIMIT ?2;
+    )";
+
+  sqlite3_stmt* stmt = prepareStatement(conn, sql);
+  if (!stmt) return ids;
+  sqlite3_bind_text(stmt, 1, matchExpr.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int(stmt, 2, limit);
+
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    ids.push_back(sqlite3_column_int(stmt, 0));
+  }
+  sqlite3_finalize(stmt);
+  return ids;
 }
 
 // Property Operations
 std::map<std::string, std::string> Model::getPropertiesForModel(int modelId) {
   std::map<std::string, std::string> properties;
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
   std::string sql = R"(
     SELECT short_name, primary_file, override_info, title, thumbnail, author, file_path, library_name
     FROM models
     WHERE id = ?;
   )";
-  sqlite3_stmt* stmt = prepareStatement(sql);
+  sqlite3_stmt* stmt = prepareStatement(conn, sql);
   if (!stmt) return properties;
   sqlite3_bind_int(stmt, 1, modelId);
 
@@ -1204,7 +3627,7 @@ std::map<std::string, std::string> Model::getPropertiesForModel(int modelId) {
     }
   } else {
     std::cerr << "Failed to retrieve properties for model: "
-              << sqlite3_errmsg(db) << std::endl;
+              << sqlite3_errmsg(conn) << std::endl;
   }
 
   std::vector<std::string> columns = {"short_name", "title", "author",
@@ -1217,6 +3640,20 @@ std::map<std::string, std::string> Model::getPropertiesForModel(int modelId) {
       ++it;
 
   sqlite3_finalize(stmt);
+
+  // Read on the same lease; taking a second one could wait on ourselves
+  stmt = prepareStatement(conn, R"(
+    SELECT key, value FROM model_attributes WHERE model_id = ? AND object = ?;
+  )");
+  if (!stmt) return properties;
+  sqlite3_bind_int(stmt, 1, modelId);
+  sqlite3_bind_text(stmt, 2, kGlobalObject, -1, SQLITE_STATIC);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    properties[std::string("global.") +
+               reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))] =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+  }
+  sqlite3_finalize(stmt);
   return properties;
 }
 
@@ -1244,9 +3681,13 @@ bool Model::setPropertyForModel(int modelId, const std::string& property,
 
 // Simplifying executions
 sqlite3_stmt* Model::prepareStatement(const std::string& sql) {
+  return prepareStatement(db, sql);
+}
+
+sqlite3_stmt* Model::prepareStatement(sqlite3* conn, const std::string& sql) const {
   sqlite3_stmt* stmt;
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-    std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db)
+  if (sqlite3_prepare_v2(conn, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(conn)
               << std::endl;
     return nullptr;
   }
@@ -1273,9 +3714,10 @@ std::vector<ModelData> Model::getIncludedModels() {
         WHERE is_included = 1;
     )";
   sqlite3_stmt* stmt;
-  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
 
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+  if (sqlite3_prepare_v2(conn, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
     while (sqlite3_step(stmt) == SQLITE_ROW) {
       ModelData model;
       model.id = sqlite3_column_int(stmt, 0);
@@ -1308,7 +3750,7 @@ std::vector<ModelData> Model::getIncludedModels() {
     }
     sqlite3_finalize(stmt);
   } else {
-    std::cerr << "Failed to select included models: " << sqlite3_errmsg(db)
+    std::cerr << "Failed to select included models: " << sqlite3_errmsg(conn)
               << std::endl;
   }
 
@@ -1319,16 +3761,17 @@ bool Model::isFileIncluded(const std::string& filePath) {
   std::string sql = "SELECT is_included FROM models WHERE file_path = ?;";
   sqlite3_stmt* stmt;
   bool included = false;
-  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  ReadLease reader = acquireReader();
+  sqlite3* conn = reader.get();
 
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+  if (sqlite3_prepare_v2(conn, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
     sqlite3_bind_text(stmt, 1, filePath.c_str(), -1, SQLITE_STATIC);
     if (sqlite3_step(stmt) == SQLITE_ROW) {
       included = sqlite3_column_int(stmt, 0) != 0;
     }
     sqlite3_finalize(stmt);
   } else {
-    std::cerr << "SQL error in isFileIncluded: " << sqlite3_errmsg(db)
+    std::cerr << "SQL error in isFileIncluded: " << sqlite3_errmsg(conn)
               << std::endl;
   }
 
@@ -1348,9 +3791,10 @@ std::vector<ModelData> Model::getIncludedNotProcessedModels() {
     )";
 
     sqlite3_stmt* stmt;
-    std::lock_guard<std::recursive_mutex> lock(db_mutex);
+    ReadLease reader = acquireReader();
+    sqlite3* conn = reader.get();
 
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+    if (sqlite3_prepare_v2(conn, sql, -1, &stmt, nullptr) == SQLITE_OK) {
         while (sqlite3_step(stmt) == SQLITE_ROW) {
             ModelData modelData;
             modelData.id = sqlite3_column_int(stmt, 0);
@@ -1379,7 +3823,7 @@ std::vector<ModelData> Model::getIncludedNotProcessedModels() {
         sqlite3_finalize(stmt);
     } else {
         std::cerr << "[Model::getIncludedNotProcessedModels] SQL error: "
-                  << sqlite3_errmsg(db) << std::endl;
+                  << sqlite3_errmsg(conn) << std::endl;
     }
 
     return notProcessedModels;
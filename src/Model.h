@@ -4,14 +4,37 @@
 #include <sqlite3.h>
 
 #include <QAbstractListModel>
+#include <QCache>
+#include <QIODevice>
+#include <QImage>
+#include <QPixmap>
+#include <QSize>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <future>
+#include <memory>
 #include <mutex>
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <thread>
 #include <vector>
 #include <string>
 #include <mutex>
 #include <sqlite3.h>
 #include <QMetaType>
 
+#include "BlobDevice.h"
+#include "CatalogWriter.h"
+#include "ObjectTree.h"
+#include "ReadConnectionPool.h"
+#include "RenderCache.h"
+#include "TagIndex.h"
+
 // ModelData structure
 struct ModelData {
   int id;
@@ -41,6 +64,69 @@ struct ObjectData {
   bool is_selected;
 };
 
+// A db5 attribute of one object in a model's .g file; the database's
+// global attributes are on the object named kGlobalObject
+struct ObjectAttribute {
+  std::string object;
+  std::string key;
+  std::string value;
+};
+
+// Geometry statistics read from a model's .g file while it is processed,
+// so the catalog can be sorted and filtered without opening it again
+struct ModelGeometry {
+  int primitives = 0;     // solids in the database, each counted once
+  int regions = 0;
+  int combinations = 0;   // regions included
+  bool has_bounds = false;
+  double min[3] = {0, 0, 0};  // bounding box of the rendered object, in mm
+  double max[3] = {0, 0, 0};
+  std::string units;      // the database's local units, e.g. "mm" or "in"
+  std::map<std::string, int> primitive_types;  // "arb8" -> count
+  std::map<std::string, int> shaders;          // region count per shader
+  std::map<std::string, int> materials;        // region count per material
+};
+
+// What a model file looked like when it was last processed; a file is only
+// re-processed once its size or mtime move and its content hash differs
+struct FileSignature {
+  int model_id;
+  std::string file_path;
+  bool is_processed;
+  int64_t size;
+  int64_t mtime;
+  uint64_t hash;
+  unsigned int stages_done;  // Model::ProcessingStage bits that succeeded
+  int64_t render_cost;       // expected full-size render time in ms, 0 if unknown
+};
+
+// Last outcome of one processing stage for one model (model_stages)
+struct StageStatus {
+  int model_id;
+  unsigned int stage;   // a single Model::ProcessingStage bit
+  int state;            // Model::StageState
+  int64_t updated_at;   // seconds since the epoch
+  std::string error;    // why it failed, empty otherwise
+};
+
+// The columns list and report code need, without the thumbnail BLOB
+struct ModelSummary {
+  int id;
+  std::string short_name;
+  std::string title;
+  std::string file_path;
+};
+
+// Catalog-wide counters, computed by Model::statistics()
+struct CatalogStatistics {
+  int total = 0;
+  int included = 0;
+  int processed = 0;
+  int selected = 0;
+  int includedProcessed = 0;  // included models that have been processed
+  std::map<std::string, int> tagCounts;  // every tag, including unused ones
+};
+
 class Model : public QAbstractListModel {
   Q_OBJECT
 
@@ -60,6 +146,44 @@ public:
         IsProcessedRole
     };
 
+    // Field mask for partial updates through updateModelFields()
+    enum ModelField : unsigned int {
+        ShortNameField    = 1u << 0,
+        PrimaryFileField  = 1u << 1,
+        OverrideInfoField = 1u << 2,
+        TitleField        = 1u << 3,
+        ThumbnailField    = 1u << 4,
+        AuthorField       = 1u << 5,
+        FilePathField     = 1u << 6,
+        LibraryNameField  = 1u << 7,
+        IsSelectedField   = 1u << 8,
+        IsProcessedField  = 1u << 9,
+        IsIncludedField   = 1u << 10,
+        TagsField         = 1u << 11,
+        AllFields         = (1u << 12) - 1
+    };
+
+    // Processing is tracked per stage so an interrupted or failed stage can
+    // be resumed on its own; is_processed only says the metadata stage ran.
+    // Stages without a model_stages row are pending.
+    enum ProcessingStage : unsigned int {
+        MetadataStage  = 1u << 0,  // title
+        HierarchyStage = 1u << 1,  // objects / object tree
+        ThumbnailStage = 1u << 2,  // full size
+        GistStage      = 1u << 3,  // run by report generation, not indexing
+        PreviewStage   = 1u << 4,  // quick low-resolution thumbnail, moot once
+                                   // ThumbnailStage is done
+        IndexingStages = MetadataStage | HierarchyStage | PreviewStage | ThumbnailStage
+    };
+    enum StageState { StagePending = 0, StageDone = 1, StageFailed = 2 };
+
+    // A stage that keeps failing for the same file contents waits
+    // kQuarantineBaseDelay seconds before its next automatic attempt,
+    // doubling with every attempt up to kQuarantineMaxDelay
+    static constexpr int64_t kQuarantineBaseDelay = 10 * 60;
+    static constexpr int64_t kQuarantineMaxDelay = 7 * 24 * 60 * 60;
+    static int64_t quarantineDelay(int attempts);
+
     explicit Model(const std::string& libraryPath, QObject* parent = nullptr);
     ~Model() override;
 
@@ -68,6 +192,12 @@ public:
     QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
     QHash<int, QByteArray> roleNames() const override;
 
+    // Rows are fetched in id order, kFetchBatchSize at a time, as views scroll
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+    // Fetches pages until the row for this id is loaded (or none remain)
+    void fetchThrough(int id);
+
     // Data modification and item flags
     bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) override;
     Qt::ItemFlags flags(const QModelIndex& index) const override;
@@ -75,36 +205,132 @@ public:
     // CRUD operations for models
     bool insertModel(const ModelData& modelData);
     bool updateModel(int id, const ModelData& modelData);
+    // Only writes the columns named in the field mask; tags and the
+    // thumbnail BLOB are left alone unless their bits are set
+    bool updateModelFields(int id, const ModelData& modelData, unsigned int fields);
     bool deleteModel(int id);
     bool modelExists(int id);
     bool deleteTables();
     void resetDatabase();
 
     // Getters
-    ModelData getModelById(int id);
+    ModelData getModelById(int id) const;
 
     // Utility methods
-    int hashModel(const std::string& modelDir);
+    // 64-bit XXH64 of the file contents, read through memory-mapped windows;
+    // 0 means the file could not be read
+    uint64_t hashModel(const std::string& modelDir);
+    std::vector<FileSignature> getIncludedFileSignatures();
+    bool setFileSignature(int modelId, int64_t size, int64_t mtime, uint64_t hash);
+    // Expected time for a full-size thumbnail render in milliseconds, kept
+    // across runs so indexing can schedule cheap models first; 0 if unknown
+    int64_t getRenderCost(int modelId);
+    bool setRenderCost(int modelId, int64_t milliseconds);
+    // Records the outcome of every stage bit in stages
+    bool setStageState(int modelId, unsigned int stages, StageState state,
+                       const std::string& error = std::string());
+    std::vector<StageStatus> getStageStatus(int modelId);
+    // Makes the stages pending again, for one model or (-1) all of them, so
+    // the next indexing pass redoes just those stages
+    bool resetStages(unsigned int stages, int modelId = -1);
+    // Failure quarantine, kept per (content hash, stage) so an edited file
+    // starts over and copies of one bad file share a record. An attempt is
+    // counted before the stage runs, so a crash or hang inside BRL-CAD
+    // counts too; a StageDone for the same contents clears it.
+    bool recordStageAttempt(int modelId, unsigned int stages);
+    // Stages each model must not retry yet, keyed by model id
+    std::map<int, unsigned int> getQuarantinedStages();
+    // Makes every quarantined stage eligible for the next pass again
+    bool clearQuarantine();
     void refreshModelData();
     void printModel(const ModelData& modelData);
 
     std::string getHiddenDirectoryPath() const;
 
+    // Rendered thumbnails and reports, shared by every model with the same
+    // contents; lives in .cadventory/render-cache
+    RenderCache& renderCache() { return *renderCachePtr; }
+    // The recorded content hash, 0 if the file was never hashed
+    uint64_t getContentHash(int modelId);
+    // Every content hash still in the library, for pruning the render cache
+    std::set<uint64_t> getContentHashes();
+
     // Update the model list from the database
     void loadModelsFromDatabase();
 
     // Methods for objects
     int insertObject(const ObjectData& obj);
+    // Inserts a whole hierarchy with one statement in one savepoint. Parents
+    // come before their children and each parent_object_id is the index of
+    // the parent in objects (-1 for top-level). Returns the new object ids in
+    // the same order, or nothing if any insert failed.
+    std::vector<int> insertObjects(const std::vector<ObjectData>& objects);
     bool updateObject(const ObjectData& obj);
     bool deleteObjectsForModel(int model_id);
     std::vector<ObjectData> getObjectsForModel(int model_id);
     bool setObjectData(int object_id, const QVariant& value, int role);
     bool updateObjectSelection(int object_id, bool is_selected);
     ObjectData getObjectById(int object_id);
+    // Hierarchy queries answered from the object_closure table
+    // The object itself followed by everything under it, shallowest first
+    std::vector<ObjectData> getSubtree(int object_id);
+    // Parent first, up to the top-level object
+    std::vector<ObjectData> getAncestors(int object_id);
+    // 0 for a top-level object, -1 if the object is unknown
+    int getObjectDepth(int object_id);
+    // Models with an object of this name anywhere in their hierarchy
+    std::vector<int> getModelsContainingObject(const std::string& name);
+
+    // Packed storage: the whole hierarchy as one ObjectTree blob, with only
+    // the selected object kept as a row in objects. getObjectTree() returns
+    // an invalid tree for models stored a row per object.
+    //
+    // Everything answered from the objects table sees only that one row for
+    // a packed model: searchModels() doesn't match its other object names,
+    // getSubtree(), getAncestors() and getObjectDepth() have no closure
+    // rows below it, and getModelsContainingObject() doesn't find it by
+    // any other object. Packing is opt-in ("packObjectTrees") for catalogs
+    // too large to store a row per object.
+    bool setObjectTree(int model_id, const std::vector<char>& tree);
+    ObjectTree getObjectTree(int model_id);
+
+    // Streaming BLOB access: the device reads the column in place through
+    // sqlite3_blob_read, for decoders that can pull from a QIODevice. nullptr
+    // if the row does not exist or the column is NULL or empty.
+    std::unique_ptr<BlobDevice> openBlob(const char* table, const char* column,
+                                         sqlite3_int64 rowid) const;
+    // The smallest stored image whose longest side is at least minSize:
+    // one of the thumbnail levels, or the full thumbnail if none is large
+    // enough (or minSize is 0)
+    std::unique_ptr<BlobDevice> openThumbnail(int modelId, int minSize = 0) const;
+    // Decodes the thumbnail straight from the database, scaled to fit within
+    // size (aspect ratio kept) when size is valid; null if there is none.
+    // Reads the smallest level that covers size.
+    QImage readThumbnail(int modelId, const QSize& size = QSize()) const;
+    // Replaces the thumbnail with the rest of source, written into the BLOB
+    // in chunks; source must be random-access, such as a QFile. Drops the
+    // levels made from the previous thumbnail.
+    bool writeThumbnail(int modelId, QIODevice& source);
+
+    // Downscaled copies kept beside each thumbnail (a mip chain), so list
+    // cards decode a small JPEG rather than the full-size render
+    static constexpr int kThumbnailLevels[] = {64, 128, 256};
+    // What ThumbnailRole asks for: list cards draw thumbnails at about 80 px
+    static constexpr int kListThumbnailSize = 128;
+    // Encodes the levels smaller than image, keyed by longest side
+    static std::map<int, QByteArray> encodeThumbnailLevels(const QImage& image);
+    // Adds levels made by encodeThumbnailLevels for the current thumbnail
+    bool writeThumbnailLevels(int modelId, const std::map<int, QByteArray>& levels);
     bool isFileIncluded(const std::string& filePath);
 
     // Retrieve all selected models
     std::vector<ModelData> getSelectedModels();
+    // Lightweight projections of the selection, in id order
+    std::vector<int> getSelectedModelIds();
+    int countSelected();
+    std::vector<ModelSummary> getSelectedModelSummaries();
+    // All counters in one aggregate pass instead of loading row sets
+    CatalogStatistics statistics();
     std::vector<ModelData> getIncludedNotProcessedModels();
 
 
@@ -116,6 +342,34 @@ public:
 
     void beginTransaction();
     void commitTransaction();
+
+    // Queued writes, group-committed on the writer thread. Each future
+    // resolves once its command has run; flushWrites() returns once
+    // everything this thread queued is committed and visible to readers.
+    std::future<int> insertObjectAsync(const ObjectData& obj);
+    std::future<std::vector<int>> insertObjectsAsync(std::vector<ObjectData> objects);
+    std::future<bool> updateModelFieldsAsync(int id, const ModelData& modelData,
+                                             unsigned int fields);
+    std::future<bool> deleteObjectsForModelAsync(int model_id);
+    std::future<bool> setStageStateAsync(int modelId, unsigned int stages,
+                                         StageState state,
+                                         const std::string& error = std::string());
+    std::future<bool> recordStageAttemptAsync(int modelId, unsigned int stages);
+    std::future<bool> setObjectTreeAsync(int model_id, std::vector<char> tree);
+    // Streams the image file into the thumbnail on the writer thread; levels
+    // (see encodeThumbnailLevels) are stored with it
+    std::future<bool> writeThumbnailFileAsync(int modelId, const std::string& path,
+                                              std::map<int, QByteArray> levels = {});
+    // Stores an already encoded image, e.g. one rendered in-process
+    std::future<bool> writeThumbnailAsync(int modelId, QByteArray image,
+                                          std::map<int, QByteArray> levels = {});
+    std::future<bool> setFileSignatureAsync(int modelId, int64_t size,
+                                            int64_t mtime, uint64_t hash);
+    std::future<bool> setRenderCostAsync(int modelId, int64_t milliseconds);
+    std::future<bool> setModelGeometryAsync(int modelId, ModelGeometry geometry);
+    std::future<bool> setModelAttributesAsync(int modelId,
+                                              std::vector<ObjectAttribute> attributes);
+    void flushWrites();
     bool updateObjectParentId(int object_id, int parent_object_id);
 
 
@@ -127,9 +381,55 @@ public:
   bool removeTagFromModel(int modelId, const std::string& tagName);
   bool removeAllTagsFromModel(int modelId);
 
+  // Tag filters answered from the in-memory bitmap index, e.g.
+  // "steel AND (bolt OR nut) AND NOT obsolete"; see TagIndex::match.
+  // A malformed expression matches nothing.
+  std::vector<int> modelsMatchingTags(const std::string& expression);
+  // Per-tag counts within the models matching the expression
+  std::map<std::string, int> tagFacets(const std::string& expression);
+
+  // Geometry statistics, kept per model in indexed columns. Without
+  // has_bounds the bounds are unknown, not empty: the model keeps those it
+  // has, or takes those of a model with the same content hash.
+  bool setModelGeometry(int modelId, const ModelGeometry& geometry);
+  // has_bounds is false and the counts are 0 if none were stored
+  ModelGeometry getModelGeometry(int modelId);
+  // Models whose geometry matches every term of expression, e.g.
+  // "size>1000 primitives<=500 units=in shader=plastic". Numeric fields are
+  // primitives, regions, combinations and size, width, depth, height (mm,
+  // size being the largest); text fields are units, type (a primitive
+  // type present), shader and material. Ordered by the first numeric field
+  // named, smallest first. A malformed expression matches nothing.
+  std::vector<int> modelsMatchingGeometry(const std::string& expression);
+
+  // Object attributes harvested from the .g file, replacing the model's
+  // earlier ones; keyed (model, object, key)
+  static constexpr const char* kGlobalObject = "_GLOBAL";
+  bool setModelAttributes(int modelId,
+                          const std::vector<ObjectAttribute>& attributes);
+  // Every object's attributes, or only object's if it isn't empty
+  std::vector<ObjectAttribute> getAttributesForModel(
+      int modelId, const std::string& object = "");
+  // Models with an object matching every term of expression, e.g.
+  // "material_id=7 los!=100 region_id". A bare key asks for the key to be
+  // present, key=value for an object with that value ("*" and "?" are
+  // wildcards) and key!=value for no object with it. Ordered by id.
+  std::vector<int> modelsMatchingAttributes(const std::string& expression);
+  // How many models have each attribute key
+  std::map<std::string, int> attributeKeys();
+
+  // Full-text search over short_name, title, author, file_path, tags,
+  // object names (only the selected one for packed hierarchies, see
+  // setObjectTree()) and attribute values. Returns model ids best match first;
+  // each query term is prefix-matched and also expanded to near spellings
+  // found in the index.
+  std::vector<int> searchModels(const std::string& query, int limit = -1);
+
   // Properties operations
   bool setPropertyForModel(int modelId, const std::string& key,
                            const std::string& value);
+  // A fixed set of model columns plus the database's global attributes, the
+  // latter keyed "global.<key>" and read-only
   std::map<std::string, std::string> getPropertiesForModel(int model_id);
 
   // Simplifying executions
@@ -139,14 +439,102 @@ public:
 private:
     // Database related
     bool createTables();
+    bool addColumnIfMissing(const std::string& table, const std::string& column,
+                            const std::string& type);
+    bool tableExists(const std::string& name);
+    bool createObjectClosure();
+    bool createStageTable();
+    bool createThumbnailLevelTable();
+    bool createGeometryTables();
+    // Stored bounds of modelId, else of a model with the same content hash
+    bool knownBounds(int modelId, double min[3], double max[3]);
+    bool createAttributeTable();
+    // openBlob on a connection the caller already leased
+    std::unique_ptr<BlobDevice> openBlob(ReadLease reader, const char* table,
+                                         const char* column,
+                                         sqlite3_int64 rowid) const;
+    bool createSearchIndex();
+    std::vector<std::string> fuzzyTermsFor(sqlite3* conn,
+                                           const std::string& term);
     bool executeSQL(const std::string& sql);
-    bool shortNameExists(const std::string& short_name);
-    bool filePathExists(const std::string& file_path);
+    bool shortNameExists(const std::string& short_name, int excludeId = 0);
+    bool filePathExists(const std::string& file_path, int excludeId = 0);
+    bool syncTagsForModel(int modelId, const std::vector<std::string>& tags);
+    void rebuildRowIndex();
+    void rebuildTagIndex();
+    void reindexTagsForModel(int modelId);
+    // Applies a tag index change for a write that has committed; inside a
+    // transaction the model is re-read from model_tags once it ends instead,
+    // so a rollback leaves the index agreeing with the table
+    void tagIndexChanged(int modelId, const std::function<void()>& change);
+    sqlite3_stmt* prepareStatement(sqlite3* conn, const std::string& sql) const;
+
+    // Loaded rows keep only their key and the flags the filter proxy checks,
+    // so filtering never materializes a row
+    struct RowKey {
+      int id;
+      bool is_selected;
+      bool is_processed;
+      bool is_included;
+    };
+    size_t fetchRows(size_t count);
+    // Row cache entries leave the thumbnail out; it is streamed on demand
+    ModelData readModel(int id, bool withThumbnail) const;
+    // A copy: the entry may be evicted as soon as rowCacheMutex is let go
+    ModelData cachedRow(int id) const;
+    void evictCachedRow(int id);
+
+    // Read queries go through the pool; writes stay on db under db_mutex
+    ReadLease acquireReader() const;
+    void enterTransaction();
+    void leaveTransaction();
+    void beginWriteBatch();
+    void commitWriteBatch();
+    // what names the write in the log if it fails
+    template <typename Fn>
+    auto queueWrite(std::string what, Fn fn) -> std::future<decltype(fn())>;
+    // Runs fn on the thread the model lives on: now if that is this
+    // thread, otherwise queued to its event loop
+    void runOnModelThread(std::function<void()> fn);
+    // Evicts the rows' decoded thumbnails and tells the views; roles empty
+    // for any role
+    void notifyRowsChanged(std::vector<int> ids, QList<int> roles = {});
+
+    static constexpr size_t kWriteBatchSize = 512;
+    static constexpr std::chrono::milliseconds kWriteBatchDelay{20};
+    std::unique_ptr<CatalogWriter> writer;
+    std::vector<int> batchTouchedRows;  // writer thread only
+    static constexpr size_t kReadConnections = 4;
+    static constexpr size_t kBlobChunkSize = 64 * 1024;  // per sqlite3_blob_write
+    std::unique_ptr<ReadConnectionPool> readPool;
+    std::atomic<std::thread::id> transactionOwner{};
+    int transactionDepth = 0;  // guarded by db_mutex
+    std::set<int> tagIndexPending;  // models to reindex; guarded by db_mutex
+
     sqlite3* db;
     std::string dbPath;
-    std::recursive_mutex db_mutex;
+    mutable std::recursive_mutex db_mutex;
     std::string hiddenDirPath;
-    std::vector<ModelData> models;
+    std::unique_ptr<RenderCache> renderCachePtr;
+    std::vector<RowKey> rows;
+    std::unordered_map<int, size_t> rowById;  // model id -> row in rows
+    int lastFetchedId = 0;
+    bool moreRows = true;
+
+    // LRU window of materialized rows (without thumbnails), most recently
+    // used first
+    static constexpr size_t kFetchBatchSize = 200;
+    static constexpr size_t kRowCacheSize = 256;
+    mutable std::mutex rowCacheMutex;
+    uint64_t rowCacheGeneration = 0;  // bumped by every eviction
+    mutable std::list<ModelData> rowCache;
+    mutable std::unordered_map<int, std::list<ModelData>::iterator> rowCacheIndex;
+    // Decoded list thumbnails by model id; model thread only
+    static constexpr int kThumbnailCacheSize = 256;
+    mutable QCache<int, QPixmap> thumbnailCache{kThumbnailCacheSize};
+    bool searchIndexAvailable = false;
+
+    TagIndex tagIndex;  // mirrors model_tags
 };
 
 #endif  // MODEL_H
@@ -1,11 +1,46 @@
 #include "ModelFilterProxyModel.h"
 #include "Model.h"
 #include <QRegularExpression>
+#include <climits>
 
 ModelFilterProxyModel::ModelFilterProxyModel(QObject* parent)
     : QSortFilterProxyModel(parent) {
 }
 
+void ModelFilterProxyModel::setModelIdFilter(const QSet<int>& ids) {
+    clearModelIdOrder();
+    allowedIds = ids;
+    idFilterActive = true;
+    invalidateFilter();
+}
+
+void ModelFilterProxyModel::setModelIdOrder(const std::vector<int>& ids) {
+    setModelIdFilter(QSet<int>(ids.begin(), ids.end()));
+    for (int rank = 0; rank < static_cast<int>(ids.size()); ++rank) {
+        rankById.insert(ids[rank], rank);
+    }
+    sort(0);
+}
+
+void ModelFilterProxyModel::clearModelIdFilter() {
+    clearModelIdOrder();
+    if (!idFilterActive) {
+        return;
+    }
+    allowedIds.clear();
+    idFilterActive = false;
+    invalidateFilter();
+}
+
+void ModelFilterProxyModel::clearModelIdOrder() {
+    if (rankById.isEmpty()) {
+        return;
+    }
+    // Back to the source model's order
+    rankById.clear();
+    sort(-1);
+}
+
 bool ModelFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const {
     QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
 
@@ -21,6 +56,11 @@ bool ModelFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex& s
         return false;
     }
 
+    // Check against the full-text search results, if any
+    if (idFilterActive && !allowedIds.contains(sourceModel()->data(index, Model::IdRole).toInt())) {
+        return false;
+    }
+
     // Proceed with existing filter logic (e.g., search functionality)
     QVariant data = sourceModel()->data(index, filterRole());
     QString dataString;
@@ -37,3 +77,12 @@ bool ModelFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex& s
 
     return dataString.contains(filterRegularExpression());
 }
+
+bool ModelFilterProxyModel::lessThan(const QModelIndex& left, const QModelIndex& right) const {
+    if (rankById.isEmpty()) {
+        return QSortFilterProxyModel::lessThan(left, right);
+    }
+    int leftId = sourceModel()->data(left, Model::IdRole).toInt();
+    int rightId = sourceModel()->data(right, Model::IdRole).toInt();
+    return rankById.value(leftId, INT_MAX) < rankById.value(rightId, INT_MAX);
+}
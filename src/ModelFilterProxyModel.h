@@ -3,7 +3,10 @@
 #ifndef MODELFILTERPROXYMODEL_H
 #define MODELFILTERPROXYMODEL_H
 
+#include <QHash>
+#include <QSet>
 #include <QSortFilterProxyModel>
+#include <vector>
 
 class ModelFilterProxyModel : public QSortFilterProxyModel {
     Q_OBJECT
@@ -11,8 +14,22 @@ class ModelFilterProxyModel : public QSortFilterProxyModel {
 public:
     explicit ModelFilterProxyModel(QObject* parent = nullptr);
 
+    // Restrict rows to the given model ids (e.g. full-text search results)
+    void setModelIdFilter(const QSet<int>& ids);
+    // Like setModelIdFilter, and also shows the rows in the order given
+    void setModelIdOrder(const std::vector<int>& ids);
+    void clearModelIdFilter();
+
 protected:
     bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
+    bool lessThan(const QModelIndex& left, const QModelIndex& right) const override;
+
+private:
+    void clearModelIdOrder();
+
+    bool idFilterActive = false;
+    QSet<int> allowedIds;
+    QHash<int, int> rankById;  // position in the ordered results, if any
 };
 
 #endif // MODELFILTERPROXYMODEL_H
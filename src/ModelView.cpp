@@ -34,12 +34,9 @@ ModelView::ModelView(int modelId, Model* model, QWidget* parent)
 }
 
 void ModelView::loadPreviewImage() {
-  QPixmap thumbnail;
-  thumbnail.loadFromData(
-      reinterpret_cast<const uchar*>(currModel.thumbnail.data()),
-      currModel.thumbnail.size());
-  thumbnail = thumbnail.scaled(ui.previewLabel->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-  ui.previewLabel->setPixmap(thumbnail);
+  // Decoded from the database already scaled to the label
+  QImage thumbnail = model->readThumbnail(modelId, ui.previewLabel->size());
+  ui.previewLabel->setPixmap(QPixmap::fromImage(thumbnail));
 }
 
 void ModelView::populateProperties() {
@@ -122,28 +119,39 @@ void ModelView::onRemoveTagClicked(QListWidgetItem* item) {
 
 void ModelView::onOkClicked() {
   std::cout << "onOkClicked" << std::endl;
-  model->updateModel(modelId, currModel);
-  std::cout << "updated model" << std::endl;
 
   // Update currModel properties
   for (int i = 0; i < ui.valuesList->count(); ++i) {
     QListWidgetItem* keyItem = ui.keysList->item(i);
     QListWidgetItem* valueItem = ui.valuesList->item(i);
-    QString key = keyItem->text();
-    QString value = valueItem->text();
-
-    model->setPropertyForModel(modelId, key.toStdString(), value.toStdString());
+    if (!(valueItem->flags() & Qt::ItemIsEditable)) {
+      continue;  // e.g. the .g file's global attributes
+    }
+    std::string key = keyItem->text().toStdString();
+    std::string value = valueItem->text().toStdString();
+    if (key == "short_name") {
+      currModel.short_name = value;
+    } else if (key == "author") {
+      currModel.author = value;
+    } else {
+      model->setPropertyForModel(modelId, key, value);
+    }
   }
 
   // Update tags
-  model->removeAllTagsFromModel(modelId);
+  currModel.tags.clear();
   for (int i = 0; i < ui.tagsList->count(); ++i) {
     QListWidgetItem* item = ui.tagsList->item(i);
     QWidget* widget = ui.tagsList->itemWidget(item);
     QLabel* tagLabel = widget->findChild<QLabel*>();
-    QString tagText = tagLabel->text();
-    model->addTagToModel(modelId, tagText.toStdString());
+    currModel.tags.push_back(tagLabel->text().toStdString());
   }
+
+  // Only what this dialog edits; the rest of currModel is as it was when
+  // the dialog opened, and indexing or the library view may have moved on
+  model->updateModelFields(modelId, currModel,
+                           Model::ShortNameField | Model::AuthorField | Model::TagsField);
+  std::cout << "updated model" << std::endl;
 }
 
 
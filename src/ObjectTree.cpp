@@ -0,0 +1,148 @@
+#include "ObjectTree.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const char kMagic[4] = {'C', 'V', 'O', 'T'};
+
+void append32(std::vector<char>& out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+}  // namespace
+
+int ObjectTreeBuilder::addNode(const std::string& name, int parent) {
+  if (parent >= static_cast<int>(names.size())) parent = -1;
+  names.push_back(name);
+  parents.push_back(parent);
+  return static_cast<int>(names.size()) - 1;
+}
+
+std::vector<char> ObjectTreeBuilder::encode() const {
+  // Children lists in insertion order, then an iterative preorder walk
+  std::vector<std::vector<int>> childrenOf(names.size());
+  std::vector<int> roots;
+  for (size_t i = 0; i < names.size(); ++i) {
+    if (parents[i] < 0) {
+      roots.push_back(static_cast<int>(i));
+    } else {
+      childrenOf[parents[i]].push_back(static_cast<int>(i));
+    }
+  }
+
+  std::vector<int> order;  // preorder position -> builder index
+  std::vector<int> position(names.size(), -1);
+  std::vector<int> stack(roots.rbegin(), roots.rend());
+  order.reserve(names.size());
+  while (!stack.empty()) {
+    int node = stack.back();
+    stack.pop_back();
+    position[node] = static_cast<int>(order.size());
+    order.push_back(node);
+    const auto& kids = childrenOf[node];
+    stack.insert(stack.end(), kids.rbegin(), kids.rend());
+  }
+
+  // Descendants follow their ancestor contiguously, so each subtree ends
+  // where the walk first returns to a node outside it
+  std::vector<uint32_t> subtreeEnd(order.size());
+  for (size_t pos = order.size(); pos-- > 0;) {
+    uint32_t end = static_cast<uint32_t>(pos + 1);
+    for (int child : childrenOf[order[pos]]) {
+      end = std::max(end, subtreeEnd[position[child]]);
+    }
+    subtreeEnd[pos] = end;
+  }
+
+  std::string strings;
+  std::vector<uint32_t> nameOffsets;
+  nameOffsets.reserve(order.size());
+  for (int node : order) {
+    nameOffsets.push_back(static_cast<uint32_t>(strings.size()));
+    strings += names[node];
+    strings += '\0';
+  }
+
+  std::vector<char> out;
+  out.reserve(ObjectTree::kHeaderSize + 12 * order.size() + strings.size());
+  out.insert(out.end(), kMagic, kMagic + 4);
+  append32(out, ObjectTree::kVersion);
+  append32(out, static_cast<uint32_t>(order.size()));
+  append32(out, static_cast<uint32_t>(strings.size()));
+  for (int node : order) {
+    int parent = parents[node] < 0 ? -1 : position[parents[node]];
+    append32(out, static_cast<uint32_t>(parent));
+  }
+  for (uint32_t end : subtreeEnd) append32(out, end);
+  for (uint32_t offset : nameOffsets) append32(out, offset);
+  out.insert(out.end(), strings.begin(), strings.end());
+  return out;
+}
+
+ObjectTree::ObjectTree(std::vector<char> data) : bytes(std::move(data)) {
+  if (bytes.empty()) return;
+  if (bytes.size() < kHeaderSize ||
+      std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0) {
+    std::cerr << "Object tree blob has no valid header" << std::endl;
+    return;
+  }
+  if (read32(4) != kVersion) {
+    std::cerr << "Unsupported object tree version " << read32(4) << std::endl;
+    return;
+  }
+
+  count = read32(8);
+  stringBytes = read32(12);
+  stringsAt = kHeaderSize + 12 * count;
+  if (stringsAt + stringBytes != bytes.size()) {
+    std::cerr << "Object tree blob is truncated" << std::endl;
+    count = 0;
+    return;
+  }
+  valid = true;
+}
+
+uint32_t ObjectTree::read32(size_t offset) const {
+  const unsigned char* p =
+      reinterpret_cast<const unsigned char*>(bytes.data()) + offset;
+  return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+         static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+int ObjectTree::parent(size_t node) const {
+  if (node >= count) return -1;
+  int32_t value = static_cast<int32_t>(read32(kHeaderSize + 4 * node));
+  return value >= 0 && static_cast<size_t>(value) < node ? value : -1;
+}
+
+size_t ObjectTree::subtreeEnd(size_t node) const {
+  if (node >= count) return node;
+  size_t end = read32(kHeaderSize + 4 * (count + node));
+  return end > node && end <= count ? end : node + 1;
+}
+
+std::string_view ObjectTree::name(size_t node) const {
+  if (node >= count) return {};
+  size_t offset = read32(kHeaderSize + 4 * (2 * count + node));
+  if (offset >= stringBytes) return {};
+  const char* start = bytes.data() + stringsAt + offset;
+  const void* nul = std::memchr(start, '\0', stringBytes - offset);
+  size_t length = nul ? static_cast<const char*>(nul) - start
+                      : stringBytes - offset;
+  return std::string_view(start, length);
+}
+
+std::vector<size_t> ObjectTree::children(int node) const {
+  std::vector<size_t> result;
+  size_t first = node < 0 ? 0 : static_cast<size_t>(node) + 1;
+  size_t end = node < 0 ? count : subtreeEnd(static_cast<size_t>(node));
+  for (size_t child = first; child < end; child = subtreeEnd(child)) {
+    result.push_back(child);
+  }
+  return result;
+}
@@ -0,0 +1,63 @@
+#ifndef OBJECTTREE_H
+#define OBJECTTREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Packed object hierarchy for one model, stored as a single BLOB instead of
+// a row per object. Layout, all integers little-endian:
+//
+//   "CVOT"  u32 version  u32 nodeCount  u32 stringBytes
+//   i32 parent[nodeCount]       parent's node index, -1 for top-level
+//   u32 subtreeEnd[nodeCount]   one past the node's last descendant
+//   u32 nameOffset[nodeCount]   into the string table
+//   char strings[stringBytes]   NUL-terminated names
+//
+// Nodes are in preorder, so a node's descendants are the range
+// (node, subtreeEnd[node]) and its children can be walked by hopping from
+// one child's subtreeEnd to the next.
+class ObjectTreeBuilder {
+ public:
+  // parent is an index returned by an earlier addNode, or -1 for top-level
+  int addNode(const std::string& name, int parent);
+  size_t size() const { return names.size(); }
+  // Encodes the nodes in preorder, keeping siblings in insertion order
+  std::vector<char> encode() const;
+
+ private:
+  std::vector<std::string> names;
+  std::vector<int> parents;
+};
+
+// Read-only view over an encoded tree. Only the header is checked up
+// front; nodes are decoded from the buffer as they are asked for.
+class ObjectTree {
+ public:
+  static constexpr uint32_t kVersion = 1;
+  static constexpr size_t kHeaderSize = 16;
+
+  explicit ObjectTree(std::vector<char> data = {});
+
+  bool isValid() const { return valid; }
+  size_t size() const { return count; }
+  int parent(size_t node) const;
+  size_t subtreeEnd(size_t node) const;
+  std::string_view name(size_t node) const;
+  // Direct children of node, or the top-level nodes for -1
+  std::vector<size_t> children(int node) const;
+  bool hasChildren(size_t node) const { return subtreeEnd(node) > node + 1; }
+
+ private:
+  uint32_t read32(size_t offset) const;
+
+  std::vector<char> bytes;
+  size_t count = 0;
+  size_t stringsAt = 0;
+  size_t stringBytes = 0;
+  bool valid = false;
+};
+
+#endif  // OBJECTTREE_H
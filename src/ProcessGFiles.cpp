@@ -1,7 +1,13 @@
 #include "ProcessGFiles.h"
-#include <brlcad/ged.h>
+#include "ThumbnailRenderer.h"
+#include <brlcad/raytrace.h>
+#include <QBuffer>
 #include <QDebug>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <unordered_map>
 #include <QProcess>
 #include <QSettings>
 #include <QFile>
@@ -9,14 +15,58 @@
 
 #include "config.h"
 
-ProcessGFiles::ProcessGFiles(Model* model)
-    : model(model)
+namespace {
+
+// Render cost model, fitted loosely to rt on a single core: every ray pays a
+// base cost that grows with the log of the primitives the spatial partition
+// has to search, and prep pays per instanced primitive
+constexpr double kRayMicroseconds = 0.5;
+constexpr double kPrepMicrosecondsPerInstance = 20.0;
+// In-process prep runs under brlcadMutex with no deadline; models expected
+// to take longer than this are rendered by rt, which can be killed
+constexpr double kMaxLockedPrepMilliseconds = 2000.0;
+// A db5 primitive takes a few hundred bytes, for guessing from file size
+constexpr int64_t kBytesPerPrimitive = 500;
+// Reading and walking the hierarchy, for the first pass
+constexpr int64_t kBytesReadPerMillisecond = 20000;
+// Time limit for a render, in multiples of its estimate
+constexpr int64_t kTimeLimitFactor = 4;
+// Instanced objects read from one file; deeply shared sub-assemblies can
+// multiply past anything the catalog or the browser could hold
+constexpr size_t kMaxHierarchyNodes = 1000000;
+
+void appendAttributes(const std::string& object, const struct bu_attribute_value_set& avs,
+                      std::vector<ObjectAttribute>& attributes)
 {
+    for (size_t i = 0; i < avs.count; ++i) {
+        const struct bu_attribute_value_pair& pair = avs.avp[i];
+        if (pair.name && pair.value) {
+            attributes.push_back({object, pair.name, pair.value});
+        }
+    }
+}
+
+}  // namespace
+
+// librt keeps process-wide state (rt_uniresource, the list of open
+// databases), so only one thread at a time talks to BRL-CAD in-process
+std::mutex ProcessGFiles::brlcadMutex;
+
+ProcessGFiles::ProcessGFiles(Model* model, const std::atomic<bool>* cancel)
+    : model(model), cancel(cancel)
+{
+}
+
+void ProcessGFiles::RendererRelease::operator()(ThumbnailRenderer* renderer) const
+{
+    std::lock_guard<std::mutex> lock(brlcadMutex);
+    delete renderer;
 }
-void ProcessGFiles::processGFile(const ModelData& modelData)
+void ProcessGFiles::processGFile(const ModelData& modelData, unsigned int stages)
 {
     qDebug() << "[ProcessGFiles::processGFile] Processing model with ID:" << modelData.id
-             << "and file path:" << QString::fromStdString(modelData.file_path);
+             << "and file path:" << QString::fromStdString(modelData.file_path)
+             << "stages:" << stages;
 
     // Ensure file path is not empty
     if (modelData.file_path.empty()) {
@@ -24,85 +74,283 @@ void ProcessGFiles::processGFile(const ModelData& modelData)
         return;
     }
 
-    // Open the BRL-CAD database
-    const char* db_filename = modelData.file_path.c_str();
-    struct ged* gedp = ged_open("db", db_filename, 0);
-    if (gedp == GED_NULL) {
-        qDebug() << "[ProcessGFiles::processGFile] Error: Unable to open BRL-CAD database at path:"
-                 << QString::fromStdString(modelData.file_path);
-        return;
-    }
-
     // Make a copy of modelData to modify
     ModelData updatedModelData = modelData;
-    updatedModelData.is_processed = true;
+    Hierarchy hierarchy;
 
-    extractTitle(updatedModelData, gedp);
-    qDebug() << "[ProcessGFiles::processGFile] Title extracted:" << QString::fromStdString(updatedModelData.title);
+    // The quick preview and the full-size thumbnail, in that order
+    unsigned int renderStages = stages & (Model::PreviewStage | Model::ThumbnailStage);
 
-    // update the model in the database with the extracted title
-    if (!model->updateModel(updatedModelData.id, updatedModelData)) {
-        qDebug() << "[ProcessGFiles::processGFile] Error: Could not update model in database for ID:"
-                 << updatedModelData.id;
-        ged_close(gedp);
-        return;
+    std::string objectNameForThumbnail;
+    if (renderStages && !(stages & Model::HierarchyStage)) {
+        // Only the thumbnail is being redone; render what the last pass selected
+        std::vector<ObjectData> selectedObjects = model->getSelectedObjectsForModel(updatedModelData.id);
+        objectNameForThumbnail = selectedObjects.empty() ? "all" : selectedObjects.back().name;
     }
-    extractObjects(updatedModelData, gedp);
 
+    // librt renders from the database opened below, so the renderer is
+    // prepared before it is closed; "inProcessRenderer" off runs rt instead
+    QSettings settings;
+    bool renderInProcess = renderStages && settings.value("inProcessRenderer", true).toBool();
+    RendererPtr renderer;
+    std::string renderFailure;
+
+    // Expected full-size render time, for the time limits below: when only
+    // the thumbnail is redone, what the first pass measured; otherwise
+    // counted from the file's contents once it is open
+    renderCost = (renderStages && !(stages & Model::HierarchyStage)) ? model->getRenderCost(modelData.id) : 0;
+    // Only renders store a cost, so a stored one was measured; one counted
+    // below is an estimate and doesn't tighten the time limit
+    bool costMeasured = renderCost > 0;
+
+    // Unchanged and duplicate files reuse earlier renders of the same contents
+    uint64_t contentHash = renderStages ? model->getContentHash(modelData.id) : 0;
+    auto allCached = [&](const std::string& object) {
+        for (unsigned int pass : {Model::PreviewStage, Model::ThumbnailStage}) {
+            int size = (pass == Model::PreviewStage) ? kPreviewSize : kThumbnailSize;
+            if ((renderStages & pass) && !model->renderCache().contains(thumbnailKey(contentHash, object, renderInProcess, size))) {
+                return false;
+            }
+        }
+        return true;
+    };
 
-    std::vector<ObjectData> allObjects = model->getObjectsForModel(updatedModelData.id);
-    if (allObjects.empty()) {
-        qDebug() << "[ProcessGFiles::processGFile] No objects found for model ID:" << updatedModelData.id
-                 << ". Skipping thumbnail generation.";
-        ged_close(gedp);
-        return;
+    // Everything needed from the .g file is read in one locked session; the
+    // catalog writes and the render below run while other workers use BRL-CAD
+    {
+        std::lock_guard<std::mutex> lock(brlcadMutex);
+
+        // Open the BRL-CAD database
+        struct db_i* dbip = openDatabase(modelData.file_path);
+        if (dbip == DBI_NULL) {
+            qDebug() << "[ProcessGFiles::processGFile] Error: Unable to open BRL-CAD database at path:"
+                     << QString::fromStdString(modelData.file_path);
+            model->setStageStateAsync(modelData.id, stages, Model::StageFailed,
+                                      "Unable to open the BRL-CAD database");
+            return;
+        }
+
+        if (stages & Model::MetadataStage) {
+            extractTitle(updatedModelData, dbip);
+            qDebug() << "[ProcessGFiles::processGFile] Title extracted:" << QString::fromStdString(updatedModelData.title);
+        }
+        if (stages & Model::HierarchyStage) {
+            hierarchy = readHierarchy(updatedModelData, dbip);
+        }
+        if (stages & Model::HierarchyStage) {
+            countGeometry(dbip, hierarchy.geometry);
+        }
+        size_t primitives = 0;
+        if (renderStages) {
+            primitives = (stages & Model::HierarchyStage) ? hierarchy.geometry.primitives : countPrimitives(dbip);
+        }
+
+        std::string renderTarget = (stages & Model::HierarchyStage) ? hierarchy.selected : objectNameForThumbnail;
+        if (renderInProcess && !renderTarget.empty()) {
+            // A prep that could hold the lock for long goes to rt instead
+            size_t instances = std::max(primitives, hierarchy.nodes.size());
+            double prepMs = instances * kPrepMicrosecondsPerInstance / 1000.0;
+            if (prepMs > kMaxLockedPrepMilliseconds) {
+                qDebug() << "[ProcessGFiles::processGFile] Expected prep of" << prepMs << "ms for"
+                         << instances << "instances; rendering with rt";
+                renderInProcess = false;
+            }
+        }
+        if (renderInProcess && !renderTarget.empty() && !allCached(renderTarget) && !(cancel && cancel->load())) {
+            renderer.reset(new ThumbnailRenderer());
+            if (!renderer->prepare(dbip, renderTarget, renderFailure)) {
+                qDebug() << "[ProcessGFiles::processGFile] librt could not prepare"
+                         << QString::fromStdString(renderTarget) << ":" << QString::fromStdString(renderFailure);
+            }
+        }
+        if (stages & Model::HierarchyStage) {
+            // Only the tree prepared for rendering gives a bounding box;
+            // prepping one for the bounds alone could take as long as the
+            // render, under the lock and with no deadline. Cached and rt
+            // renders leave the bounds unknown, and setModelGeometry keeps
+            // the model's own or a duplicate file's.
+            if (renderer && renderFailure.empty() && renderer->object() == hierarchy.selected) {
+                hierarchy.geometry.has_bounds = renderer->bounds(hierarchy.geometry.min, hierarchy.geometry.max);
+            }
+        }
+        if (renderStages && renderCost <= 0) {
+            // The prepared tree knows how often each primitive is used; the
+            // hierarchy is the next best count of instances
+            size_t instances = (renderer && renderFailure.empty()) ? renderer->solidCount()
+                                                                    : std::max(primitives, hierarchy.nodes.size());
+            renderCost = estimateRenderCost(primitives, instances);
+        }
+        db_close(dbip);
     }
 
-    qDebug() << "[ProcessGFiles::processGFile] Attempting thumbnail generation for model ID:" << updatedModelData.id;
+    if (stages & Model::MetadataStage) {
+        updatedModelData.is_processed = true;
 
-    std::vector<ObjectData> selectedObjects = model->getSelectedObjectsForModel(updatedModelData.id);
+        // update the model in the database with the extracted title; writes go
+        // through the model's group-commit queue so this thread is not held up
+        // by SQLite
+        if (!model->updateModelFieldsAsync(updatedModelData.id, updatedModelData,
+                                           Model::TitleField | Model::IsProcessedField).get()) {
+            qDebug() << "[ProcessGFiles::processGFile] Error: Could not update model in database for ID:"
+                     << updatedModelData.id;
+            model->setStageStateAsync(updatedModelData.id, stages, Model::StageFailed,
+                                      "Could not update the model in the catalog");
+            return;
+        }
+        model->setStageStateAsync(updatedModelData.id, Model::MetadataStage, Model::StageDone);
+    }
 
-    std::string objectNameForThumbnail;
-    if (!selectedObjects.empty()) {
-        const ObjectData& selectedObject = selectedObjects.front();
-        objectNameForThumbnail = selectedObject.name;
-        qDebug() << "[ProcessGFiles::processGFile] Found selected object. Using object named:"
-                 << QString::fromStdString(objectNameForThumbnail) << "for thumbnail.";
-    } else {
-        if (!allObjects.empty()) {
-            objectNameForThumbnail = "all";
-            qDebug() << "[ProcessGFiles::processGFile] No specific object selected. Defaulting to 'all'.";
+    if (stages & Model::HierarchyStage) {
+        // A changed file is processed again; drop the objects from its last pass
+        model->deleteObjectsForModelAsync(updatedModelData.id);
+
+        // Packed storage keeps the hierarchy in one blob instead of a row per
+        // object, at the cost of object-name search and hierarchy queries;
+        // see Model::setObjectTree()
+        if (hierarchy.nodes.empty()) {
+            objectNameForThumbnail = "";
+        } else if (settings.value("packObjectTrees", false).toBool()) {
+            objectNameForThumbnail = extractObjectTree(updatedModelData, hierarchy);
         } else {
-            qDebug() << "[ProcessGFiles::processGFile] No objects available for thumbnail generation.";
-            ged_close(gedp);
-            return;
+            objectNameForThumbnail = extractObjects(updatedModelData, hierarchy);
         }
+
+        if (objectNameForThumbnail.empty()) {
+            model->setStageStateAsync(updatedModelData.id, Model::HierarchyStage, Model::StageFailed,
+                                      "No objects found in the database");
+        } else {
+            model->setStageStateAsync(updatedModelData.id, Model::HierarchyStage, Model::StageDone);
+        }
+        model->setModelGeometryAsync(updatedModelData.id, std::move(hierarchy.geometry));
+        model->setModelAttributesAsync(updatedModelData.id, std::move(hierarchy.attributes));
     }
 
-    bool thumbnailGenerated = generateThumbnail(updatedModelData, objectNameForThumbnail);
+    if (!renderStages) {
+        return;
+    }
 
-    if (!thumbnailGenerated) {
-        qDebug() << "[ProcessGFiles::processGFile] Thumbnail generation failed for model ID:" << updatedModelData.id;
-    } else {
-        qDebug() << "[ProcessGFiles::processGFile] Thumbnail generated successfully for model ID:" << updatedModelData.id
-                 << ". Updating model data in the database.";
-        if (!model->updateModel(updatedModelData.id, updatedModelData)) {
-            qDebug() << "[ProcessGFiles::processGFile] Error updating model thumbnail in database for ID:"
-                     << updatedModelData.id;
+    if (objectNameForThumbnail.empty()) {
+        qDebug() << "[ProcessGFiles::processGFile] No objects found for model ID:" << updatedModelData.id
+                 << ". Skipping thumbnail generation.";
+        model->setStageStateAsync(updatedModelData.id, renderStages, Model::StageFailed,
+                                  "No objects to render");
+        return;
+    }
+
+    qDebug() << "[ProcessGFiles::processGFile] Attempting thumbnail generation for model ID:" << updatedModelData.id
+             << "using object named:" << QString::fromStdString(objectNameForThumbnail);
+
+    bool inProcess = renderer && renderer->object() == objectNameForThumbnail;
+    for (unsigned int pass : {Model::PreviewStage, Model::ThumbnailStage}) {
+        if (!(renderStages & pass)) {
+            continue;
+        }
+        if (cancel && cancel->load()) {
+            // Stopped during the prep or the pass before; the stages stay pending
+            qDebug() << "[ProcessGFiles::processGFile] Thumbnail cancelled for model ID:" << updatedModelData.id;
+            return;
+        }
+        int size = (pass == Model::PreviewStage) ? kPreviewSize : kThumbnailSize;
+
+        // Each pass replaces the stored image, so the preview shows until
+        // the full size is done
+        std::string thumbnailFailure;
+        bool thumbnailGenerated = false;
+        bool rendered = false;
+        std::chrono::milliseconds timeLimit = renderTimeLimit(costMeasured ? renderCost : 0, size);
+        auto renderStart = std::chrono::steady_clock::now();
+        RenderCache::Key cacheKey = thumbnailKey(contentHash, objectNameForThumbnail, renderInProcess, size);
+        std::string cached;
+        if (model->renderCache().fetch(cacheKey, cached)) {
+            qDebug() << "[ProcessGFiles::processGFile] Thumbnail for model ID:" << updatedModelData.id
+                     << "at" << size << "px found in the render cache";
+            QByteArray image(cached.data(), static_cast<int>(cached.size()));
+            std::map<int, QByteArray> levels = Model::encodeThumbnailLevels(QImage::fromData(image));
+            thumbnailGenerated = model->writeThumbnailAsync(updatedModelData.id, image, std::move(levels)).get();
+            if (!thumbnailGenerated) {
+                thumbnailFailure = "Could not store the cached image";
+            }
+        } else if (inProcess && !renderFailure.empty()) {
+            thumbnailFailure = renderFailure;
+        } else if (inProcess) {
+            thumbnailGenerated = renderThumbnail(updatedModelData, *renderer, size, timeLimit, cacheKey, thumbnailFailure);
+            rendered = true;
         } else {
-            qDebug() << "[ProcessGFiles::processGFile] Successfully updated model thumbnail for model ID:" << updatedModelData.id;
+            // Filed under rt's view even if librt was wanted but not prepared
+            thumbnailGenerated = generateThumbnail(updatedModelData, objectNameForThumbnail, size, timeLimit,
+                                                   thumbnailKey(contentHash, objectNameForThumbnail, false, size),
+                                                   thumbnailFailure);
+            rendered = true;
+        }
+
+        // What the render took refines the estimate. A full-size render is
+        // its own measurement; librt's preview time is rays only and scales
+        // with the pixel count, while rt's also holds start-up and prep, so
+        // the full render takes at least as long. A failed render took at
+        // least that long too, which sends it to the back next time.
+        if (rendered) {
+            int64_t elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - renderStart).count();
+            if (pass == Model::ThumbnailStage && thumbnailGenerated) {
+                renderCost = std::max<int64_t>(elapsedMs, 1);
+            } else if (pass == Model::PreviewStage && thumbnailGenerated && inProcess) {
+                int64_t scale = (kThumbnailSize / kPreviewSize) * (kThumbnailSize / kPreviewSize);
+                renderCost = std::max<int64_t>(elapsedMs * scale, 1);
+            } else {
+                renderCost = std::max(renderCost, elapsedMs);
+            }
+            model->setRenderCostAsync(updatedModelData.id, renderCost);
+            costMeasured = true;
+        }
+
+        if (!thumbnailGenerated && cancel && cancel->load()) {
+            // Stopped, not failed: the stage stays pending for the next pass
+            qDebug() << "[ProcessGFiles::processGFile] Thumbnail cancelled for model ID:" << updatedModelData.id;
+            return;
         }
+        if (!thumbnailGenerated) {
+            // A larger pass would fail the same way
+            qDebug() << "[ProcessGFiles::processGFile] Thumbnail generation failed for model ID:" << updatedModelData.id
+                     << "at" << size << "px";
+            unsigned int remaining = (pass == Model::PreviewStage) ? renderStages : pass;
+            model->setStageStateAsync(updatedModelData.id, remaining, Model::StageFailed, thumbnailFailure);
+            return;
+        }
+        qDebug() << "[ProcessGFiles::processGFile] Thumbnail generated and stored for model ID:" << updatedModelData.id
+                 << "at" << size << "px";
+        model->setStageStateAsync(updatedModelData.id, pass, Model::StageDone);
     }
+    renderer.reset();
 
-    ged_close(gedp);
     qDebug() << "[ProcessGFiles::processGFile] Completed processing for path:" << QString::fromStdString(updatedModelData.file_path);
 }
 
 
-void ProcessGFiles::extractTitle(ModelData& modelData, struct ged* gedp)
+struct db_i* ProcessGFiles::openDatabase(const std::string& path)
 {
-    if (gedp && gedp->dbip && gedp->dbip->dbi_title) {
-        std::string title(gedp->dbip->dbi_title);
+    // Normally set up by ged_open; rt_db_get_internal() needs it
+    if (rt_uniresource.re_magic != RESOURCE_MAGIC) {
+        rt_init_resource(&rt_uniresource, 0, nullptr);
+    }
+
+    struct db_i* dbip = db_open(path.c_str(), DB_OPEN_READONLY);
+    if (dbip == DBI_NULL) {
+        return DBI_NULL;
+    }
+    if (db_dirbuild(dbip) < 0) {
+        qDebug() << "[ProcessGFiles::openDatabase] Could not read the directory of" << QString::fromStdString(path);
+        db_close(dbip);
+        return DBI_NULL;
+    }
+    // Reference counts tell the top-level objects apart for db_ls()
+    db_update_nref(dbip, &rt_uniresource);
+    return dbip;
+}
+
+void ProcessGFiles::extractTitle(ModelData& modelData, struct db_i* dbip)
+{
+    if (dbip && dbip->dbi_title) {
+        std::string title(dbip->dbi_title);
         modelData.title = title;
         qDebug() << "[ProcessGFiles::extractTitle] Database title found:" << QString::fromStdString(title);
     } else {
@@ -110,180 +358,230 @@ void ProcessGFiles::extractTitle(ModelData& modelData, struct ged* gedp)
         qDebug() << "[ProcessGFiles::extractTitle] No title found in database. Using '(Untitled)'";
     }
 }
-void ProcessGFiles::extractObjects(ModelData& modelData, struct ged* gedp)
+ProcessGFiles::Hierarchy ProcessGFiles::readHierarchy(const ModelData& modelData, struct db_i* dbip)
 {
-    qDebug() << "[ProcessGFiles::extractObjects] Started for model ID:" << modelData.id;
+    qDebug() << "[ProcessGFiles::readHierarchy] Started for model ID:" << modelData.id;
+    Hierarchy hierarchy;
 
-    if (!gedp || !gedp->dbip) {
-        std::cerr << "[ProcessGFiles::extractObjects] Invalid ged pointer." << std::endl;
-        qDebug() << "[ProcessGFiles::extractObjects] Invalid ged pointer. Cannot process objects.";
-        return;
+    if (!dbip) {
+        std::cerr << "[ProcessGFiles::readHierarchy] Invalid database pointer." << std::endl;
+        qDebug() << "[ProcessGFiles::readHierarchy] Invalid database pointer. Cannot process objects.";
+        return hierarchy;
     }
 
     // Initialize the directory pointer to list top-level objects
     struct directory **dir = nullptr;
-    qDebug() << "[ProcessGFiles::extractObjects] Listing top-level objects from the database.";
-    size_t dir_count = db_ls(gedp->dbip, DB_LS_TOPS, nullptr, &dir);
+    qDebug() << "[ProcessGFiles::readHierarchy] Listing top-level objects from the database.";
+    size_t dir_count = db_ls(dbip, DB_LS_TOPS, nullptr, &dir);
     if (dir_count == 0) {
-        std::cerr << "[ProcessGFiles::extractObjects] No objects found in database." << std::endl;
-        qDebug() << "[ProcessGFiles::extractObjects] No objects found in database for model ID:" << modelData.id;
-        return;
+        std::cerr << "[ProcessGFiles::readHierarchy] No objects found in database." << std::endl;
+        qDebug() << "[ProcessGFiles::readHierarchy] No objects found in database for model ID:" << modelData.id;
+        return hierarchy;
     }
 
-    qDebug() << "[ProcessGFiles::extractObjects] Number of top-level objects found:" << dir_count;
+    qDebug() << "[ProcessGFiles::readHierarchy] Number of top-level objects found:" << dir_count;
 
     std::vector<std::string> tops_elements;
     for (size_t i = 0; i < dir_count; ++i) {
         tops_elements.push_back(dir[i]->d_namep);
     }
+    // Free the directory list for top-level objects
+    bu_free(dir, "free directory list");
+
+    // The global object is hidden from listings, so it is read on its own
+    if (struct directory* global = db_lookup(dbip, DB5_GLOBAL_OBJECT_NAME, LOOKUP_QUIET)) {
+        struct bu_attribute_value_set avs;
+        bu_avs_init_empty(&avs);
+        if (db5_get_attributes(dbip, &avs, global) == 0) {
+            appendAttributes(Model::kGlobalObject, avs, hierarchy.attributes);
+        }
+        bu_avs_free(&avs);
+    }
+
+    // Walk the whole tree depth-first, keeping preorder. Every use of a
+    // combination gets its members, so each instance has its own subtree,
+    // but a combination is decoded only at its first use. Past
+    // kMaxHierarchyNodes objects are listed without their members.
+    std::unordered_map<std::string, std::vector<std::string>> membersByComb;
+    std::vector<std::pair<std::string, int>> pending;  // name, parent node
+    for (auto top = tops_elements.rbegin(); top != tops_elements.rend(); ++top) {
+        pending.emplace_back(*top, -1);
+    }
+    bool truncated = false;
+    while (!pending.empty()) {
+        auto [name, parent] = std::move(pending.back());
+        pending.pop_back();
+
+        int node = static_cast<int>(hierarchy.nodes.size());
+        hierarchy.nodes.push_back({name, parent});
+        if (hierarchy.nodes.size() + pending.size() >= kMaxHierarchyNodes) {
+            truncated = true;
+            continue;
+        }
+
+        auto [members, firstUse] = membersByComb.try_emplace(name);
+        if (firstUse) {
+            members->second = childObjectNames(dbip, name, hierarchy);
+        }
+        for (auto child = members->second.rbegin(); child != members->second.rend(); ++child) {
+            pending.emplace_back(*child, node);
+        }
+    }
+    if (truncated) {
+        qDebug() << "[ProcessGFiles::readHierarchy] Stopped expanding at" << kMaxHierarchyNodes
+                 << "objects for model ID:" << modelData.id;
+    }
+    qDebug() << "[ProcessGFiles::readHierarchy] Read" << hierarchy.nodes.size() << "objects,"
+             << membersByComb.size() << "distinct, for model ID:" << modelData.id;
 
     std::string model_short_name = modelData.short_name;
     std::vector<std::string> objects_to_try = {
         "all", "all.g", model_short_name,
         model_short_name + ".g", model_short_name + ".c"
     };
-    std::string selected_object_name;
 
     // Check if any objects_to_try are in tops_elements
     for (const auto& obj_name : objects_to_try) {
         if (std::find(tops_elements.begin(), tops_elements.end(), obj_name) != tops_elements.end()) {
-            selected_object_name = obj_name;
+            hierarchy.selected = obj_name;
             break;
         }
     }
 
     // If no match, select the first top-level object
-    if (selected_object_name.empty() && !tops_elements.empty()) {
-        selected_object_name = tops_elements.front();
+    if (hierarchy.selected.empty() && !tops_elements.empty()) {
+        hierarchy.selected = tops_elements.front();
     }
 
-    qDebug() << "[ProcessGFiles::extractObjects] Selected object for thumbnail:" << QString::fromStdString(selected_object_name);
+    qDebug() << "[ProcessGFiles::readHierarchy] Selected object for thumbnail:" << QString::fromStdString(hierarchy.selected);
+    return hierarchy;
+}
 
-    // Iterate over the directory entries for top-level objects
-    for (size_t i = 0; i < dir_count; ++i) {
-        std::string object_name(dir[i]->d_namep);
-        qDebug() << "[ProcessGFiles::extractObjects] Found top-level object name:" << QString::fromStdString(object_name);
-
-        // Create ObjectData for the top-level object
-        ObjectData topLevelObjData;
-
-        topLevelObjData.model_id = modelData.id;
-        topLevelObjData.name = object_name;
-        topLevelObjData.parent_object_id = -1; // -1 indicates no parent
-        topLevelObjData.is_selected = (object_name == selected_object_name);
-
-        qDebug() << "[ProcessGFiles::extractObjects] Inserting top-level object - "
-                 << "Model ID:" << topLevelObjData.model_id
-                 << ", Name:" << QString::fromStdString(topLevelObjData.name)
-                 << ", Parent Object ID:" << topLevelObjData.parent_object_id
-                 << ", is_selected:" << topLevelObjData.is_selected;
-
-        int insertedTopLevelObjectId = model->insertObject(topLevelObjData);
-        if (insertedTopLevelObjectId == -1) {
-            qDebug() << "[ProcessGFiles::extractObjects] Failed to insert top-level object:"
-                     << QString::fromStdString(topLevelObjData.name)
-                     << "for model ID:" << topLevelObjData.model_id;
-            continue;
-        } else {
-            topLevelObjData.object_id = insertedTopLevelObjectId;
-            qDebug() << "[ProcessGFiles::extractObjects] Successfully inserted top-level object:"
-                     << QString::fromStdString(topLevelObjData.name)
-                     << "with ID:" << insertedTopLevelObjectId << "for model ID:" << topLevelObjData.model_id;
-        }
+std::string ProcessGFiles::extractObjects(ModelData& modelData, const Hierarchy& hierarchy)
+{
+    qDebug() << "[ProcessGFiles::extractObjects] Started for model ID:" << modelData.id;
 
-        // If this top-level object is a combination, retrieve and insert its children
-        if (dir[i]->d_flags & RT_DIR_COMB) {
-            qDebug() << "[ProcessGFiles::extractObjects] Object" << QString::fromStdString(object_name) << "is a combination. Retrieving children.";
-            insertChildObjects(modelData, gedp, topLevelObjData, selected_object_name);
-        } else {
-            qDebug() << "[ProcessGFiles::extractObjects] Object" << QString::fromStdString(object_name) << "is a primitive. No child objects to insert.";
-        }
+    // Only the top-level use of the selected object is flagged
+    std::vector<ObjectData> objects;
+    objects.reserve(hierarchy.nodes.size());
+    for (const auto& node : hierarchy.nodes) {
+        ObjectData objData;
+        objData.model_id = modelData.id;
+        objData.name = node.name;
+        objData.parent_object_id = node.parent;  // an index until inserted
+        objData.is_selected = (node.parent == -1 && node.name == hierarchy.selected);
+        objects.push_back(std::move(objData));
     }
 
-    // Free the directory list for top-level objects
-    bu_free(dir, "free directory list");
-    qDebug() << "[ProcessGFiles::extractObjects] Completed for model ID:" << modelData.id;
+    std::vector<int> ids = model->insertObjectsAsync(std::move(objects)).get();
+    if (ids.empty()) {
+        qDebug() << "[ProcessGFiles::extractObjects] Failed to insert" << hierarchy.nodes.size()
+                 << "objects for model ID:" << modelData.id;
+        return "";
+    }
+
+    qDebug() << "[ProcessGFiles::extractObjects] Inserted" << ids.size() << "objects for model ID:" << modelData.id;
+    return hierarchy.selected;
 }
 
-void ProcessGFiles::insertChildObjects(ModelData& modelData, struct ged* gedp, const ObjectData& parentObjData, const std::string& selected_object_name)
+std::string ProcessGFiles::extractObjectTree(ModelData& modelData, const Hierarchy& hierarchy)
 {
-    qDebug() << "[ProcessGFiles::insertChildObjects] Started for parent object ID:" << parentObjData.object_id << "Name:" << QString::fromStdString(parentObjData.name);
+    qDebug() << "[ProcessGFiles::extractObjectTree] Started for model ID:" << modelData.id;
+
+    // Same nodes as the row-per-object path
+    ObjectTreeBuilder builder;
+    for (const auto& node : hierarchy.nodes) {
+        builder.addNode(node.name, node.parent);
+    }
+
+    qDebug() << "[ProcessGFiles::extractObjectTree] Packed" << builder.size() << "objects for model ID:" << modelData.id;
+    model->setObjectTreeAsync(modelData.id, builder.encode());
+
+    // The only relational row: which object the thumbnail and reports use
+    const std::string& selected_object_name = hierarchy.selected;
+    if (!selected_object_name.empty()) {
+        ObjectData selectedObjData;
+        selectedObjData.model_id = modelData.id;
+        selectedObjData.name = selected_object_name;
+        selectedObjData.parent_object_id = -1;
+        selectedObjData.is_selected = true;
+        if (model->insertObjectAsync(selectedObjData).get() != -1) {
+            return selected_object_name;
+        }
+        qDebug() << "[ProcessGFiles::extractObjectTree] Failed to insert selected object:"
+                 << QString::fromStdString(selected_object_name) << "for model ID:" << modelData.id;
+    }
+    return builder.size() > 0 ? "all" : "";
+}
 
-    struct directory *parent_dir = db_lookup(gedp->dbip, parentObjData.name.c_str(), LOOKUP_QUIET);
+std::vector<std::string> ProcessGFiles::childObjectNames(struct db_i* dbip, const std::string& parent_name,
+                                                        Hierarchy& hierarchy)
+{
+    std::vector<std::string> children;
+
+    struct directory *parent_dir = db_lookup(dbip, parent_name.c_str(), LOOKUP_QUIET);
     if (!parent_dir) {
-        qDebug() << "[ProcessGFiles::insertChildObjects] Parent object" << QString::fromStdString(parentObjData.name) << "not found in database.";
-        return;
+        qDebug() << "[ProcessGFiles::childObjectNames] Parent object" << QString::fromStdString(parent_name) << "not found in database.";
+        return children;
     }
 
     if (!(parent_dir->d_flags & RT_DIR_COMB)) {
-        qDebug() << "[ProcessGFiles::insertChildObjects] Parent object" << QString::fromStdString(parentObjData.name) << "is not a combination. No children to insert.";
-        return;
+        // Primitives aren't decoded; their attributes are read on their own
+        struct bu_attribute_value_set avs;
+        bu_avs_init_empty(&avs);
+        if (db5_get_attributes(dbip, &avs, parent_dir) == 0) {
+            appendAttributes(parent_name, avs, hierarchy.attributes);
+        }
+        bu_avs_free(&avs);
+        qDebug() << "[ProcessGFiles::childObjectNames] Parent object" << QString::fromStdString(parent_name) << "is not a combination. No children to insert.";
+        return children;
     }
 
     struct rt_db_internal intern;
     struct rt_comb_internal *comb;
-    if (rt_db_get_internal(&intern, parent_dir, gedp->dbip, nullptr, &rt_uniresource) < 0) {
-        qDebug() << "[ProcessGFiles::insertChildObjects] Error retrieving internal representation for object" << QString::fromStdString(parentObjData.name);
-        return;
+    if (rt_db_get_internal(&intern, parent_dir, dbip, nullptr, &rt_uniresource) < 0) {
+        qDebug() << "[ProcessGFiles::childObjectNames] Error retrieving internal representation for object" << QString::fromStdString(parent_name);
+        return children;
     }
 
     comb = static_cast<struct rt_comb_internal*>(intern.idb_ptr);
+    appendAttributes(parent_name, intern.idb_avs, hierarchy.attributes);
+
+    ModelGeometry& geometry = hierarchy.geometry;
+    if (comb->region_flag) {
+        // The shader's name is its first word; the rest are its parameters
+        std::string shader = bu_vls_addr(&comb->shader);
+        shader = shader.substr(0, shader.find_first_of(" \t{"));
+        if (!shader.empty()) {
+            ++geometry.shaders[shader];
+        }
+        if (bu_vls_strlen(&comb->material) > 0) {
+            ++geometry.materials[bu_vls_addr(&comb->material)];
+        }
+    }
 
     if (!comb->tree) {
-        qDebug() << "[ProcessGFiles::insertChildObjects] Combination" << QString::fromStdString(parentObjData.name) << "has no children.";
+        qDebug() << "[ProcessGFiles::childObjectNames] Combination" << QString::fromStdString(parent_name) << "has no children.";
         rt_db_free_internal(&intern);
-        return;
+        return children;
     }
 
-    // Retrieve child objects
-    std::vector<std::string> children;
     db_tree_list_comb_children(comb->tree, children);
+    rt_db_free_internal(&intern);
 
-    qDebug() << "[ProcessGFiles::insertChildObjects] Number of children found for object" << QString::fromStdString(parentObjData.name) << ":" << children.size();
-
-    // Insert each child object into the database
-    for (const auto& child_name : children) {
-        qDebug() << "[ProcessGFiles::insertChildObjects] Processing child object name:" << QString::fromStdString(child_name);
-
-        // Lookup the child's directory entry
-        struct directory *child_dir = db_lookup(gedp->dbip, child_name.c_str(), LOOKUP_QUIET);
-        if (!child_dir) {
-            qDebug() << "[ProcessGFiles::insertChildObjects] Child object" << QString::fromStdString(child_name) << "not found in database.";
-            continue;
-        }
-
-        // Create ObjectData for the child
-        ObjectData childObjData;
-        childObjData.model_id = modelData.id;
-        childObjData.name = child_name;
-        childObjData.parent_object_id = parentObjData.object_id; // The parent's object ID
-        childObjData.is_selected = (child_name == selected_object_name);
-
-        qDebug() << "[ProcessGFiles::insertChildObjects] Inserting child object -"
-                 << "Model ID:" << childObjData.model_id
-                 << ", Name:" << QString::fromStdString(childObjData.name)
-                 << ", Parent Object ID:" << childObjData.parent_object_id
-                 << ", is_selected:" << childObjData.is_selected;
-
-        int childInsertedObjectId = model->insertObject(childObjData);
-        if (childInsertedObjectId == -1) {
-            qDebug() << "[ProcessGFiles::insertChildObjects] Failed to insert child object:"
-                     << QString::fromStdString(childObjData.name)
-                     << "for parent object ID:" << parentObjData.object_id << "model ID:" << childObjData.model_id;
-        } else {
-            childObjData.object_id = childInsertedObjectId;
-            qDebug() << "[ProcessGFiles::insertChildObjects] Successfully inserted child object:"
-                     << QString::fromStdString(childObjData.name)
-                     << "with ID:" << childInsertedObjectId << "for parent object ID:" << parentObjData.object_id << "model ID:" << childObjData.model_id;
+    // Drop references to objects missing from the database
+    children.erase(std::remove_if(children.begin(), children.end(), [dbip](const std::string& child_name) {
+        if (db_lookup(dbip, child_name.c_str(), LOOKUP_QUIET)) {
+            return false;
         }
-    }
-
-    rt_db_free_internal(&intern);
+        qDebug() << "[ProcessGFiles::childObjectNames] Child object" << QString::fromStdString(child_name) << "not found in database.";
+        return true;
+    }), children.end());
 
-    qDebug() << "[ProcessGFiles::insertChildObjects] Completed for parent object ID:" << parentObjData.object_id << "Name:" << QString::fromStdString(parentObjData.name);
+    qDebug() << "[ProcessGFiles::childObjectNames] Number of children found for object" << QString::fromStdString(parent_name) << ":" << children.size();
+    return children;
 }
 
-
 void db_tree_list_comb_children(const union tree *tree, std::vector<std::string>& children) {
     if (!tree) return;
 
@@ -306,38 +604,128 @@ void db_tree_list_comb_children(const union tree *tree, std::vector<std::string>
 }
 
 
-bool ProcessGFiles::generateThumbnail(ModelData& modelData, const std::string& selected_object_name)
+int64_t ProcessGFiles::estimateRenderCost(int64_t fileSize)
 {
-    qDebug() << "[ProcessGFiles::generateThumbnail] Started for model ID:" << modelData.id
-             << "with selected object:" << QString::fromStdString(selected_object_name);
+    size_t primitives = static_cast<size_t>(std::max<int64_t>(fileSize / kBytesPerPrimitive, 1));
+    return estimateRenderCost(primitives, primitives);
+}
+
+int64_t ProcessGFiles::estimateRenderCost(size_t primitives, size_t instances)
+{
+    double rays = static_cast<double>(kThumbnailSize) * kThumbnailSize;
+    double rayMs = rays * kRayMicroseconds * (1.0 + std::log2(1.0 + primitives)) / 1000.0;
+    double prepMs = instances * kPrepMicrosecondsPerInstance / 1000.0;
+    return std::max<int64_t>(static_cast<int64_t>(rayMs + prepMs), 1);
+}
 
+int64_t ProcessGFiles::estimateFirstPassCost(int64_t fileSize, int64_t renderCost)
+{
+    int64_t pixelRatio = (kThumbnailSize / kPreviewSize) * (kThumbnailSize / kPreviewSize);
+    return fileSize / kBytesReadPerMillisecond + renderCost / pixelRatio;
+}
+
+std::chrono::milliseconds ProcessGFiles::renderTimeLimit(int64_t renderCost, int size)
+{
     QSettings settings;
-    int timeLimitMs = settings.value("previewTimer", 30).toInt() * 1000;
+    std::chrono::milliseconds ceiling(settings.value("previewTimer", 30).toInt() * 1000);
+    if (renderCost <= 0) {
+        return ceiling;
+    }
+
+    double scale = static_cast<double>(size) * size / (static_cast<double>(kThumbnailSize) * kThumbnailSize);
+    std::chrono::milliseconds limit(static_cast<int64_t>(kTimeLimitFactor * renderCost * scale));
+    return std::min(std::max(limit, kMinRenderTimeLimit), ceiling);
+}
+
+size_t ProcessGFiles::countPrimitives(struct db_i* dbip)
+{
+    size_t primitives = 0;
+    if (!dbip) {
+        return primitives;
+    }
+    struct directory* dp;
+    FOR_ALL_DIRECTORY_START(dp, dbip) {
+        if ((dp->d_flags & RT_DIR_SOLID) && !(dp->d_flags & RT_DIR_HIDDEN)) {
+            ++primitives;
+        }
+    } FOR_ALL_DIRECTORY_END;
+    return primitives;
+}
+
+void ProcessGFiles::countGeometry(struct db_i* dbip, ModelGeometry& geometry)
+{
+    if (!dbip) {
+        return;
+    }
+    struct directory* dp;
+    FOR_ALL_DIRECTORY_START(dp, dbip) {
+        if (dp->d_flags & RT_DIR_HIDDEN) {
+            continue;
+        }
+        if (dp->d_flags & RT_DIR_SOLID) {
+            ++geometry.primitives;
+            if (dp->d_minor_type > 0 && dp->d_minor_type <= ID_MAX_SOLID) {
+                ++geometry.primitive_types[OBJ[dp->d_minor_type].ft_label];
+            }
+        } else if (dp->d_flags & RT_DIR_COMB) {
+            ++geometry.combinations;
+            if (dp->d_flags & RT_DIR_REGION) {
+                ++geometry.regions;
+            }
+        }
+    } FOR_ALL_DIRECTORY_END;
+
+    // Coordinates are stored in mm whatever the units the model was made in
+    const char* units = bu_units_string(dbip->dbi_local2base);
+    if (units) {
+        geometry.units = units;
+    }
+}
+
+RenderCache::Key ProcessGFiles::thumbnailKey(uint64_t contentHash, const std::string& object, bool inProcess, int size)
+{
+    return {contentHash, object, inProcess ? "librt az35 el25 ortho" : "rt default", size, "png"};
+}
+
+bool ProcessGFiles::generateThumbnail(const ModelData& modelData, const std::string& selected_object_name, int size,
+                                      std::chrono::milliseconds timeLimit, const RenderCache::Key& cacheKey,
+                                      std::string& failureReason)
+{
+    qDebug() << "[ProcessGFiles::generateThumbnail] Started for model ID:" << modelData.id
+             << "with selected object:" << QString::fromStdString(selected_object_name)
+             << "time limit:" << timeLimit.count() << "ms";
+
+    int timeLimitMs = static_cast<int>(timeLimit.count());
 
     if (selected_object_name.empty()) {
         qDebug() << "[ProcessGFiles::generateThumbnail] No valid object selected for raytrace in file:"
                  << QString::fromStdString(modelData.file_path);
+        failureReason = "No object selected to render";
         return false;
     }
 
     // Ensure the .g file path is present in modelData
     if (modelData.file_path.empty()) {
         qDebug() << "[ProcessGFiles::generateThumbnail] No file path available in modelData for generating thumbnail.";
+        failureReason = "No file path";
         return false;
     }
 
     QString previewsFolder = QString::fromStdString(model->getHiddenDirectoryPath() + "/previews");
+    // Workers render at the same time, and stems repeat across directories;
+    // the model id and size keep each render's file its own
     QString modelShortName = QString::fromStdString(std::filesystem::path(modelData.file_path).stem().string());
-    QString pngFilePath = previewsFolder + "/" + modelShortName + ".png";
+    QString pngFilePath = previewsFolder + "/" + modelShortName + "-" + QString::number(modelData.id) + "-" +
+                          QString::number(size) + ".png";
     QDir().mkpath(QFileInfo(pngFilePath).absolutePath());
 
     // Use the RT_EXECUTABLE_PATH from configuration
     QString rtExecutable = QStringLiteral(RT_EXECUTABLE_PATH);
 
     // Construct the rt command
-    // -s512 sets image size to 512x512
+    // -s sets the image size, e.g. -s512 for 512x512
     // -o outputs the raytraced image to the specified file
-    QString rtCommand = rtExecutable + " -s512 -o \"" + pngFilePath + "\" \"" +
+    QString rtCommand = rtExecutable + " -s" + QString::number(size) + " -o \"" + pngFilePath + "\" \"" +
                         QString::fromStdString(modelData.file_path) + "\" " +
                         QString::fromStdString(selected_object_name);
 
@@ -351,6 +739,7 @@ bool ProcessGFiles::generateThumbnail(ModelData& modelData, const std::string& s
     process.start();
     if (!process.waitForStarted()) {
         qDebug() << "[ProcessGFiles::generateThumbnail] Failed to start the process for command:" << rtCommand;
+        failureReason = "Could not start rt";
         return false;
     }
 
@@ -358,9 +747,10 @@ bool ProcessGFiles::generateThumbnail(ModelData& modelData, const std::string& s
 
     if (!finishedInTime) {
         // The process did not finish in the allotted time
-        qDebug() << "[ProcessGFiles::generateThumbnail] Command timed out after" << timeLimitMs / 1000 << "seconds.";
+        qDebug() << "[ProcessGFiles::generateThumbnail] Command timed out after" << timeLimitMs << "ms.";
         process.kill();
         process.waitForFinished();
+        failureReason = "rt timed out after " + std::to_string(timeLimitMs) + " ms";
         return false;
     }
 
@@ -368,6 +758,7 @@ bool ProcessGFiles::generateThumbnail(ModelData& modelData, const std::string& s
     if (exitCode != 0) {
         qDebug() << "[ProcessGFiles::generateThumbnail] The process finished with a non-zero exit code:" << exitCode;
         qDebug() << "[ProcessGFiles::generateThumbnail] Error output:" << process.readAllStandardOutput();
+        failureReason = "rt exited with code " + std::to_string(exitCode);
         return false;
     }
 
@@ -375,29 +766,25 @@ bool ProcessGFiles::generateThumbnail(ModelData& modelData, const std::string& s
     if (!QFile::exists(pngFilePath) || QFileInfo(pngFilePath).size() == 0) {
         qDebug() << "[ProcessGFiles::generateThumbnail] Generated thumbnail file is empty or missing at path:"
                  << pngFilePath;
+        failureReason = "rt produced no image";
         return false;
     }
 
-    // Read the generated thumbnail data
-    QFile thumbnailFile(pngFilePath);
-    if (!thumbnailFile.open(QIODevice::ReadOnly)) {
-        qDebug() << "[ProcessGFiles::generateThumbnail] Failed to open thumbnail file at:"
-                 << pngFilePath;
-        return false;
-    }
+    model->renderCache().storeFile(cacheKey, pngFilePath.toStdString());
 
-    QByteArray thumbnailData = thumbnailFile.readAll();
-    thumbnailFile.close();
-
-    if (thumbnailData.isEmpty()) {
-        qDebug() << "[ProcessGFiles::generateThumbnail] Generated thumbnail data is empty.";
+    // Stream the PNG into the catalog in chunks rather than reading it into
+    // memory first, with its smaller levels; wait for it so the file can be
+    // removed afterwards
+    std::map<int, QByteArray> levels = Model::encodeThumbnailLevels(QImage(pngFilePath));
+    if (!model->writeThumbnailFileAsync(modelData.id, pngFilePath.toStdString(), std::move(levels)).get()) {
+        qDebug() << "[ProcessGFiles::generateThumbnail] Failed to store thumbnail from:"
+                 << pngFilePath;
+        failureReason = "Could not store the rendered image";
+        QFile::remove(pngFilePath);
         return false;
     }
 
-    // convert thumbnail data to std::vector<char>
-    modelData.thumbnail.assign(thumbnailData.begin(), thumbnailData.end());
-
-    // delete the PNG file after loading it
+    // delete the PNG file after storing it
     if (!QFile::remove(pngFilePath)) {
         qDebug() << "[ProcessGFiles::generateThumbnail] Could not remove PNG file at" << pngFilePath;
     }
@@ -408,6 +795,48 @@ bool ProcessGFiles::generateThumbnail(ModelData& modelData, const std::string& s
     return true;
 }
 
+bool ProcessGFiles::renderThumbnail(const ModelData& modelData, ThumbnailRenderer& renderer, int size,
+                                    std::chrono::milliseconds timeLimit, const RenderCache::Key& cacheKey,
+                                    std::string& failureReason)
+{
+    qDebug() << "[ProcessGFiles::renderThumbnail] Started for model ID:" << modelData.id
+             << "with selected object:" << QString::fromStdString(renderer.object())
+             << "time limit:" << timeLimit.count() << "ms";
+
+    auto deadline = std::chrono::steady_clock::now() + timeLimit;
+
+    QImage image;
+    ThumbnailRenderer::Result result = renderer.render(size, deadline, cancel, image, failureReason);
+    if (result == ThumbnailRenderer::Result::TimedOut) {
+        failureReason = "Render timed out after " + std::to_string(timeLimit.count()) + " ms";
+    }
+    if (result != ThumbnailRenderer::Result::Done) {
+        qDebug() << "[ProcessGFiles::renderThumbnail] Render failed:" << QString::fromStdString(failureReason);
+        return false;
+    }
+
+    // Encoded in memory; no temporary file
+    QByteArray png;
+    QBuffer buffer(&png);
+    buffer.open(QIODevice::WriteOnly);
+    if (!image.save(&buffer, "PNG")) {
+        failureReason = "Could not encode the rendered image";
+        return false;
+    }
+    buffer.close();
+    model->renderCache().store(cacheKey, png.toStdString());
+
+    // The smaller levels come from the rendered pixels, not the PNG
+    if (!model->writeThumbnailAsync(modelData.id, png, Model::encodeThumbnailLevels(image)).get()) {
+        qDebug() << "[ProcessGFiles::renderThumbnail] Failed to store thumbnail for model ID:" << modelData.id;
+        failureReason = "Could not store the rendered image";
+        return false;
+    }
+
+    qDebug() << "[ProcessGFiles::renderThumbnail] Thumbnail rendered and stored for model with ID:" << modelData.id;
+    return true;
+}
+
 std::tuple<bool, std::string, std::string> ProcessGFiles::generateGistReport(const std::string& inputFilePath, const std::string& outputFilePath, const std::string& primary_obj, const std::string& label)
 {
     std::string gistCommand;
@@ -2,29 +2,110 @@
 #define PROCESSGFILES_H
 
 #include <filesystem>
+#include <atomic>
+#include <chrono>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "Model.h"
 #include <brlcad/rt/geom.h>
 
+class ThumbnailRenderer;
+
 class ProcessGFiles {
 public:
-    explicit ProcessGFiles(Model* model);
-    void processGFile(const ModelData& modelData);
+    // Renders stop early once cancel, if given, is set
+    explicit ProcessGFiles(Model* model, const std::atomic<bool>* cancel = nullptr);
+    // Runs the requested Model::ProcessingStage bits and records each outcome
+    void processGFile(const ModelData& modelData, unsigned int stages = Model::IndexingStages);
+    // Full-size render time estimates in milliseconds: from the file size
+    // alone, before the file is read, and from the primitives it holds and
+    // how many times they are instanced. Rough, but they order jobs.
+    static int64_t estimateRenderCost(int64_t fileSize);
+    static int64_t estimateRenderCost(size_t primitives, size_t instances);
+    // Estimated time for everything but the full-size render
+    static int64_t estimateFirstPassCost(int64_t fileSize, int64_t renderCost);
+    // Time allowed for a size px render of a model whose full-size render
+    // took renderCost ms when last measured: a few times that, within
+    // kMinRenderTimeLimit and the "previewTimer" setting. Estimates are
+    // only good enough to order jobs, so without a measurement (0) the
+    // limit is the setting.
+    static std::chrono::milliseconds renderTimeLimit(int64_t renderCost, int size);
+    // The full-size render estimate of the last processGFile call, refined
+    // by whatever it rendered; 0 if it rendered nothing
+    int64_t lastRenderCost() const { return renderCost; }
+
     std::tuple<bool, std::string, std::string> generateGistReport(const std::string& inputFilePath, const std::string& outputFilePath, const std::string& primary_obj, const std::string& label);
 
 private:
-    void extractTitle(ModelData& modelData, struct ged* gedp);
-    void extractObjects(ModelData& modelData, struct ged* gedp);
-    void insertChildObjects(ModelData& modelData, struct ged* gedp, const ObjectData& parentObjData, const std::string& selected_object_name);
+    // The object tree as read from the .g file, so it can be written to the
+    // catalog after the database is closed
+    struct Hierarchy {
+        struct Node {
+            std::string name;
+            int parent;  // index into nodes, -1 for top-level
+        };
+        std::vector<Node> nodes;  // preorder
+        std::string selected;  // the top-level object to render, "" if there are none
+        ModelGeometry geometry;  // shaders and materials of the regions walked
+        std::vector<ObjectAttribute> attributes;  // of every object walked, and global
+    };
+
+    // Opens path read-only with only librt's directory built: no GED
+    // context, whose command tables and callbacks the catalog never uses.
+    // DBI_NULL if it can't be read; close with db_close.
+    static struct db_i* openDatabase(const std::string& path);
+    void extractTitle(ModelData& modelData, struct db_i* dbip);
+    Hierarchy readHierarchy(const ModelData& modelData, struct db_i* dbip);
+    // Inserts every object of the hierarchy in one bulk write; returns the
+    // object to render the thumbnail from, or "" if nothing was inserted
+    std::string extractObjects(ModelData& modelData, const Hierarchy& hierarchy);
+    // Packed variant of extractObjects: stores the hierarchy as an ObjectTree
+    // blob and inserts only the selected object as a row
+    std::string extractObjectTree(ModelData& modelData, const Hierarchy& hierarchy);
+    // Names of a combination's members that exist in the database. The
+    // object's attributes, and a region's shader and material, are added
+    // to hierarchy on the way.
+    std::vector<std::string> childObjectNames(struct db_i* dbip, const std::string& parent_name,
+                                              Hierarchy& hierarchy);
+    // Primitive, region and combination counts and the database units
+    static void countGeometry(struct db_i* dbip, ModelGeometry& geometry);
 
     // Thumbnail generation and command utility methods
-    bool generateThumbnail(ModelData& modelData, const std::string& selected_object_name);
+    // Both store what they render in the render cache under cacheKey
+    bool generateThumbnail(const ModelData& modelData, const std::string& selected_object_name, int size,
+                           std::chrono::milliseconds timeLimit, const RenderCache::Key& cacheKey,
+                           std::string& failureReason);
+    // In-process alternative to generateThumbnail, with a prepared renderer
+    bool renderThumbnail(const ModelData& modelData, ThumbnailRenderer& renderer, int size,
+                         std::chrono::milliseconds timeLimit, const RenderCache::Key& cacheKey,
+                         std::string& failureReason);
+    // Primitives (solids) in the database, each counted once
+    static size_t countPrimitives(struct db_i* dbip);
+    // Render cache key for a thumbnail of object at size; the view is the
+    // renderer's, since librt's shading differs from rt's
+    static RenderCache::Key thumbnailKey(uint64_t contentHash, const std::string& object, bool inProcess, int size);
+
+    // Frees a renderer under brlcadMutex, which must not already be held
+    struct RendererRelease {
+        void operator()(ThumbnailRenderer* renderer) const;
+    };
+    using RendererPtr = std::unique_ptr<ThumbnailRenderer, RendererRelease>;
 
+    static constexpr int kPreviewSize = 64;     // Model::PreviewStage
+    static constexpr int kThumbnailSize = 512;  // Model::ThumbnailStage
+    // Even a tiny estimate gets this long; process start-up and prep aren't
+    // in it
+    static constexpr std::chrono::milliseconds kMinRenderTimeLimit{5000};
 
     Model* model;
+    const std::atomic<bool>* cancel;
+    int64_t renderCost = 0;
+    // Held around every in-process librt call; see ProcessGFiles.cpp
+    static std::mutex brlcadMutex;
 };
 
 void db_tree_list_comb_children(const union tree *tree, std::vector<std::string>& children);
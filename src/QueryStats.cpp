@@ -0,0 +1,245 @@
+#include "QueryStats.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+// Eight buckets per power of two; values below 8ns are exact
+constexpr unsigned int kSubBucketBits = 3;
+constexpr uint64_t kSubBuckets = 1u << kSubBucketBits;
+
+void appendJsonString(std::string& out, const std::string& text) {
+  out += '"';
+  for (char c : text) {
+    switch (c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          out += escaped;
+        } else {
+          out += c;
+        }
+    }
+  }
+  out += '"';
+}
+
+void appendJsonNumber(std::string& out, double value) {
+  char number[32];
+  std::snprintf(number, sizeof(number), "%.3f", value);
+  out += number;
+}
+
+bool isIdentifierChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+}  // namespace
+
+QueryStats& QueryStats::global() {
+  static QueryStats stats;
+  return stats;
+}
+
+void QueryStats::attach(sqlite3* conn) {
+  if (!conn || !isEnabled()) return;
+  sqlite3_trace_v2(conn,
+                   SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW,
+                   &QueryStats::trace, this);
+}
+
+int QueryStats::trace(unsigned int type, void* context, void* p, void* x) {
+  auto* stats = static_cast<QueryStats*>(context);
+  auto* stmt = static_cast<sqlite3_stmt*>(p);
+  if (type == SQLITE_TRACE_STMT) {
+    // Also reported, with the trigger's name as the text, each time a
+    // trigger runs inside the statement; only the statement's own start
+    // begins a run
+    const char* text = static_cast<const char*>(x);
+    const char* sql = sqlite3_sql(stmt);
+    if (text && sql && std::strcmp(text, sql) == 0) stats->startRun(stmt);
+  } else if (type == SQLITE_TRACE_ROW) {
+    stats->countRow(stmt);
+  } else if (type == SQLITE_TRACE_PROFILE) {
+    stats->record(stmt, static_cast<uint64_t>(*static_cast<sqlite3_int64*>(x)));
+  }
+  return 0;
+}
+
+void QueryStats::startRun(sqlite3_stmt* stmt) {
+  // A statement finalized part-way through never reports a profile, and
+  // its address can come back for the next one prepared
+  std::lock_guard<std::mutex> lock(statsMutex);
+  rowsInFlight.erase(stmt);
+}
+
+void QueryStats::countRow(sqlite3_stmt* stmt) {
+  std::lock_guard<std::mutex> lock(statsMutex);
+  ++rowsInFlight[stmt];
+}
+
+void QueryStats::record(sqlite3_stmt* stmt, uint64_t ns) {
+  // Normalize outside the lock; it is the expensive part
+  std::string sql = normalize(sqlite3_sql(stmt));
+
+  std::lock_guard<std::mutex> lock(statsMutex);
+  Template& entry = templates[sql];
+  entry.calls++;
+  entry.totalNs += ns;
+  entry.maxNs = std::max(entry.maxNs, ns);
+  size_t bucket = bucketFor(ns);
+  if (entry.histogram.size() <= bucket) entry.histogram.resize(bucket + 1);
+  entry.histogram[bucket]++;
+
+  auto rows = rowsInFlight.find(stmt);
+  if (rows != rowsInFlight.end()) {
+    entry.rows += rows->second;
+    rowsInFlight.erase(rows);
+  }
+}
+
+void QueryStats::reset() {
+  std::lock_guard<std::mutex> lock(statsMutex);
+  templates.clear();
+  rowsInFlight.clear();
+}
+
+size_t QueryStats::bucketFor(uint64_t ns) {
+  if (ns < kSubBuckets) return static_cast<size_t>(ns);
+  unsigned int msb = 63;
+  while (!(ns >> msb)) --msb;
+  unsigned int shift = msb - kSubBucketBits;
+  return static_cast<size_t>((msb - kSubBucketBits + 1) * kSubBuckets +
+                             ((ns >> shift) & (kSubBuckets - 1)));
+}
+
+uint64_t QueryStats::bucketValue(size_t bucket) {
+  if (bucket < kSubBuckets) return bucket;
+  unsigned int shift = static_cast<unsigned int>(bucket / kSubBuckets) - 1;
+  uint64_t low = (kSubBuckets + bucket % kSubBuckets) << shift;
+  // Middle of the bucket's range
+  return low + ((uint64_t{1} << shift) >> 1);
+}
+
+double QueryStats::percentile(const Template& entry, double fraction) {
+  uint64_t rank = static_cast<uint64_t>(fraction * entry.calls + 0.999999);
+  rank = std::max<uint64_t>(rank, 1);
+  uint64_t seen = 0;
+  for (size_t bucket = 0; bucket < entry.histogram.size(); ++bucket) {
+    seen += entry.histogram[bucket];
+    if (seen >= rank) {
+      return std::min(bucketValue(bucket), entry.maxNs) / 1e6;
+    }
+  }
+  return entry.maxNs / 1e6;
+}
+
+std::vector<QueryTemplateStats> QueryStats::snapshot() const {
+  std::vector<QueryTemplateStats> result;
+  std::lock_guard<std::mutex> lock(statsMutex);
+  result.reserve(templates.size());
+  for (const auto& [sql, entry] : templates) {
+    QueryTemplateStats stats;
+    stats.sql = sql;
+    stats.calls = entry.calls;
+    stats.rows = entry.rows;
+    stats.totalMs = entry.totalNs / 1e6;
+    stats.p50Ms = percentile(entry, 0.50);
+    stats.p99Ms = percentile(entry, 0.99);
+    stats.maxMs = entry.maxNs / 1e6;
+    result.push_back(std::move(stats));
+  }
+  std::sort(result.begin(), result.end(),
+            [](const QueryTemplateStats& a, const QueryTemplateStats& b) {
+              return a.totalMs > b.totalMs;
+            });
+  return result;
+}
+
+std::string QueryStats::toJson() const {
+  std::string out = "{\"queries\": [";
+  bool first = true;
+  for (const auto& stats : snapshot()) {
+    out += first ? "\n  {" : ",\n  {";
+    first = false;
+    out += "\"sql\": ";
+    appendJsonString(out, stats.sql);
+    out += ", \"calls\": " + std::to_string(stats.calls);
+    out += ", \"rows\": " + std::to_string(stats.rows);
+    out += ", \"total_ms\": ";
+    appendJsonNumber(out, stats.totalMs);
+    out += ", \"p50_ms\": ";
+    appendJsonNumber(out, stats.p50Ms);
+    out += ", \"p99_ms\": ";
+    appendJsonNumber(out, stats.p99Ms);
+    out += ", \"max_ms\": ";
+    appendJsonNumber(out, stats.maxMs);
+    out += "}";
+  }
+  out += first ? "]}\n" : "\n]}\n";
+  return out;
+}
+
+std::string QueryStats::normalize(const char* sql) {
+  std::string out;
+  if (!sql) return out;
+
+  auto placeholder = [&out]() {
+    // (?, ?, ?) and (?,?) collapse into one placeholder
+    size_t end = out.size();
+    if (end >= 3 && out.compare(end - 3, 3, "?, ") == 0) {
+      out.resize(end - 2);
+    } else if (end >= 2 && out.compare(end - 2, 2, "?,") == 0) {
+      out.resize(end - 1);
+    } else {
+      out += '?';
+    }
+  };
+
+  for (const char* c = sql; *c;) {
+    unsigned char ch = static_cast<unsigned char>(*c);
+    if (std::isspace(ch)) {
+      while (*c && std::isspace(static_cast<unsigned char>(*c))) ++c;
+      if (!out.empty() && out.back() != '(' && *c != ')' && *c) out += ' ';
+    } else if (ch == '\'') {
+      // String literal, '' being an escaped quote
+      ++c;
+      while (*c) {
+        if (*c == '\'' && c[1] == '\'') {
+          c += 2;
+        } else if (*c == '\'') {
+          ++c;
+          break;
+        } else {
+          ++c;
+        }
+      }
+      placeholder();
+    } else if (std::isdigit(ch) && (out.empty() || !isIdentifierChar(out.back()))) {
+      while (*c && (isIdentifierChar(*c) || *c == '.')) ++c;
+      placeholder();
+    } else if (ch == '?' && !std::isdigit(static_cast<unsigned char>(c[1]))) {
+      ++c;
+      placeholder();
+    } else if (ch == '?') {
+      // Numbered parameters (?1) keep their numbers
+      out += *c++;
+      while (*c && std::isdigit(static_cast<unsigned char>(*c))) out += *c++;
+    } else {
+      out += *c++;
+    }
+  }
+
+  while (!out.empty() && (out.back() == ' ' || out.back() == ';')) {
+    out.pop_back();
+  }
+  return out;
+}
@@ -0,0 +1,76 @@
+#ifndef QUERYSTATS_H
+#define QUERYSTATS_H
+
+#include <sqlite3.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Timings for every execution of one statement template
+struct QueryTemplateStats {
+  std::string sql;  // normalized, see QueryStats::normalize()
+  uint64_t calls = 0;
+  uint64_t rows = 0;
+  double totalMs = 0;
+  double p50Ms = 0;
+  double p99Ms = 0;
+  double maxMs = 0;
+};
+
+// Per-statement latency collected through sqlite3_trace_v2. Connections
+// are attached as they are opened, and only while collection is enabled,
+// so normal runs pay nothing. Statements are grouped by their SQL with
+// literals and whitespace normalized away; latencies go into log-scale
+// histograms (about 12% resolution), so memory stays fixed per template.
+class QueryStats {
+ public:
+  // The process-wide collector that Model attaches its connections to
+  static QueryStats& global();
+
+  // Must be enabled before the connections to time are opened
+  void setEnabled(bool on) { enabled.store(on); }
+  bool isEnabled() const { return enabled.load(); }
+  // Starts tracing conn if collection is enabled
+  void attach(sqlite3* conn);
+
+  void reset();
+  // Slowest total time first
+  std::vector<QueryTemplateStats> snapshot() const;
+  // {"queries": [{"sql": ..., "calls": ..., "rows": ..., "total_ms": ...,
+  //   "p50_ms": ..., "p99_ms": ..., "max_ms": ...}, ...]}
+  std::string toJson() const;
+
+  // Collapses whitespace, replaces numeric and string literals with ? and
+  // folds placeholder lists like (?, ?, ?) into (?)
+  static std::string normalize(const char* sql);
+
+ private:
+  struct Template {
+    uint64_t calls = 0;
+    uint64_t rows = 0;
+    uint64_t totalNs = 0;
+    uint64_t maxNs = 0;
+    std::vector<uint64_t> histogram;  // by bucketFor()
+  };
+
+  static int trace(unsigned int type, void* context, void* p, void* x);
+  static size_t bucketFor(uint64_t ns);
+  static uint64_t bucketValue(size_t bucket);
+  static double percentile(const Template& entry, double fraction);
+
+  void countRow(sqlite3_stmt* stmt);
+  void startRun(sqlite3_stmt* stmt);
+  void record(sqlite3_stmt* stmt, uint64_t ns);
+
+  std::atomic<bool> enabled{false};
+  mutable std::mutex statsMutex;
+  std::map<std::string, Template> templates;
+  std::unordered_map<sqlite3_stmt*, uint64_t> rowsInFlight;
+};
+
+#endif  // QUERYSTATS_H
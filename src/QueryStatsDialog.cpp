@@ -0,0 +1,119 @@
+#include "QueryStatsDialog.h"
+#include "QueryStats.h"
+
+#include <QDialogButtonBox>
+#include <QFile>
+#include <QFileDialog>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <cmath>
+
+namespace {
+
+// Stored as numbers rather than text so the columns sort numerically
+QTableWidgetItem* numberItem(const QVariant& value) {
+    QTableWidgetItem* item = new QTableWidgetItem();
+    item->setData(Qt::DisplayRole, value);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+QVariant millis(double ms) {
+    return std::round(ms * 1000.0) / 1000.0;
+}
+
+}  // namespace
+
+QueryStatsDialog::QueryStatsDialog(QWidget* parent) : QDialog(parent) {
+    setWindowTitle("Database Statistics");
+    resize(900, 500);
+
+    summary = new QLabel();
+
+    table = new QTableWidget(0, 7);
+    table->setHorizontalHeaderLabels({"Calls", "Rows", "Total ms", "p50 ms", "p99 ms", "Max ms", "Statement"});
+    table->horizontalHeader()->setSectionResizeMode(6, QHeaderView::Stretch);
+    table->verticalHeader()->hide();
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setWordWrap(false);
+
+    QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Close);
+    QPushButton* refreshButton = buttons->addButton("Refresh", QDialogButtonBox::ActionRole);
+    QPushButton* resetButton = buttons->addButton("Reset", QDialogButtonBox::ResetRole);
+    QPushButton* saveButton = buttons->addButton("Save JSON...", QDialogButtonBox::ActionRole);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout();
+    mainLayout->addWidget(summary);
+    mainLayout->addWidget(table);
+    mainLayout->addWidget(buttons);
+    setLayout(mainLayout);
+
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(refreshButton, &QPushButton::clicked, this, &QueryStatsDialog::refresh);
+    connect(resetButton, &QPushButton::clicked, this, &QueryStatsDialog::resetStats);
+    connect(saveButton, &QPushButton::clicked, this, &QueryStatsDialog::saveJson);
+
+    refresh();
+}
+
+void QueryStatsDialog::refresh() {
+    QueryStats& stats = QueryStats::global();
+    if (!stats.isEnabled()) {
+        summary->setText("Statement timing is off. Start CADventory with --db-stats to collect it.");
+        table->setRowCount(0);
+        return;
+    }
+
+    std::vector<QueryTemplateStats> templates = stats.snapshot();
+    uint64_t calls = 0;
+    double totalMs = 0;
+
+    table->setSortingEnabled(false);
+    table->setRowCount(static_cast<int>(templates.size()));
+    for (int row = 0; row < static_cast<int>(templates.size()); ++row) {
+        const QueryTemplateStats& entry = templates[row];
+        calls += entry.calls;
+        totalMs += entry.totalMs;
+        table->setItem(row, 0, numberItem(static_cast<qulonglong>(entry.calls)));
+        table->setItem(row, 1, numberItem(static_cast<qulonglong>(entry.rows)));
+        table->setItem(row, 2, numberItem(millis(entry.totalMs)));
+        table->setItem(row, 3, numberItem(millis(entry.p50Ms)));
+        table->setItem(row, 4, numberItem(millis(entry.p99Ms)));
+        table->setItem(row, 5, numberItem(millis(entry.maxMs)));
+        QTableWidgetItem* sqlItem = new QTableWidgetItem(QString::fromStdString(entry.sql));
+        sqlItem->setToolTip(sqlItem->text());
+        table->setItem(row, 6, sqlItem);
+    }
+    table->setSortingEnabled(true);
+    table->resizeColumnsToContents();
+    table->horizontalHeader()->setSectionResizeMode(6, QHeaderView::Stretch);
+
+    summary->setText(QString("%1 statements in %2 templates, %3 ms in total")
+                         .arg(calls)
+                         .arg(templates.size())
+                         .arg(totalMs, 0, 'f', 1));
+}
+
+void QueryStatsDialog::resetStats() {
+    QueryStats::global().reset();
+    refresh();
+}
+
+void QueryStatsDialog::saveJson() {
+    QString fileName = QFileDialog::getSaveFileName(this, "Save Database Statistics",
+                                                    "cadventory-db-stats.json",
+                                                    "JSON files (*.json)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QMessageBox::warning(this, "Save Failed", "Could not write " + fileName);
+        return;
+    }
+    file.write(QByteArray::fromStdString(QueryStats::global().toJson()));
+}
@@ -0,0 +1,26 @@
+#ifndef QUERYSTATSDIALOG_H
+#define QUERYSTATSDIALOG_H
+
+#include <QDialog>
+#include <QLabel>
+#include <QTableWidget>
+
+// Debug view of the statement timings collected by QueryStats when
+// CADventory runs with --db-stats
+class QueryStatsDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit QueryStatsDialog(QWidget* parent = nullptr);
+
+private slots:
+    void refresh();
+    void resetStats();
+    void saveJson();
+
+private:
+    QTableWidget* table;
+    QLabel* summary;
+};
+
+#endif // QUERYSTATSDIALOG_H
@@ -0,0 +1,86 @@
+#include "ReadConnectionPool.h"
+#include "QueryStats.h"
+
+#include <iostream>
+
+ReadConnectionPool::ReadConnectionPool(const std::string& dbPath, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    sqlite3* conn = nullptr;
+    int flags = SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX;
+    if (sqlite3_open_v2(dbPath.c_str(), &conn, flags, nullptr) != SQLITE_OK) {
+      std::cerr << "Can't open read connection to " << dbPath << ": "
+                << sqlite3_errmsg(conn) << std::endl;
+      sqlite3_close(conn);
+      break;
+    }
+    sqlite3_busy_timeout(conn, 5000);
+    QueryStats::global().attach(conn);
+    connections.push_back(conn);
+  }
+  idle = connections;
+}
+
+ReadConnectionPool::~ReadConnectionPool() {
+  std::unique_lock<std::mutex> lock(poolMutex);
+  // Wait for outstanding leases so no connection is closed mid-query
+  connectionReleased.wait(lock,
+                          [this] { return idle.size() == connections.size(); });
+  for (sqlite3* conn : connections) {
+    sqlite3_close(conn);
+  }
+}
+
+sqlite3* ReadConnectionPool::acquire() {
+  std::unique_lock<std::mutex> lock(poolMutex);
+  if (connections.empty()) {
+    return nullptr;
+  }
+  auto held = leased.find(std::this_thread::get_id());
+  if (held != leased.end()) {
+    ++held->second.second;
+    return held->second.first;
+  }
+  connectionReleased.wait(lock, [this] { return !idle.empty(); });
+  sqlite3* conn = idle.back();
+  idle.pop_back();
+  leased[std::this_thread::get_id()] = {conn, 1};
+  return conn;
+}
+
+void ReadConnectionPool::release(sqlite3* conn) {
+  {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    auto held = leased.find(std::this_thread::get_id());
+    if (held == leased.end() || held->second.first != conn) {
+      std::cerr << "Read connection released by a thread that does not hold it"
+                << std::endl;
+      return;
+    }
+    if (--held->second.second > 0) {
+      return;
+    }
+    leased.erase(held);
+    idle.push_back(conn);
+  }
+  connectionReleased.notify_all();
+}
+
+ReadLease::ReadLease(ReadConnectionPool* pool, sqlite3* conn)
+    : pool(pool), conn(conn) {}
+
+ReadLease::ReadLease(std::recursive_mutex& writerMutex, sqlite3* writer)
+    : pool(nullptr), conn(writer), writerLock(writerMutex) {}
+
+ReadLease::ReadLease(ReadLease&& other) noexcept
+    : pool(other.pool),
+      conn(other.conn),
+      writerLock(std::move(other.writerLock)) {
+  other.pool = nullptr;
+  other.conn = nullptr;
+}
+
+ReadLease::~ReadLease() {
+  if (pool && conn) {
+    pool->release(conn);
+  }
+}
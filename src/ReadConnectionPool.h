@@ -0,0 +1,60 @@
+#ifndef READCONNECTIONPOOL_H
+#define READCONNECTIONPOOL_H
+
+#include <sqlite3.h>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Fixed set of read-only connections to a WAL database, so readers on the
+// UI or report threads never queue behind the writer connection
+class ReadConnectionPool {
+ public:
+  ReadConnectionPool(const std::string& dbPath, size_t size);
+  ReadConnectionPool(const ReadConnectionPool&) = delete;
+  ~ReadConnectionPool();
+
+  // Blocks until a connection is idle; nullptr if none could be opened.
+  // A thread that already holds a connection gets the same one back, so
+  // nested reads never wait on a lease their own caller is holding.
+  sqlite3* acquire();
+  void release(sqlite3* conn);
+
+  size_t size() const { return connections.size(); }
+
+ private:
+  std::mutex poolMutex;
+  std::condition_variable connectionReleased;
+  std::vector<sqlite3*> connections;
+  std::vector<sqlite3*> idle;
+
+  // Connections on loan, by the thread that took them, with their lease count
+  std::map<std::thread::id, std::pair<sqlite3*, int>> leased;
+};
+
+// Connection borrowed for one read. Either a pooled read-only connection or,
+// when the calling thread has a write transaction open, the writer itself
+// held under its mutex so the read sees the uncommitted rows. A pooled lease
+// must be released on the thread that acquired it.
+class ReadLease {
+ public:
+  ReadLease(ReadConnectionPool* pool, sqlite3* conn);
+  ReadLease(std::recursive_mutex& writerMutex, sqlite3* writer);
+  ReadLease(ReadLease&& other) noexcept;
+  ReadLease(const ReadLease&) = delete;
+  ReadLease& operator=(const ReadLease&) = delete;
+  ~ReadLease();
+
+  sqlite3* get() const { return conn; }
+
+ private:
+  ReadConnectionPool* pool;
+  sqlite3* conn;
+  std::unique_lock<std::recursive_mutex> writerLock;
+};
+
+#endif  // READCONNECTIONPOOL_H
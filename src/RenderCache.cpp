@@ -0,0 +1,277 @@
+#include "RenderCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// FNV-1a; only needs to be stable across runs, not fast
+uint64_t hashText(const std::string& text, uint64_t hash = 14695981039346656037ull) {
+  for (unsigned char c : text) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+std::string hex64(uint64_t value) {
+  char text[17];
+  std::snprintf(text, sizeof(text), "%016llx",
+                static_cast<unsigned long long>(value));
+  return text;
+}
+
+int64_t nanos(fs::file_time_type time) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             time.time_since_epoch())
+      .count();
+}
+
+// Parses the content hash out of "<16 hex>-<16 hex>.<ext>"; temporaries
+// ("<name>.partN") are not entries
+bool parseName(const std::string& name, uint64_t& contentHash) {
+  if (name.size() < 35 || name[16] != '-' || name[33] != '.') return false;
+  if (name.find('.', 34) != std::string::npos) return false;
+  if (name.find_first_not_of("0123456789abcdef", 0) < 16) return false;
+  contentHash = std::stoull(name.substr(0, 16), nullptr, 16);
+  return true;
+}
+
+bool isTemporary(const std::string& name) {
+  return name.find(".part") != std::string::npos;
+}
+
+bool readFile(const std::string& path, std::string& bytes) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return false;
+  bytes.assign(std::istreambuf_iterator<char>(in),
+               std::istreambuf_iterator<char>());
+  return !in.bad();
+}
+
+std::atomic<unsigned int> partCounter{0};
+
+// A temporary this old belongs to a store() that will never finish; one
+// in flight is renamed into place within moments of being written
+constexpr std::chrono::minutes kStaleTemporaryAge{10};
+
+}  // namespace
+
+RenderCache::RenderCache(std::string directory, uint64_t maxBytes)
+    : directory(std::move(directory)), maxBytes(maxBytes) {}
+
+void RenderCache::setMaxBytes(uint64_t bytes) {
+  std::lock_guard<std::mutex> lock(indexMutex);
+  maxBytes = bytes;
+  loadIndex();
+  if (total > maxBytes) evictTo(maxBytes);
+}
+
+uint64_t RenderCache::totalBytes() {
+  std::lock_guard<std::mutex> lock(indexMutex);
+  loadIndex();
+  return total;
+}
+
+size_t RenderCache::entryCount() {
+  std::lock_guard<std::mutex> lock(indexMutex);
+  loadIndex();
+  return entries.size();
+}
+
+std::string RenderCache::fileName(const Key& key) const {
+  uint64_t hash = hashText(key.object);
+  hash = hashText(std::string(1, '\0') + key.view, hash);
+  hash = hashText(std::string(1, '\0') + std::to_string(key.size), hash);
+  return hex64(key.contentHash) + "-" + hex64(hash) + "." + key.extension;
+}
+
+std::string RenderCache::pathOf(const std::string& name) const {
+  return directory + "/" + name;
+}
+
+void RenderCache::loadIndex() {
+  if (indexLoaded) return;
+  indexLoaded = true;
+  if (directory.empty()) return;
+
+  std::error_code ec;
+  fs::create_directories(directory, ec);
+  sweepStaleTemporaries();
+  for (fs::directory_iterator it(directory, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    std::string name = it->path().filename().string();
+    uint64_t contentHash = 0;
+    if (!it->is_regular_file(ec) || !parseName(name, contentHash)) continue;
+    Entry entry{contentHash, static_cast<uint64_t>(it->file_size(ec)),
+                nanos(it->last_write_time(ec))};
+    total += entry.bytes;
+    entries[name] = entry;
+  }
+}
+
+bool RenderCache::contains(const Key& key) {
+  if (directory.empty() || key.contentHash == 0) return false;
+  std::lock_guard<std::mutex> lock(indexMutex);
+  loadIndex();
+  return entries.count(fileName(key)) > 0;
+}
+
+bool RenderCache::fetch(const Key& key, std::string& bytes) {
+  if (!contains(key)) return false;
+  std::string name = fileName(key);
+  std::string data;
+  if (!readFile(pathOf(name), data)) {
+    // Evicted or deleted behind our back
+    std::lock_guard<std::mutex> lock(indexMutex);
+    remove(name);
+    return false;
+  }
+  touch(name);
+  bytes.swap(data);
+  return true;
+}
+
+bool RenderCache::fetchFile(const Key& key, const std::string& destination) {
+  if (!contains(key)) return false;
+  std::string name = fileName(key);
+  std::error_code ec;
+  fs::copy_file(pathOf(name), destination,
+                fs::copy_options::overwrite_existing, ec);
+  if (ec) {
+    std::cerr << "Render cache: can't copy " << name << " to " << destination
+              << ": " << ec.message() << std::endl;
+    return false;
+  }
+  touch(name);
+  return true;
+}
+
+bool RenderCache::store(const Key& key, const std::string& bytes) {
+  if (directory.empty() || key.contentHash == 0 || bytes.empty()) return false;
+  {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    loadIndex();
+  }
+
+  // Written aside and renamed into place, so readers never see half a file
+  std::string name = fileName(key);
+  std::string part = pathOf(name) + ".part" + std::to_string(partCounter++);
+  {
+    std::ofstream out(part, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!out) {
+      std::cerr << "Render cache: can't write " << part << std::endl;
+      out.close();
+      std::remove(part.c_str());
+      return false;
+    }
+  }
+  std::error_code ec;
+  fs::rename(part, pathOf(name), ec);
+  if (ec) {
+    std::cerr << "Render cache: can't store " << name << ": " << ec.message()
+              << std::endl;
+    fs::remove(part, ec);
+    return false;
+  }
+  added(name, key.contentHash);
+  return true;
+}
+
+bool RenderCache::storeFile(const Key& key, const std::string& source) {
+  std::string bytes;
+  if (!readFile(source, bytes)) return false;
+  return store(key, bytes);
+}
+
+void RenderCache::added(const std::string& name, uint64_t contentHash) {
+  std::error_code ec;
+  uint64_t bytes = fs::file_size(pathOf(name), ec);
+  if (ec) return;
+
+  std::lock_guard<std::mutex> lock(indexMutex);
+  auto existing = entries.find(name);
+  if (existing != entries.end()) total -= existing->second.bytes;
+  entries[name] = Entry{contentHash, bytes,
+                        nanos(fs::file_time_type::clock::now())};
+  total += bytes;
+
+  // Evict a little below the limit so every store doesn't evict
+  if (total > maxBytes) evictTo(maxBytes - maxBytes / 10);
+}
+
+void RenderCache::touch(const std::string& name) {
+  std::error_code ec;
+  auto now = fs::file_time_type::clock::now();
+  fs::last_write_time(pathOf(name), now, ec);
+
+  std::lock_guard<std::mutex> lock(indexMutex);
+  auto entry = entries.find(name);
+  if (entry != entries.end()) entry->second.lastUse = nanos(now);
+}
+
+size_t RenderCache::evictTo(uint64_t bytes) {
+  std::vector<std::pair<int64_t, std::string>> byAge;
+  byAge.reserve(entries.size());
+  for (const auto& [name, entry] : entries) {
+    byAge.emplace_back(entry.lastUse, name);
+  }
+  std::sort(byAge.begin(), byAge.end());
+
+  size_t removed = 0;
+  for (const auto& [lastUse, name] : byAge) {
+    if (total <= bytes) break;
+    remove(name);
+    ++removed;
+  }
+  return removed;
+}
+
+void RenderCache::remove(const std::string& name) {
+  auto entry = entries.find(name);
+  if (entry == entries.end()) return;
+  total -= entry->second.bytes;
+  entries.erase(entry);
+  std::error_code ec;
+  fs::remove(pathOf(name), ec);
+}
+
+size_t RenderCache::collectGarbage(const std::set<uint64_t>& liveHashes) {
+  std::lock_guard<std::mutex> lock(indexMutex);
+  loadIndex();
+
+  std::vector<std::string> stale;
+  for (const auto& [name, entry] : entries) {
+    if (!liveHashes.count(entry.contentHash)) stale.push_back(name);
+  }
+  for (const auto& name : stale) remove(name);
+  sweepStaleTemporaries();
+
+  return stale.size() + (total > maxBytes ? evictTo(maxBytes) : 0);
+}
+
+void RenderCache::sweepStaleTemporaries() {
+  if (directory.empty()) return;
+  // Other threads may be between writing and renaming their own, so only
+  // temporaries left behind by a crash or a full disk go
+  auto cutoff = fs::file_time_type::clock::now() - kStaleTemporaryAge;
+  std::error_code ec;
+  for (fs::directory_iterator it(directory, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    std::error_code timeError;
+    if (isTemporary(it->path().filename().string()) &&
+        it->last_write_time(timeError) < cutoff && !timeError) {
+      fs::remove(it->path(), timeError);
+    }
+  }
+}
@@ -0,0 +1,75 @@
+#ifndef RENDERCACHE_H
+#define RENDERCACHE_H
+
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+// Rendered images and reports keyed by what they were made from: the
+// model file's content hash, the object rendered, the view and the size.
+// Unchanged and duplicate files are served from here instead of being
+// rendered again. Entries are files named
+//
+//   <content hash>-<hash of object, view and size>.<extension>
+//
+// in one directory; a file's mtime is its last use, so least recently
+// used entries are evicted first once the directory grows past its limit.
+class RenderCache {
+ public:
+  struct Key {
+    uint64_t contentHash = 0;  // 0: unknown contents, never cached
+    std::string object;
+    std::string view;          // renderer and view parameters
+    int size = 0;
+    std::string extension = "png";
+  };
+
+  static constexpr uint64_t kDefaultMaxBytes = 256ull * 1024 * 1024;
+
+  // An empty directory disables the cache
+  explicit RenderCache(std::string directory,
+                       uint64_t maxBytes = kDefaultMaxBytes);
+
+  void setMaxBytes(uint64_t bytes);
+  uint64_t totalBytes();
+  size_t entryCount();
+
+  bool contains(const Key& key);
+  // Hits count as a use. Misses return false and leave the output alone.
+  bool fetch(const Key& key, std::string& bytes);
+  bool fetchFile(const Key& key, const std::string& destination);
+  bool store(const Key& key, const std::string& bytes);
+  bool storeFile(const Key& key, const std::string& source);
+
+  // Drops entries for contents no model has any more and temporaries left
+  // by stores that never finished, then trims to the size limit; returns
+  // how many entries were removed
+  size_t collectGarbage(const std::set<uint64_t>& liveHashes);
+
+ private:
+  struct Entry {
+    uint64_t contentHash;
+    uint64_t bytes;
+    int64_t lastUse;  // file mtime, nanoseconds
+  };
+
+  std::string fileName(const Key& key) const;
+  std::string pathOf(const std::string& name) const;
+  void loadIndex();  // with indexMutex held
+  void added(const std::string& name, uint64_t contentHash);
+  void touch(const std::string& name);
+  size_t evictTo(uint64_t bytes);  // with indexMutex held
+  void remove(const std::string& name);  // with indexMutex held
+  void sweepStaleTemporaries();  // with indexMutex held
+
+  std::string directory;
+  uint64_t maxBytes;
+  std::mutex indexMutex;
+  bool indexLoaded = false;
+  uint64_t total = 0;
+  std::unordered_map<std::string, Entry> entries;  // by file name
+};
+
+#endif  // RENDERCACHE_H
@@ -35,7 +35,7 @@ ReportGenerationWindow::ReportGenerationWindow(QWidget* parent, Model* model,
 
   // change placeholder text for subtitle
   // x models in report
-  subtitle = "Contains " + std::to_string((model->getSelectedModels().size())) +
+  subtitle = "Contains " + std::to_string(model->statistics().selected) +
              " models.";
   ui->subtitle_textEdit->setPlaceholderText(QString::fromStdString(subtitle));
 
@@ -74,9 +74,11 @@ void ReportGenerationWindow::onGenerateReportButtonClicked() {
   }
 
   std::vector<std::string> existing_working_files;
+  selected_models = model->getSelectedModelSummaries();
+  toc_pages = static_cast<int>(ceil(double(selected_models.size()) / 33));
 
   // check for any model.working files!
-  for (const auto& model : model->getSelectedModels()) {
+  for (const auto& model : selected_models) {
     std::string model_working_path =
         model.file_path.substr(0, model.file_path.find(".g")) + ".working";
     std::string model_working_name =
@@ -117,7 +119,7 @@ void ReportGenerationWindow::onGenerateReportButtonClicked() {
   err_vec = new std::vector<std::string>();
 
   num_file = new int(0);
-  tot_num_files = new int(model->getSelectedModels().size());
+  tot_num_files = new int(selected_models.size());
 
   generatingReportThread =
       new QThread(this);  // Thread's parent is ReportGenerationWindow
@@ -411,9 +413,9 @@ void ReportGenerationWindow::tableOfContentsPage() {
   QRect long_name_rect = QRect(long_name_x, row_y, 1808, 100);
   // every 33 models new page
   int model_count = 0;
-  int page_offset = 2 + (ceil(double(model->getSelectedModels().size()) / 33));
+  int page_offset = 2 + toc_pages;
   int page_number = 2;
-  for (const auto& modelData : model->getSelectedModels()) {
+  for (const auto& modelData : selected_models) {
     if (model_count % 33 == 0) {
       if (pdfWriter->newPage()) {
         // draw title
@@ -529,8 +531,7 @@ void ReportGenerationWindow::onSuccessfulGistCall(
 
   if (pdfWriter->newPage()) {
     painter->drawPixmap(0, 0, gist);
-    int page_number = (*num_file) + 2 +
-                      (ceil(double(model->getSelectedModels().size()) / 33));
+    int page_number = (*num_file) + 2 + toc_pages;
     painter->setFont(QFont("Arial", 12));
     painter->setPen(Qt::white);
     painter->drawText(A4_MAXWIDTH_LS - 150, A4_MAXHEIGHT_LS - 75,
@@ -567,8 +568,7 @@ void ReportGenerationWindow::onFailedGistCall(const QString& filepath,
     painter->setFont(font_two);
     painter->drawText(100, 150, errorMessage);
     painter->setFont(QFont("Arial", 12));
-    int page_number = (*num_file) + 2 +
-                      (ceil(double(model->getSelectedModels().size()) / 33));
+    int page_number = (*num_file) + 2 + toc_pages;
     painter->drawText(A4_MAXWIDTH_LS - 150, A4_MAXHEIGHT_LS - 75,
                       QString::fromStdString(std::to_string(page_number)));
 
@@ -587,7 +587,7 @@ void ReportGenerationWindow::onFinishedGeneratingReport() {
 
   painter->end();
 
-  std::vector<ModelData> selectedModels = model->getSelectedModels();
+  const std::vector<ModelSummary>& selectedModels = selected_models;
 
   std::string hidden_dir_path = library->fullPath + "/.cadventory";
 
@@ -44,6 +44,8 @@ class ReportGenerationWindow : public QWidget {
 
   int* num_file; // tracks progress, incremented each time a model is processed
   int* tot_num_files;
+  int toc_pages = 0;  // table of contents pages, 33 models each
+  std::vector<ModelSummary> selected_models;  // snapshot taken at generation
   int x = 325; // table of contents starting x
   int y = 400; // table of contents starting y
   std::string time;
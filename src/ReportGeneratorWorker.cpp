@@ -15,7 +15,7 @@ void ReportGeneratorWorker::process() {
   // need output_directory
 
   int num_file = 0;
-  std::vector<ModelData> selectedModels = model->getSelectedModels();
+  std::vector<ModelSummary> selectedModels = model->getSelectedModelSummaries();
 
   for (const auto& modelData : selectedModels) {
     if(QThread::currentThread()->isInterruptionRequested()){
@@ -27,29 +27,45 @@ void ReportGeneratorWorker::process() {
         output_directory + "/" + std::to_string(num_file) + ".png";
 
     std::string primary_obj = "";
-    std::vector<ObjectData> associatedObjects =
-        model->getObjectsForModel(modelData.id);
+    std::vector<ObjectData> selectedObjects =
+        model->getSelectedObjectsForModel(modelData.id);
 
-    if (associatedObjects.empty()) {
-      std::cout << "No associated objects for this model.\n";
+    if (selectedObjects.empty()) {
+      std::cout << "No selected object for this model.\n";
     } else {
-      std::cout << "Associated Objects (" << associatedObjects.size() << "):\n";
-
-      for (const auto& obj : associatedObjects) {
-        if (obj.is_selected) {
-          primary_obj = obj.name;
-        }
-      }
+      primary_obj = selectedObjects.back().name;
     }
 
 
     emit processingGistCall(QString::fromStdString(modelData.file_path));
 
+    // The page prints the file's path as well as its contents, object and
+    // label, so an unchanged file is copied from the cache but a copy of it
+    // elsewhere gets its own page
+    RenderCache::Key cacheKey{model->getContentHash(modelData.id), primary_obj,
+                              "gist " + label + '\0' + modelData.file_path, 0, "png"};
+    if (model->renderCache().fetchFile(cacheKey, path_gist_output)) {
+      model->setStageStateAsync(modelData.id, Model::GistStage, Model::StageDone);
+      emit successfulGistCall(QString::fromStdString(path_gist_output));
+      num_file++;
+      continue;
+    }
+
+    // The user asked for this report, so earlier failures don't hold it
+    // back; the attempt is on record before gist can crash or hang
+    model->recordStageAttemptAsync(modelData.id, Model::GistStage);
+    model->flushWrites();
+
     // Use the generateGistReport method
     auto [success, errorMessage, command] = processor.generateGistReport(
         modelData.file_path, path_gist_output, primary_obj, label);
 
+    model->setStageStateAsync(modelData.id, Model::GistStage,
+                              success ? Model::StageDone : Model::StageFailed,
+                              errorMessage);
+
     if (success) {
+      model->renderCache().storeFile(cacheKey, path_gist_output);
       // emit success
         emit successfulGistCall(QString::fromStdString(path_gist_output));
     } else {
@@ -63,6 +79,8 @@ void ReportGeneratorWorker::process() {
   }
 
 
+  model->flushWrites();
+
   // Emit finished signal to indicate processing is complete
   emit finishedReport();
   emit finished();
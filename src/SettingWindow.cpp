@@ -26,12 +26,23 @@ void SettingWindow::loadSettings()
     ui->previewTimer->setRange(0,2400);
     ui->previewTimer->setSingleStep(10);
     ui->previewTimer->setValue(previewLimit);
+    ui->packObjectTrees->setChecked(settings.value("packObjectTrees", false).toBool());
+    ui->indexingThreads->setRange(0,64);
+    ui->indexingThreads->setValue(settings.value("indexingThreads", 0).toInt());
+    ui->inProcessRenderer->setChecked(settings.value("inProcessRenderer", true).toBool());
+    ui->renderCacheMB->setRange(0,65536);
+    ui->renderCacheMB->setSingleStep(64);
+    ui->renderCacheMB->setValue(settings.value("renderCacheMB", 256).toInt());
 }
 
 void SettingWindow::saveSettings()
 {
     QSettings settings;
     settings.setValue("previewFlag", ui->enablePreview->isChecked());
+    settings.setValue("packObjectTrees", ui->packObjectTrees->isChecked());
+    settings.setValue("indexingThreads", ui->indexingThreads->value());
+    settings.setValue("inProcessRenderer", ui->inProcessRenderer->isChecked());
+    settings.setValue("renderCacheMB", ui->renderCacheMB->value());
     if(ui->enablePreview->isChecked()){
     settings.setValue("previewTimer", ui->previewTimer->value());
     }
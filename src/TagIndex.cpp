@@ -0,0 +1,533 @@
+#include "TagIndex.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <iterator>
+
+namespace {
+
+int popcount64(uint64_t x) {
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return static_cast<int>((x * 0x0101010101010101ULL) >> 56);
+}
+
+}  // namespace
+
+// Containers
+
+bool TagBitmap::Container::contains(uint16_t low) const {
+  if (isBitset()) {
+    return (bits[low >> 6] >> (low & 63)) & 1;
+  }
+  return std::binary_search(array.begin(), array.end(), low);
+}
+
+void TagBitmap::Container::toBitset() {
+  bits.assign(kBitsetWords, 0);
+  for (uint16_t low : array) {
+    bits[low >> 6] |= uint64_t(1) << (low & 63);
+  }
+  array.clear();
+  array.shrink_to_fit();
+}
+
+void TagBitmap::Container::normalize() {
+  if (isBitset()) {
+    count = 0;
+    for (uint64_t word : bits) count += popcount64(word);
+    if (count <= kArrayMax) {
+      array.clear();
+      array.reserve(count);
+      for (size_t i = 0; i < bits.size(); ++i) {
+        for (uint64_t word = bits[i]; word; word &= word - 1) {
+          int bit = popcount64((word & (~word + 1)) - 1);
+          array.push_back(static_cast<uint16_t>(i * 64 + bit));
+        }
+      }
+      bits.clear();
+      bits.shrink_to_fit();
+    }
+  } else {
+    count = static_cast<uint32_t>(array.size());
+    if (count > kArrayMax) toBitset();
+  }
+}
+
+TagBitmap::Container TagBitmap::intersect(const Container& a,
+                                          const Container& b) {
+  Container result;
+  result.key = a.key;
+  if (!a.isBitset() && !b.isBitset()) {
+    std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(),
+                          b.array.end(), std::back_inserter(result.array));
+  } else if (!a.isBitset() || !b.isBitset()) {
+    const Container& sparse = a.isBitset() ? b : a;
+    const Container& dense = a.isBitset() ? a : b;
+    for (uint16_t low : sparse.array) {
+      if (dense.contains(low)) result.array.push_back(low);
+    }
+  } else {
+    result.bits.resize(kBitsetWords);
+    for (size_t i = 0; i < kBitsetWords; ++i) {
+      result.bits[i] = a.bits[i] & b.bits[i];
+    }
+  }
+  result.normalize();
+  return result;
+}
+
+TagBitmap::Container TagBitmap::unite(const Container& a, const Container& b) {
+  Container result;
+  result.key = a.key;
+  if (!a.isBitset() && !b.isBitset()) {
+    std::set_union(a.array.begin(), a.array.end(), b.array.begin(),
+                   b.array.end(), std::back_inserter(result.array));
+  } else {
+    const Container& dense = a.isBitset() ? a : b;
+    const Container& other = a.isBitset() ? b : a;
+    result.bits = dense.bits;
+    if (other.isBitset()) {
+      for (size_t i = 0; i < kBitsetWords; ++i) result.bits[i] |= other.bits[i];
+    } else {
+      for (uint16_t low : other.array) {
+        result.bits[low >> 6] |= uint64_t(1) << (low & 63);
+      }
+    }
+  }
+  result.normalize();
+  return result;
+}
+
+TagBitmap::Container TagBitmap::subtract(const Container& a,
+                                         const Container& b) {
+  Container result;
+  result.key = a.key;
+  if (!a.isBitset()) {
+    for (uint16_t low : a.array) {
+      if (!b.contains(low)) result.array.push_back(low);
+    }
+  } else {
+    result.bits = a.bits;
+    if (b.isBitset()) {
+      for (size_t i = 0; i < kBitsetWords; ++i) result.bits[i] &= ~b.bits[i];
+    } else {
+      for (uint16_t low : b.array) {
+        result.bits[low >> 6] &= ~(uint64_t(1) << (low & 63));
+      }
+    }
+  }
+  result.normalize();
+  return result;
+}
+
+uint64_t TagBitmap::intersectCount(const Container& a, const Container& b) {
+  uint64_t count = 0;
+  if (!a.isBitset() && !b.isBitset()) {
+    auto i = a.array.begin();
+    auto j = b.array.begin();
+    while (i != a.array.end() && j != b.array.end()) {
+      if (*i < *j) {
+        ++i;
+      } else if (*j < *i) {
+        ++j;
+      } else {
+        ++count;
+        ++i;
+        ++j;
+      }
+    }
+  } else if (!a.isBitset() || !b.isBitset()) {
+    const Container& sparse = a.isBitset() ? b : a;
+    const Container& dense = a.isBitset() ? a : b;
+    for (uint16_t low : sparse.array) {
+      if (dense.contains(low)) ++count;
+    }
+  } else {
+    for (size_t i = 0; i < kBitsetWords; ++i) {
+      count += popcount64(a.bits[i] & b.bits[i]);
+    }
+  }
+  return count;
+}
+
+// Bitmaps
+
+std::vector<TagBitmap::Container>::iterator TagBitmap::find(uint16_t key) {
+  auto it = std::lower_bound(
+      containers.begin(), containers.end(), key,
+      [](const Container& c, uint16_t k) { return c.key < k; });
+  return it != containers.end() && it->key == key ? it : containers.end();
+}
+
+std::vector<TagBitmap::Container>::const_iterator TagBitmap::find(
+    uint16_t key) const {
+  auto it = std::lower_bound(
+      containers.begin(), containers.end(), key,
+      [](const Container& c, uint16_t k) { return c.key < k; });
+  return it != containers.end() && it->key == key ? it : containers.end();
+}
+
+void TagBitmap::add(uint32_t value) {
+  uint16_t key = static_cast<uint16_t>(value >> 16);
+  uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+
+  auto it = std::lower_bound(
+      containers.begin(), containers.end(), key,
+      [](const Container& c, uint16_t k) { return c.key < k; });
+  if (it == containers.end() || it->key != key) {
+    Container container;
+    container.key = key;
+    it = containers.insert(it, std::move(container));
+  }
+
+  if (it->isBitset()) {
+    uint64_t& word = it->bits[low >> 6];
+    uint64_t mask = uint64_t(1) << (low & 63);
+    if (!(word & mask)) {
+      word |= mask;
+      ++it->count;
+    }
+    return;
+  }
+  auto pos = std::lower_bound(it->array.begin(), it->array.end(), low);
+  if (pos == it->array.end() || *pos != low) {
+    it->array.insert(pos, low);
+    if (++it->count > kArrayMax) it->toBitset();
+  }
+}
+
+void TagBitmap::remove(uint32_t value) {
+  auto it = find(static_cast<uint16_t>(value >> 16));
+  if (it == containers.end()) return;
+  uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+
+  if (it->isBitset()) {
+    uint64_t& word = it->bits[low >> 6];
+    uint64_t mask = uint64_t(1) << (low & 63);
+    if (!(word & mask)) return;
+    word &= ~mask;
+    if (--it->count <= kArrayMax) it->normalize();
+  } else {
+    auto pos = std::lower_bound(it->array.begin(), it->array.end(), low);
+    if (pos == it->array.end() || *pos != low) return;
+    it->array.erase(pos);
+    --it->count;
+  }
+  if (it->count == 0) containers.erase(it);
+}
+
+bool TagBitmap::contains(uint32_t value) const {
+  auto it = find(static_cast<uint16_t>(value >> 16));
+  return it != containers.end() &&
+         it->contains(static_cast<uint16_t>(value & 0xFFFF));
+}
+
+uint64_t TagBitmap::cardinality() const {
+  uint64_t total = 0;
+  for (const Container& c : containers) total += c.count;
+  return total;
+}
+
+std::vector<uint32_t> TagBitmap::values() const {
+  std::vector<uint32_t> result;
+  result.reserve(cardinality());
+  for (const Container& c : containers) {
+    uint32_t high = static_cast<uint32_t>(c.key) << 16;
+    if (c.isBitset()) {
+      for (size_t i = 0; i < c.bits.size(); ++i) {
+        for (uint64_t word = c.bits[i]; word; word &= word - 1) {
+          int bit = popcount64((word & (~word + 1)) - 1);
+          result.push_back(high | static_cast<uint32_t>(i * 64 + bit));
+        }
+      }
+    } else {
+      for (uint16_t low : c.array) result.push_back(high | low);
+    }
+  }
+  return result;
+}
+
+TagBitmap TagBitmap::intersect(const TagBitmap& a, const TagBitmap& b) {
+  TagBitmap result;
+  auto i = a.containers.begin();
+  auto j = b.containers.begin();
+  while (i != a.containers.end() && j != b.containers.end()) {
+    if (i->key < j->key) {
+      ++i;
+    } else if (j->key < i->key) {
+      ++j;
+    } else {
+      Container c = intersect(*i, *j);
+      if (c.count > 0) result.containers.push_back(std::move(c));
+      ++i;
+      ++j;
+    }
+  }
+  return result;
+}
+
+TagBitmap TagBitmap::unite(const TagBitmap& a, const TagBitmap& b) {
+  TagBitmap result;
+  auto i = a.containers.begin();
+  auto j = b.containers.begin();
+  while (i != a.containers.end() || j != b.containers.end()) {
+    if (j == b.containers.end() ||
+        (i != a.containers.end() && i->key < j->key)) {
+      result.containers.push_back(*i++);
+    } else if (i == a.containers.end() || j->key < i->key) {
+      result.containers.push_back(*j++);
+    } else {
+      result.containers.push_back(unite(*i++, *j++));
+    }
+  }
+  return result;
+}
+
+TagBitmap TagBitmap::subtract(const TagBitmap& a, const TagBitmap& b) {
+  TagBitmap result;
+  for (const Container& c : a.containers) {
+    auto other = b.find(c.key);
+    if (other == b.containers.end()) {
+      result.containers.push_back(c);
+      continue;
+    }
+    Container remaining = subtract(c, *other);
+    if (remaining.count > 0) result.containers.push_back(std::move(remaining));
+  }
+  return result;
+}
+
+uint64_t TagBitmap::intersectCount(const TagBitmap& a, const TagBitmap& b) {
+  uint64_t count = 0;
+  for (const Container& c : a.containers) {
+    auto other = b.find(c.key);
+    if (other != b.containers.end()) count += intersectCount(c, *other);
+  }
+  return count;
+}
+
+// Tag index
+
+void TagIndex::assign(
+    const std::vector<int>& modelIds,
+    const std::vector<std::pair<int, std::string>>& modelTags) {
+  TagBitmap models;
+  std::map<std::string, TagBitmap> byTag;
+  for (int id : modelIds) models.add(static_cast<uint32_t>(id));
+  for (const auto& [id, tagName] : modelTags) {
+    byTag[tagName].add(static_cast<uint32_t>(id));
+  }
+
+  std::lock_guard<std::mutex> lock(indexMutex);
+  allModels = std::move(models);
+  tags = std::move(byTag);
+}
+
+void TagIndex::addModel(int modelId) {
+  std::lock_guard<std::mutex> lock(indexMutex);
+  allModels.add(static_cast<uint32_t>(modelId));
+}
+
+void TagIndex::removeModel(int modelId) {
+  std::lock_guard<std::mutex> lock(indexMutex);
+  allModels.remove(static_cast<uint32_t>(modelId));
+  for (auto it = tags.begin(); it != tags.end();) {
+    it->second.remove(static_cast<uint32_t>(modelId));
+    it = it->second.empty() ? tags.erase(it) : std::next(it);
+  }
+}
+
+void TagIndex::tag(int modelId, const std::string& tagName) {
+  std::lock_guard<std::mutex> lock(indexMutex);
+  tags[tagName].add(static_cast<uint32_t>(modelId));
+}
+
+void TagIndex::untag(int modelId, const std::string& tagName) {
+  std::lock_guard<std::mutex> lock(indexMutex);
+  auto it = tags.find(tagName);
+  if (it == tags.end()) return;
+  it->second.remove(static_cast<uint32_t>(modelId));
+  if (it->second.empty()) tags.erase(it);
+}
+
+void TagIndex::untagAll(int modelId) {
+  std::lock_guard<std::mutex> lock(indexMutex);
+  for (auto it = tags.begin(); it != tags.end();) {
+    it->second.remove(static_cast<uint32_t>(modelId));
+    it = it->second.empty() ? tags.erase(it) : std::next(it);
+  }
+}
+
+bool TagIndex::match(const std::string& expression,
+                     std::vector<int>& modelIds) const {
+  std::lock_guard<std::mutex> lock(indexMutex);
+  TagBitmap result;
+  if (!evaluate(expression, result)) return false;
+
+  modelIds.clear();
+  for (uint32_t id : result.values()) modelIds.push_back(static_cast<int>(id));
+  return true;
+}
+
+bool TagIndex::facets(const std::string& expression,
+                      std::map<std::string, int>& counts) const {
+  std::lock_guard<std::mutex> lock(indexMutex);
+  TagBitmap result;
+  if (!evaluate(expression, result)) return false;
+
+  counts.clear();
+  for (const auto& [tagName, models] : tags) {
+    counts[tagName] =
+        static_cast<int>(TagBitmap::intersectCount(result, models));
+  }
+  return true;
+}
+
+namespace {
+
+struct Token {
+  enum Kind { Tag, And, Or, Not, Open, Close } kind;
+  std::string text;
+};
+
+bool tokenize(const std::string& expression, std::vector<Token>& tokens) {
+  size_t i = 0;
+  while (i < expression.size()) {
+    unsigned char c = static_cast<unsigned char>(expression[i]);
+    if (std::isspace(c)) {
+      ++i;
+    } else if (c == '(') {
+      tokens.push_back({Token::Open, "("});
+      ++i;
+    } else if (c == ')') {
+      tokens.push_back({Token::Close, ")"});
+      ++i;
+    } else if (c == '"') {
+      size_t close = expression.find('"', i + 1);
+      if (close == std::string::npos) return false;
+      tokens.push_back({Token::Tag, expression.substr(i + 1, close - i - 1)});
+      i = close + 1;
+    } else {
+      size_t start = i;
+      while (i < expression.size() &&
+             !std::isspace(static_cast<unsigned char>(expression[i])) &&
+             expression[i] != '(' && expression[i] != ')' &&
+             expression[i] != '"') {
+        ++i;
+      }
+      std::string word = expression.substr(start, i - start);
+      std::string upper = word;
+      for (char& ch : upper) {
+        ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+      }
+      if (upper == "AND") {
+        tokens.push_back({Token::And, word});
+      } else if (upper == "OR") {
+        tokens.push_back({Token::Or, word});
+      } else if (upper == "NOT") {
+        tokens.push_back({Token::Not, word});
+      } else {
+        tokens.push_back({Token::Tag, word});
+      }
+    }
+  }
+  return true;
+}
+
+// Recursive descent over  or := and (OR and)*,  and := not ([AND] not)*,
+// not := NOT not | ( or ) | tag
+class TagExpressionParser {
+ public:
+  TagExpressionParser(const std::vector<Token>& tokens,
+                      const TagBitmap& allModels,
+                      const std::map<std::string, TagBitmap>& tags)
+      : tokens(tokens), allModels(allModels), tags(tags) {}
+
+  bool parse(TagBitmap& result) {
+    result = parseOr();
+    return ok && pos == tokens.size();
+  }
+
+ private:
+  bool peek(Token::Kind kind) const {
+    return pos < tokens.size() && tokens[pos].kind == kind;
+  }
+
+  TagBitmap parseOr() {
+    TagBitmap left = parseAnd();
+    while (ok && peek(Token::Or)) {
+      ++pos;
+      left = TagBitmap::unite(left, parseAnd());
+    }
+    return left;
+  }
+
+  TagBitmap parseAnd() {
+    TagBitmap left = parseNot();
+    while (ok) {
+      if (peek(Token::And)) {
+        ++pos;
+      } else if (!peek(Token::Tag) && !peek(Token::Not) &&
+                 !peek(Token::Open)) {
+        break;
+      }
+      left = TagBitmap::intersect(left, parseNot());
+    }
+    return left;
+  }
+
+  TagBitmap parseNot() {
+    if (peek(Token::Not)) {
+      ++pos;
+      return TagBitmap::subtract(allModels, parseNot());
+    }
+    if (peek(Token::Open)) {
+      ++pos;
+      TagBitmap inner = parseOr();
+      if (!peek(Token::Close)) {
+        ok = false;
+        return TagBitmap();
+      }
+      ++pos;
+      return inner;
+    }
+    if (peek(Token::Tag)) {
+      auto it = tags.find(tokens[pos++].text);
+      return it != tags.end() ? it->second : TagBitmap();
+    }
+    ok = false;
+    return TagBitmap();
+  }
+
+  const std::vector<Token>& tokens;
+  const TagBitmap& allModels;
+  const std::map<std::string, TagBitmap>& tags;
+  size_t pos = 0;
+  bool ok = true;
+};
+
+}  // namespace
+
+bool TagIndex::evaluate(const std::string& expression,
+                        TagBitmap& result) const {
+  std::vector<Token> tokens;
+  if (!tokenize(expression, tokens)) {
+    std::cerr << "Unterminated quote in tag expression: " << expression
+              << std::endl;
+    return false;
+  }
+  if (tokens.empty()) {
+    result = allModels;
+    return true;
+  }
+
+  TagExpressionParser parser(tokens, allModels, tags);
+  if (!parser.parse(result)) {
+    std::cerr << "Malformed tag expression: " << expression << std::endl;
+    return false;
+  }
+  return true;
+}
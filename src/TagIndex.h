@@ -0,0 +1,89 @@
+#ifndef TAGINDEX_H
+#define TAGINDEX_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Compressed set of 32-bit ids in the style of a Roaring bitmap: ids are
+// split on their high 16 bits into containers, each holding its low halves
+// as a sorted array while sparse and as a 65536-bit bitset once dense
+class TagBitmap {
+ public:
+  void add(uint32_t value);
+  void remove(uint32_t value);
+  bool contains(uint32_t value) const;
+  bool empty() const { return containers.empty(); }
+  uint64_t cardinality() const;
+  std::vector<uint32_t> values() const;
+
+  static TagBitmap intersect(const TagBitmap& a, const TagBitmap& b);
+  static TagBitmap unite(const TagBitmap& a, const TagBitmap& b);
+  static TagBitmap subtract(const TagBitmap& a, const TagBitmap& b);
+  // |a AND b| without materializing the intersection
+  static uint64_t intersectCount(const TagBitmap& a, const TagBitmap& b);
+
+ private:
+  struct Container {
+    uint16_t key = 0;
+    uint32_t count = 0;
+    std::vector<uint16_t> array;  // sorted, while count <= kArrayMax
+    std::vector<uint64_t> bits;   // kBitsetWords words, once denser
+
+    bool isBitset() const { return !bits.empty(); }
+    bool contains(uint16_t low) const;
+    void toBitset();
+    void normalize();
+  };
+
+  static constexpr uint32_t kArrayMax = 4096;
+  static constexpr size_t kBitsetWords = 65536 / 64;
+
+  static Container intersect(const Container& a, const Container& b);
+  static Container unite(const Container& a, const Container& b);
+  static Container subtract(const Container& a, const Container& b);
+  static uint64_t intersectCount(const Container& a, const Container& b);
+
+  std::vector<Container>::iterator find(uint16_t key);
+  std::vector<Container>::const_iterator find(uint16_t key) const;
+
+  std::vector<Container> containers;  // sorted by key
+};
+
+// In-memory tag -> model id bitmaps mirroring model_tags, for boolean tag
+// filters and facet counts without touching the database. Safe to use from
+// any thread.
+class TagIndex {
+ public:
+  // Replaces the whole index, e.g. after reading model_tags on load
+  void assign(const std::vector<int>& modelIds,
+              const std::vector<std::pair<int, std::string>>& modelTags);
+
+  void addModel(int modelId);
+  void removeModel(int modelId);
+  void tag(int modelId, const std::string& tagName);
+  void untag(int modelId, const std::string& tagName);
+  void untagAll(int modelId);
+
+  // Evaluates an expression such as
+  //   steel AND (bolt OR nut) AND NOT obsolete
+  // AND, OR and NOT are case-insensitive, adjacent tags are ANDed and tags
+  // containing spaces or parentheses can be double-quoted. An empty
+  // expression matches every model. Returns false if it does not parse.
+  bool match(const std::string& expression, std::vector<int>& modelIds) const;
+  // For every tag, how many of the models matching the expression carry it
+  bool facets(const std::string& expression,
+              std::map<std::string, int>& counts) const;
+
+ private:
+  bool evaluate(const std::string& expression, TagBitmap& result) const;
+
+  mutable std::mutex indexMutex;
+  TagBitmap allModels;
+  std::map<std::string, TagBitmap> tags;
+};
+
+#endif  // TAGINDEX_H
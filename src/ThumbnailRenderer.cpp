@@ -0,0 +1,161 @@
+#include "ThumbnailRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// rt's default view
+constexpr double kAzimuth = 35.0 * M_PI / 180.0;
+constexpr double kElevation = 25.0 * M_PI / 180.0;
+
+// Object color when the region has none
+constexpr double kDefaultGray = 0.8;
+
+int channel(double value) {
+  return std::clamp(static_cast<int>(value * 255.0 + 0.5), 0, 255);
+}
+
+}  // namespace
+
+ThumbnailRenderer::ThumbnailRenderer() = default;
+
+ThumbnailRenderer::~ThumbnailRenderer() {
+  if (rtip) rt_free_rti(rtip);
+}
+
+bool ThumbnailRenderer::prepare(struct db_i* dbip, const std::string& object,
+                                std::string& error) {
+  objectName = object;
+  if (!dbip) {
+    error = "No database to render from";
+    return false;
+  }
+
+  // A new rt_i holds its own reference to the database
+  rtip = rt_new_rti(dbip);
+  if (rtip == RTI_NULL) {
+    error = "librt could not start on the database";
+    return false;
+  }
+
+  // Rays on this rt_i use their own resource, so renders of different
+  // models don't share per-CPU state
+  resource = std::make_unique<struct resource>();
+  rt_init_resource(resource.get(), 0, rtip);
+
+  if (rt_gettree(rtip, object.c_str()) < 0) {
+    error = "librt could not load " + object;
+    return false;
+  }
+  rt_prep_parallel(rtip, 1);
+
+  if (rtip->nsolids == 0 || !(rtip->rti_radius > 0)) {
+    error = object + " has no geometry to render";
+    return false;
+  }
+  return true;
+}
+
+bool ThumbnailRenderer::bounds(double min[3], double max[3]) const {
+  if (!rtip || rtip->nsolids == 0) return false;
+  for (int axis = 0; axis < 3; ++axis) {
+    min[axis] = rtip->mdl_min[axis];
+    max[axis] = rtip->mdl_max[axis];
+  }
+  return true;
+}
+
+ThumbnailRenderer::Result ThumbnailRenderer::render(
+    int size, std::chrono::steady_clock::time_point deadline,
+    const std::atomic<bool>* cancel, QImage& image, std::string& error) {
+  if (!rtip || rtip->nsolids == 0 || size <= 0) {
+    error = "Nothing prepared to render";
+    return Result::Failed;
+  }
+
+  // Orthographic view fitted to the bounding sphere, rays fired toward the
+  // model from outside it
+  vect_t toEye = {std::cos(kElevation) * std::cos(kAzimuth),
+                  std::cos(kElevation) * std::sin(kAzimuth),
+                  std::sin(kElevation)};
+  vect_t right = {-std::sin(kAzimuth), std::cos(kAzimuth), 0.0};
+  vect_t up;
+  VCROSS(up, toEye, right);
+
+  point_t center;
+  VADD2SCALE(center, rtip->mdl_min, rtip->mdl_max, 0.5);
+  double radius = rtip->rti_radius;
+  double viewSize = 2.0 * radius;
+
+  // Key light above and to the left of the viewer
+  vect_t light;
+  VJOIN2(light, toEye, 0.6, up, -0.4, right);
+  VUNITIZE(light);
+
+  struct application ap;
+  RT_APPLICATION_INIT(&ap);
+  ap.a_rt_i = rtip;
+  ap.a_resource = resource.get();
+  ap.a_onehit = 1;
+  ap.a_hit = &ThumbnailRenderer::hit;
+  ap.a_miss = &ThumbnailRenderer::miss;
+  ap.a_uptr = light;
+  VREVERSE(ap.a_ray.r_dir, toEye);
+
+  image = QImage(size, size, QImage::Format_RGB32);
+  for (int y = 0; y < size; ++y) {
+    if (cancel && cancel->load()) {
+      error = "Render cancelled";
+      return Result::Cancelled;
+    }
+    if (std::chrono::steady_clock::now() > deadline) {
+      error = "Render ran past its deadline";
+      return Result::TimedOut;
+    }
+
+    QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+    double v = (0.5 - (y + 0.5) / size) * viewSize;
+    for (int x = 0; x < size; ++x) {
+      double u = ((x + 0.5) / size - 0.5) * viewSize;
+      VJOIN3(ap.a_ray.r_pt, center, u, right, v, up, 2.0 * radius, toEye);
+      rt_shootray(&ap);
+      line[x] = qRgb(channel(ap.a_color[0]), channel(ap.a_color[1]),
+                     channel(ap.a_color[2]));
+    }
+  }
+  return Result::Done;
+}
+
+int ThumbnailRenderer::hit(struct application* ap, struct partition* partitions,
+                           struct seg* /*segments*/) {
+  // First partition in front of the ray origin
+  struct partition* pp = partitions->pt_forw;
+  while (pp != partitions && pp->pt_outhit->hit_dist < 0.0) pp = pp->pt_forw;
+  if (pp == partitions) return miss(ap);
+
+  struct hit* hitp = pp->pt_inhit;
+  vect_t normal;
+  RT_HIT_NORMAL(normal, hitp, pp->pt_inseg->seg_stp, &ap->a_ray, pp->pt_inflip);
+
+  vect_t base = {kDefaultGray, kDefaultGray, kDefaultGray};
+  const struct region* regp = pp->pt_regionp;
+  if (regp && regp->reg_mater.ma_color_valid) {
+    VMOVE(base, regp->reg_mater.ma_color);
+  }
+
+  // Ambient, plus a headlight so nothing facing the viewer is black, plus
+  // the key light for shape
+  const fastf_t* light = static_cast<const fastf_t*>(ap->a_uptr);
+  double headlight = std::fabs(VDOT(normal, ap->a_ray.r_dir));
+  double key = std::max(0.0, static_cast<double>(VDOT(normal, light)));
+  double shade = std::min(1.0, 0.15 + 0.45 * headlight + 0.4 * key);
+  VSCALE(ap->a_color, base, shade);
+  return 1;
+}
+
+int ThumbnailRenderer::miss(struct application* ap) {
+  // rt's default background
+  VSETALL(ap->a_color, 0.0);
+  return 0;
+}
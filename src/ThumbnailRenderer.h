@@ -0,0 +1,56 @@
+#ifndef THUMBNAILRENDERER_H
+#define THUMBNAILRENDERER_H
+
+#include <brlcad/raytrace.h>
+
+#include <QImage>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+
+// Raytraces one object of an open .g database into a QImage with librt,
+// instead of running rt in a subprocess and reading its PNG back. The view
+// matches rt's default (azimuth 35, elevation 25, orthographic, fitted to
+// the bounding sphere) with a headlight and one key light.
+//
+// prepare() and the destructor touch librt's shared state and must run
+// under the same lock as other in-process BRL-CAD calls; render() only
+// shoots rays on this instance's own rt_i and can run unlocked, alongside
+// other renders.
+class ThumbnailRenderer {
+ public:
+  enum class Result { Done, Failed, TimedOut, Cancelled };
+
+  ThumbnailRenderer();
+  ~ThumbnailRenderer();
+  ThumbnailRenderer(const ThumbnailRenderer&) = delete;
+  ThumbnailRenderer& operator=(const ThumbnailRenderer&) = delete;
+
+  // Loads and preps object from dbip, which only needs to stay open until
+  // this returns; false with error set if it can't be raytraced
+  bool prepare(struct db_i* dbip, const std::string& object, std::string& error);
+  const std::string& object() const { return objectName; }
+  // Primitives in the prepared tree, counting every instance
+  size_t solidCount() const { return rtip ? rtip->nsolids : 0; }
+  // Bounding box of the prepared tree in mm; false if nothing is prepared
+  bool bounds(double min[3], double max[3]) const;
+
+  // Renders a size x size image, giving up once deadline passes or cancel
+  // (if given) is set. Checked between scanlines.
+  Result render(int size, std::chrono::steady_clock::time_point deadline,
+                const std::atomic<bool>* cancel, QImage& image,
+                std::string& error);
+
+ private:
+  static int hit(struct application* ap, struct partition* partitions,
+                 struct seg* segments);
+  static int miss(struct application* ap);
+
+  struct rt_i* rtip = nullptr;
+  std::unique_ptr<struct resource> resource;
+  std::string objectName;
+};
+
+#endif  // THUMBNAILRENDERER_H
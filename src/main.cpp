@@ -10,8 +10,26 @@
 #include <stdlib.h>
 #include <iostream>
 #include <filesystem>
+#include <fstream>
 #include <string>
 
+#include "QueryStats.h"
+
+
+static void
+writeQueryStats(const std::string &path)
+{
+  std::string json = QueryStats::global().toJson();
+  if (path.empty()) {
+    std::cout << json;
+    return;
+  }
+  std::ofstream out(path);
+  out << json;
+  if (!out)
+    std::cerr << "Could not write database statistics to " << path << std::endl;
+}
+
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN 1
@@ -30,7 +48,42 @@ int
 main(int argc, char **argv)
 {
 #endif
+  // cadventory --db-stats [file.json] ...
+  // Times every catalog statement; the JSON dump is written on exit, to
+  // stdout unless a file is given. The flag is taken out of argv so it
+  // does not switch the app into CLI mode by itself.
+  bool dbStats = false;
+  std::string dbStatsFile;
+  for (int i = 1; i < argc; i++) {
+    if (std::string(argv[i]) != "--db-stats")
+      continue;
+    int used = 1;
+    if (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+      dbStatsFile = argv[i + 1];
+      used = 2;
+    }
+    for (int j = i; j + used <= argc; j++)
+      argv[j] = argv[j + used];
+    argc -= used;
+    dbStats = true;
+    break;
+  }
+  QueryStats::global().setEnabled(dbStats);
+
   CADventory app(argc, argv);
+
+  // cadventory --stats <library-path>
+  if (argc > 1 && std::string(argv[1]) == "--stats") {
+    if (argc != 3) {
+      std::cerr << "Usage: " << argv[0] << " --stats <library-path> [--db-stats [file.json]]" << std::endl;
+      return 1;
+    }
+    int status = app.printStatistics(argv[2]);
+    if (dbStats)
+      writeQueryStats(dbStatsFile);
+    return status;
+  }
+
   app.showSplash();
 
   QTimer::singleShot(250, [&app]() {
@@ -44,5 +97,8 @@ main(int argc, char **argv)
   });
   printf("Starting CADventory\n");
 
-  return app.exec();
+  int status = app.exec();
+  if (dbStats)
+    writeQueryStats(dbStatsFile);
+  return status;
 }
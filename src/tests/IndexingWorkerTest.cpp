@@ -2,10 +2,110 @@
 #include <catch2/catch_test_macros.hpp>
 #include <QCoreApplication>
 #include <memory>
+#include <QSettings>
 #include "IndexingWorker.h"
 #include "Library.h"
 #include "Model.h"
+#include "BlobDevice.h"
+#include <brlcad/raytrace.h>
+#include <brlcad/wdb.h>
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+const std::string TEST_LIBRARY_PATH = "./temp_indexing_library";
+
+// A .g file holding spheres balls under all.g; more balls, bigger file
+std::string writeModelFile(const std::string& name, int spheres) {
+    std::string path = TEST_LIBRARY_PATH + "/" + name + ".g";
+    struct rt_wdb* wdbp = wdb_fopen(path.c_str());
+    struct wmember all;
+    BU_LIST_INIT(&all.l);
+    for (int i = 0; i < spheres; ++i) {
+        std::string sphere = "ball" + std::to_string(i) + ".s";
+        point_t center = {i * 30.0, 0, 0};
+        mk_sph(wdbp, sphere.c_str(), center, 10.0);
+        mk_addmember(sphere.c_str(), &all.l, nullptr, WMOP_UNION);
+    }
+    mk_lcomb(wdbp, "all.g", &all, 0, nullptr, nullptr, nullptr, 0);
+    wdb_close(wdbp);
+    return path;
+}
+
+int addModel(Model* model, const std::string& name, int spheres) {
+    std::string path = writeModelFile(name, spheres);
+    model->insertModel({0, name, "", "{}", "", {}, "", path, "Library", false, false, true, {}});
+    return model->getModelByFilePath(path).id;
+}
+
+// Records the signature the worker would, so only the stages not marked
+// done are due
+void markIndexed(Model* model, int modelId, unsigned int stagesDone) {
+    std::string path = model->getModelById(modelId).file_path;
+    auto mtime = std::filesystem::last_write_time(path);
+    int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count();
+    model->setFileSignature(modelId, static_cast<int64_t>(std::filesystem::file_size(path)), nanos, 1);
+    model->setStageState(modelId, stagesDone, Model::StageDone);
+}
+
+// Sets a setting for the lifetime of the object, then puts it back
+class ScopedSetting {
+public:
+    ScopedSetting(const QString& key, const QVariant& value) : key(key) {
+        old = settings.value(key);
+        settings.setValue(key, value);
+    }
+    ~ScopedSetting() {
+        if (old.isValid()) {
+            settings.setValue(key, old);
+        } else {
+            settings.remove(key);
+        }
+    }
+
+private:
+    QSettings settings;
+    QString key;
+    QVariant old;
+};
+
+int stageState(Model* model, int modelId, unsigned int stage) {
+    for (const auto& status : model->getStageStatus(modelId)) {
+        if (status.stage == stage) {
+            return status.state;
+        }
+    }
+    return Model::StagePending;
+}
+
+std::string storedThumbnail(Model* model, int modelId) {
+    std::unique_ptr<BlobDevice> device = model->openThumbnail(modelId, 0);
+    if (!device) {
+        return std::string();
+    }
+    QByteArray bytes = device->readAll();
+    return std::string(bytes.constData(), bytes.size());
+}
+
+// Model ids in the order the worker took up their work items
+std::vector<int> runWorker(Library& library) {
+    IndexingWorker worker(&library);
+    std::vector<int> order;
+    std::mutex orderMutex;
+    QObject::connect(&worker, &IndexingWorker::modelProcessed, [&](int modelId) {
+        std::lock_guard<std::mutex> lock(orderMutex);
+        order.push_back(modelId);
+    });
+    worker.process();
+    return order;
+}
+
+}  // namespace
 
 TEST_CASE("IndexingWorker Basic Initialization", "[IndexingWorker]") {
     // int argc = 0;
@@ -29,3 +129,132 @@ TEST_CASE("IndexingWorker Basic Initialization", "[IndexingWorker]") {
 
 
 }
+
+TEST_CASE("IndexingWorker Shortest Job First", "[IndexingWorker]") {
+    std::filesystem::remove_all(TEST_LIBRARY_PATH);
+    std::filesystem::create_directories(TEST_LIBRARY_PATH);
+    ScopedSetting threads("indexingThreads", 1);
+    {
+        Library library("Test Library", TEST_LIBRARY_PATH.c_str());
+        Model* model = library.getModel();
+
+        // New files: a whole first pass each, cheapest (smallest) first
+        int large = addModel(model, "large", 400);
+        int small = addModel(model, "small", 1);
+        int medium = addModel(model, "medium", 50);
+
+        // Files with only the full-size render left, at measured costs
+        unsigned int allButThumbnail = Model::IndexingStages & ~Model::ThumbnailStage;
+        int slow = addModel(model, "slow", 1);
+        int quick = addModel(model, "quick", 1);
+        int middling = addModel(model, "middling", 1);
+        for (auto [modelId, cost] : std::vector<std::pair<int, int>>{{slow, 300}, {quick, 100}, {middling, 200}}) {
+            markIndexed(model, modelId, allButThumbnail);
+            model->setRenderCost(modelId, cost);
+        }
+
+        std::vector<int> order = runWorker(library);
+
+        // Every first pass before any full render, in order of size
+        REQUIRE(order.size() >= 6);
+        REQUIRE((std::vector<int>(order.begin(), order.begin() + 3) == std::vector<int>{small, medium, large}));
+
+        // Full renders after, cheapest first
+        std::vector<int> refinements;
+        for (auto it = order.begin() + 3; it != order.end(); ++it) {
+            if (*it == slow || *it == quick || *it == middling) {
+                refinements.push_back(*it);
+            }
+        }
+        REQUIRE((refinements == std::vector<int>{quick, middling, slow}));
+    }
+    std::filesystem::remove_all(TEST_LIBRARY_PATH);
+}
+
+TEST_CASE("IndexingWorker Progressive Thumbnails", "[IndexingWorker]") {
+    std::filesystem::remove_all(TEST_LIBRARY_PATH);
+    std::filesystem::create_directories(TEST_LIBRARY_PATH);
+    {
+        Library library("Test Library", TEST_LIBRARY_PATH.c_str());
+        Model* model = library.getModel();
+
+        SECTION("Every Preview Before Any Full Render") {
+            ScopedSetting threads("indexingThreads", 1);
+            std::vector<int> ids = {addModel(model, "a", 1), addModel(model, "b", 2), addModel(model, "c", 3)};
+
+            std::vector<int> order = runWorker(library);
+            REQUIRE(order.size() == 6);
+            std::vector<int> firstPasses(order.begin(), order.begin() + 3);
+            std::vector<int> fullRenders(order.begin() + 3, order.end());
+            std::sort(firstPasses.begin(), firstPasses.end());
+            std::sort(fullRenders.begin(), fullRenders.end());
+            REQUIRE(firstPasses == ids);
+            REQUIRE(fullRenders == ids);
+            for (int modelId : ids) {
+                REQUIRE(stageState(model, modelId, Model::PreviewStage) == Model::StageDone);
+                REQUIRE(stageState(model, modelId, Model::ThumbnailStage) == Model::StageDone);
+            }
+        }
+
+        SECTION("Idle Thread Waits For A Full Render") {
+            // The second thread finds only the full render of a first pass
+            // still running; it waits for it instead of giving up
+            ScopedSetting threads("indexingThreads", 2);
+            int modelId = addModel(model, "only", 1);
+
+            std::vector<int> order = runWorker(library);
+            REQUIRE((order == std::vector<int>{modelId, modelId}));
+            REQUIRE(stageState(model, modelId, Model::ThumbnailStage) == Model::StageDone);
+        }
+
+        SECTION("No Preview Over A Full-Size Thumbnail") {
+            ScopedSetting threads("indexingThreads", 1);
+            int modelId = addModel(model, "rendered", 1);
+            REQUIRE(model->writeThumbnailAsync(modelId, "full size").get());
+            markIndexed(model, modelId, Model::ThumbnailStage);
+
+            // Metadata and hierarchy are redone; the thumbnail is left alone
+            std::vector<int> order = runWorker(library);
+            REQUIRE((order == std::vector<int>{modelId}));
+            REQUIRE(stageState(model, modelId, Model::HierarchyStage) == Model::StageDone);
+            REQUIRE(stageState(model, modelId, Model::PreviewStage) == Model::StagePending);
+            REQUIRE(storedThumbnail(model, modelId) == "full size");
+        }
+    }
+    std::filesystem::remove_all(TEST_LIBRARY_PATH);
+}
+
+TEST_CASE("IndexingWorker Concurrent Threads", "[IndexingWorker]") {
+    std::filesystem::remove_all(TEST_LIBRARY_PATH);
+    std::filesystem::create_directories(TEST_LIBRARY_PATH);
+    ScopedSetting threads("indexingThreads", 4);
+    {
+        Library library("Test Library", TEST_LIBRARY_PATH.c_str());
+        Model* model = library.getModel();
+
+        const int fileCount = 12;
+        std::vector<int> ids;
+        std::vector<int> spheres;
+        for (int i = 0; i < fileCount; ++i) {
+            spheres.push_back(1 + i % 3);
+            ids.push_back(addModel(model, "part" + std::to_string(i), spheres.back()));
+        }
+
+        // Each file's first pass and full render, each taken up by one
+        // thread exactly once
+        std::vector<int> order = runWorker(library);
+        REQUIRE(order.size() == 2 * ids.size());
+        for (int modelId : ids) {
+            REQUIRE(std::count(order.begin(), order.end(), modelId) == 2);
+        }
+
+        // Every file fully indexed: all.g and each of its balls, once
+        for (int i = 0; i < fileCount; ++i) {
+            REQUIRE(model->getModelById(ids[i]).is_processed);
+            REQUIRE(stageState(model, ids[i], Model::ThumbnailStage) == Model::StageDone);
+            REQUIRE(model->getObjectsForModel(ids[i]).size() == static_cast<size_t>(1 + spheres[i]));
+        }
+        REQUIRE(model->getQuarantinedStages().empty());
+    }
+    std::filesystem::remove_all(TEST_LIBRARY_PATH);
+}
@@ -3,7 +3,14 @@
 #include <catch2/catch_test_macros.hpp>
 #include <fstream>
 #include "Model.h"
+#include "QueryStats.h"
+#include <QBuffer>
 #include <filesystem>
+#include <algorithm>
+#include <future>
+#include <stdexcept>
+#include <set>
+#include <thread>
 #include <memory>
 
 // Helper function to create a temporary test directory
@@ -186,23 +193,36 @@ TEST_CASE("Model: Hashing Functionality", "[Model]") {
 
     // Test hashing a valid file
     SECTION("Hashing a Valid File") {
-        int hashValue = model.hashModel(validFilePath);
+        uint64_t hashValue = model.hashModel(validFilePath);
         REQUIRE(hashValue != 0); // Ensure a valid hash is produced
     }
 
     // Test hashing an empty file
     SECTION("Hashing an Empty File") {
-        int hashValue = model.hashModel(emptyFilePath);
+        uint64_t hashValue = model.hashModel(emptyFilePath);
         REQUIRE(hashValue != 0); // Hashing should still produce a valid value
     }
 
     // Test hashing a nonexistent file
     SECTION("Hashing a Nonexistent File") {
         std::string invalidFilePath = testDir + "/nonexistent.txt";
-        int hashValue = model.hashModel(invalidFilePath);
+        uint64_t hashValue = model.hashModel(invalidFilePath);
         REQUIRE(hashValue == 0); // Nonexistent file should return a hash of 0
     }
 
+    // Test the digest against published XXH64 vectors
+    SECTION("Hashing Matches XXH64") {
+        REQUIRE(model.hashModel(emptyFilePath) == 0xEF46DB3751D8E999ULL);
+
+        std::string abcPath = testDir + "/abc.txt";
+        std::ofstream(abcPath) << "abc";
+        REQUIRE(model.hashModel(abcPath) == 0x44BC2CF5AD770999ULL);
+
+        std::string longPath = testDir + "/long.txt";
+        std::ofstream(longPath) << "Nobody inspects the spammish repetition";
+        REQUIRE(model.hashModel(longPath) == 0xFBCEA83C8A378BF1ULL);
+    }
+
     cleanupTestDirectory(testDir);
 }
 
@@ -555,4 +575,1382 @@ TEST_CASE("Model: Get Included Not Processed Models", "[Model]") {
 
     // Clean up after test execution
     cleanupTestDirectory(testDir);
-}
\ No newline at end of file
+}
+// Test case for partial updates through a field mask
+TEST_CASE("Model: Update Model Fields", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+
+    Model model(testDir);
+
+    ModelData modelData = {0, "PartialModel", "./file", "{}", "Title", {'P', 'N', 'G'}, "Author", "/partial/path", "Library", false, false, false, {}};
+    REQUIRE(model.insertModel(modelData));
+
+    auto fetched = model.getModelByFilePath(modelData.file_path);
+    REQUIRE(model.addTagToModel(fetched.id, "KeepMe"));
+
+    // Only is_included is written; thumbnail, title and tags are untouched
+    SECTION("Flip Only IsIncluded") {
+        ModelData patch = fetched;
+        patch.is_included = true;
+        patch.title = "Ignored Title";
+        patch.thumbnail.clear();
+        REQUIRE(model.updateModelFields(fetched.id, patch, Model::IsIncludedField));
+
+        auto updated = model.getModelById(fetched.id);
+        REQUIRE(updated.is_included == true);
+        REQUIRE(updated.title == "Title");
+        REQUIRE(updated.thumbnail.size() == 3);
+        REQUIRE(model.getTagsForModel(fetched.id).size() == 1);
+
+        QModelIndex index = model.index(0, 0);
+        REQUIRE(model.data(index, Model::IsIncludedRole).toBool() == true);
+        REQUIRE(model.data(index, Model::TitleRole).toString().toStdString() == "Title");
+    }
+
+    // Tags are diffed against the stored set rather than rewritten
+    SECTION("Sync Tags") {
+        ModelData patch = fetched;
+        patch.tags = {"KeepMe", "NewTag"};
+        REQUIRE(model.updateModelFields(fetched.id, patch, Model::TagsField));
+
+        auto tags = model.getTagsForModel(fetched.id);
+        REQUIRE(tags.size() == 2);
+        REQUIRE(std::find(tags.begin(), tags.end(), "NewTag") != tags.end());
+    }
+
+    // Renaming to an existing short_name still gets a unique suffix
+    SECTION("Short Name Uniqueness") {
+        ModelData other = {0, "OtherModel", "./other", "{}", "Other", {}, "Author", "/other/path", "Library", false, false, false, {}};
+        REQUIRE(model.insertModel(other));
+
+        ModelData patch = fetched;
+        patch.short_name = "OtherModel";
+        REQUIRE(model.updateModelFields(fetched.id, patch, Model::ShortNameField));
+        REQUIRE(model.getModelById(fetched.id).short_name == "OtherModel_1");
+    }
+
+    cleanupTestDirectory(testDir);
+}
+
+// Test case for full-text search across models, tags and objects
+TEST_CASE("Model: Search Models", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+
+    Model model(testDir);
+
+    ModelData truck = {0, "truck", "./truck.g", "{}", "Heavy Truck", {}, "Alice", "/lib/vehicles/truck.g", "Library", false, false, false, {}};
+    ModelData tank = {0, "tank", "./tank.g", "{}", "Main Battle Tank", {}, "Bob", "/lib/vehicles/tank.g", "Library", false, false, false, {}};
+    REQUIRE(model.insertModel(truck));
+    REQUIRE(model.insertModel(tank));
+
+    int truckId = model.getModelByFilePath(truck.file_path).id;
+    int tankId = model.getModelByFilePath(tank.file_path).id;
+    REQUIRE(model.addTagToModel(tankId, "armored"));
+    REQUIRE(model.insertObject({0, truckId, "wheelbase.r", -1, false}) != -1);
+
+    SECTION("Prefix Match On Title") {
+        auto ids = model.searchModels("batt");
+        REQUIRE(ids.size() == 1);
+        REQUIRE(ids[0] == tankId);
+    }
+
+    SECTION("Match On Tags And Object Names") {
+        REQUIRE(model.searchModels("armored") == std::vector<int>{tankId});
+        REQUIRE(model.searchModels("wheelbase") == std::vector<int>{truckId});
+    }
+
+    SECTION("Typo Tolerance") {
+        REQUIRE(model.searchModels("truk") == std::vector<int>{truckId});
+        REQUIRE(model.searchModels("whel") == std::vector<int>{truckId});
+    }
+
+    SECTION("Closest Spellings Win Over Alphabetical Order") {
+        // Seventeen distance-2 terms that sort before "wheelbase"
+        for (char c = 'a'; c <= 'q'; ++c) {
+            std::string name = std::string("wheela") + c + "se.r";
+            REQUIRE(model.insertObject({0, tankId, name, -1, false}) != -1);
+        }
+        auto ids = model.searchModels("wheelbse");
+        REQUIRE(std::find(ids.begin(), ids.end(), truckId) != ids.end());
+    }
+
+    SECTION("Index Follows Updates And Deletes") {
+        REQUIRE(model.setPropertyForModel(truckId, "title", "Pickup"));
+        REQUIRE(model.searchModels("pickup") == std::vector<int>{truckId});
+
+        REQUIRE(model.removeTagFromModel(tankId, "armored"));
+        REQUIRE(model.searchModels("armored").empty());
+
+        REQUIRE(model.deleteModel(tankId));
+        REQUIRE(model.searchModels("tank").empty());
+    }
+
+    SECTION("Empty Query") {
+        REQUIRE(model.searchModels("  ").empty());
+    }
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Reads Alongside The Writer", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+    Model model(testDir);
+
+    ModelData committed = {0, "Committed", "", "{}", "Committed Title", {}, "Author", "/committed.g", "Library", false, false, true, {}};
+    REQUIRE(model.insertModel(committed));
+    int committedId = model.getModelByFilePath(committed.file_path).id;
+
+    model.beginTransaction();
+    ModelData pending = {0, "Pending", "", "{}", "Pending Title", {}, "Author", "/pending.g", "Library", false, false, true, {}};
+    REQUIRE(model.insertModel(pending));
+
+    SECTION("Writer Thread Sees Its Own Uncommitted Rows") {
+        REQUIRE(model.getModelByFilePath(pending.file_path).id != 0);
+    }
+
+    SECTION("Other Threads Read The Last Commit Without Blocking") {
+        auto reader = std::async(std::launch::async, [&]() {
+            return std::make_pair(model.getModelById(committedId).short_name,
+                                  model.getModelByFilePath(pending.file_path).id);
+        });
+        REQUIRE(reader.wait_for(std::chrono::seconds(2)) == std::future_status::ready);
+        auto result = reader.get();
+        REQUIRE(result.first == "Committed");
+        REQUIRE(result.second == 0);
+    }
+
+    model.commitTransaction();
+    REQUIRE(model.getModelByFilePath(pending.file_path).id != 0);
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Lazy Row Loading", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+
+    const int total = 450;
+    {
+        Model writer(testDir);
+        writer.beginTransaction();
+        for (int i = 0; i < total; ++i) {
+            std::string name = "Model" + std::to_string(i);
+            REQUIRE(writer.insertModel({0, name, "", "{}", "Title", {}, "Author", "/" + name + ".g", "Library", false, false, i % 2 == 0, {}}));
+        }
+        writer.commitTransaction();
+    }
+
+    Model model(testDir);
+
+    SECTION("Rows Arrive A Page At A Time") {
+        REQUIRE(model.rowCount() < total);
+        REQUIRE(model.canFetchMore(QModelIndex()));
+
+        while (model.canFetchMore(QModelIndex())) {
+            model.fetchMore(QModelIndex());
+        }
+        REQUIRE(model.rowCount() == total);
+    }
+
+    SECTION("Row Data Is Materialized On Demand") {
+        QModelIndex first = model.index(0);
+        REQUIRE(model.data(first, Model::ShortNameRole).toString().toStdString() == "Model0");
+        REQUIRE(model.data(first, Model::IsIncludedRole).toBool());
+        REQUIRE_FALSE(model.data(model.index(1), Model::IsIncludedRole).toBool());
+    }
+
+    SECTION("Fetch Through A Specific Id") {
+        int lastId = model.getModelByFilePath("/Model449.g").id;
+        model.fetchThrough(lastId);
+        REQUIRE(model.rowCount() == total);
+        REQUIRE_FALSE(model.canFetchMore(QModelIndex()));
+    }
+
+    SECTION("Inserts Append Once Every Page Is Loaded") {
+        while (model.canFetchMore(QModelIndex())) {
+            model.fetchMore(QModelIndex());
+        }
+        REQUIRE(model.insertModel({0, "Extra", "", "{}", "Title", {}, "Author", "/Extra.g", "Library", false, false, true, {}}));
+        REQUIRE(model.rowCount() == total + 1);
+        REQUIRE(model.data(model.index(total), Model::ShortNameRole).toString().toStdString() == "Extra");
+    }
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: File Signatures", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+    Model model(testDir);
+
+    REQUIRE(model.insertModel({0, "Included", "", "{}", "", {}, "", "/included.g", "Library", false, true, true, {}}));
+    REQUIRE(model.insertModel({0, "Excluded", "", "{}", "", {}, "", "/excluded.g", "Library", false, false, false, {}}));
+    int includedId = model.getModelByFilePath("/included.g").id;
+
+    auto signatures = model.getIncludedFileSignatures();
+    REQUIRE(signatures.size() == 1);
+    REQUIRE(signatures[0].model_id == includedId);
+    REQUIRE(signatures[0].is_processed);
+    REQUIRE(signatures[0].hash == 0);
+
+    // Hashes above INT64_MAX must survive the trip through a signed column
+    const uint64_t hash = 0xFBCEA83C8A378BF1ULL;
+    REQUIRE(model.setFileSignature(includedId, 1234, 5678, hash));
+    signatures = model.getIncludedFileSignatures();
+    REQUIRE(signatures[0].size == 1234);
+    REQUIRE(signatures[0].mtime == 5678);
+    REQUIRE(signatures[0].hash == hash);
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Selection Projections", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+    Model model(testDir);
+
+    std::vector<char> thumbnail(4096, 'x');
+    REQUIRE(model.insertModel({0, "First", "", "{}", "First Title", thumbnail, "Author", "/first.g", "Library", true, false, true, {}}));
+    REQUIRE(model.insertModel({0, "Second", "", "{}", "Second Title", thumbnail, "Author", "/second.g", "Library", false, false, true, {}}));
+    REQUIRE(model.insertModel({0, "Third", "", "{}", "Third Title", thumbnail, "Author", "/third.g", "Library", true, false, true, {}}));
+    int firstId = model.getModelByFilePath("/first.g").id;
+    int thirdId = model.getModelByFilePath("/third.g").id;
+
+    REQUIRE(model.countSelected() == 2);
+    std::vector<int> expectedIds = {firstId, thirdId};
+    REQUIRE(model.getSelectedModelIds() == expectedIds);
+
+    auto summaries = model.getSelectedModelSummaries();
+    REQUIRE(summaries.size() == 2);
+    REQUIRE(summaries[0].id == firstId);
+    REQUIRE(summaries[0].short_name == "First");
+    REQUIRE(summaries[1].title == "Third Title");
+    REQUIRE(summaries[1].file_path == "/third.g");
+
+    // The full-row API still agrees with the projections
+    REQUIRE(model.getSelectedModels().size() == 2);
+    REQUIRE(model.getSelectedModels()[1].title == "Third Title");
+
+    // More selected models than one page of the keyset query
+    for (int i = 0; i < 250; ++i) {
+        std::string path = "/bulk" + std::to_string(i) + ".g";
+        REQUIRE(model.insertModel({0, "Bulk" + std::to_string(i), "", "{}", "", {}, "", path, "Library", true, false, true, {}}));
+    }
+    std::vector<ModelData> selected = model.getSelectedModels();
+    REQUIRE(selected.size() == 252);
+    REQUIRE(selected.back().file_path == "/bulk249.g");
+    for (size_t i = 1; i < selected.size(); ++i) {
+        REQUIRE(selected[i - 1].id < selected[i].id);
+    }
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Catalog Statistics", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+    Model model(testDir);
+
+    SECTION("Empty Catalog") {
+        CatalogStatistics stats = model.statistics();
+        REQUIRE(stats.total == 0);
+        REQUIRE(stats.included == 0);
+        REQUIRE(stats.tagCounts.empty());
+    }
+
+    SECTION("Counts Follow The Rows") {
+        REQUIRE(model.insertModel({0, "A", "", "{}", "", {}, "", "/a.g", "Library", true, true, true, {}}));
+        REQUIRE(model.insertModel({0, "B", "", "{}", "", {}, "", "/b.g", "Library", false, false, true, {}}));
+        REQUIRE(model.insertModel({0, "C", "", "{}", "", {}, "", "/c.g", "Library", true, true, false, {}}));
+        int aId = model.getModelByFilePath("/a.g").id;
+        int bId = model.getModelByFilePath("/b.g").id;
+        REQUIRE(model.addTagToModel(aId, "vehicle"));
+        REQUIRE(model.addTagToModel(bId, "vehicle"));
+        REQUIRE(model.addTagToModel(bId, "draft"));
+        REQUIRE(model.removeTagFromModel(bId, "draft"));
+
+        CatalogStatistics stats = model.statistics();
+        REQUIRE(stats.total == 3);
+        REQUIRE(stats.included == 2);
+        REQUIRE(stats.processed == 2);
+        REQUIRE(stats.selected == 2);
+        REQUIRE(stats.includedProcessed == 1);
+        REQUIRE(stats.tagCounts["vehicle"] == 2);
+        REQUIRE(stats.tagCounts.count("draft") == 1);
+        REQUIRE(stats.tagCounts["draft"] == 0);
+    }
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Group-Committed Writes", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+
+    int modelId = 0;
+    size_t expectedObjects = 0;
+    {
+        Model model(testDir);
+        REQUIRE(model.insertModel({0, "Queued", "", "{}", "", {}, "", "/queued.g", "Library", false, false, true, {}}));
+        modelId = model.getModelByFilePath("/queued.g").id;
+
+        SECTION("Futures Carry The Assigned Ids") {
+            std::future<int> parent = model.insertObjectAsync({0, modelId, "parent", -1, false});
+            int parentId = parent.get();
+            REQUIRE(parentId > 0);
+            std::future<int> child = model.insertObjectAsync({0, modelId, "child", parentId, true});
+            REQUIRE(child.get() > parentId);
+
+            model.flushWrites();
+            auto objects = model.getObjectsForModel(modelId);
+            REQUIRE(objects.size() == 2);
+            REQUIRE(model.getSelectedObjectsForModel(modelId).front().parent_object_id == parentId);
+            expectedObjects = 2;
+        }
+
+        SECTION("Concurrent Producers") {
+            const int threads = 4;
+            const int perThread = 250;
+            std::vector<std::thread> producers;
+            std::vector<std::vector<int>> ids(threads);
+            for (int t = 0; t < threads; ++t) {
+                producers.emplace_back([&, t]() {
+                    std::vector<std::future<int>> futures;
+                    for (int i = 0; i < perThread; ++i) {
+                        futures.push_back(model.insertObjectAsync({0, modelId, "obj" + std::to_string(t) + "_" + std::to_string(i), -1, false}));
+                    }
+                    for (auto& f : futures) ids[t].push_back(f.get());
+                    model.flushWrites();
+                });
+            }
+            for (auto& p : producers) p.join();
+
+            std::set<int> unique;
+            for (const auto& list : ids) {
+                // One producer's commands run in the order it queued them
+                REQUIRE(std::is_sorted(list.begin(), list.end()));
+                unique.insert(list.begin(), list.end());
+            }
+            REQUIRE(unique.size() == threads * perThread);
+            REQUIRE(model.getObjectsForModel(modelId).size() == threads * perThread);
+            expectedObjects = threads * perThread;
+        }
+
+        SECTION("Queued Field Updates") {
+            ModelData changed = model.getModelById(modelId);
+            changed.title = "Updated";
+            changed.is_processed = true;
+            REQUIRE(model.updateModelFieldsAsync(modelId, changed, Model::TitleField | Model::IsProcessedField).get());
+            model.flushWrites();
+            REQUIRE(model.getModelById(modelId).title == "Updated");
+        }
+
+        SECTION("Pending Writes Survive Shutdown") {
+            for (int i = 0; i < 50; ++i) {
+                model.insertObjectAsync({0, modelId, "late" + std::to_string(i), -1, false});
+            }
+            expectedObjects = 50;
+        }
+    }
+
+    Model reopened(testDir);
+    REQUIRE(reopened.getModelById(modelId).short_name == "Queued");
+    REQUIRE(reopened.getObjectsForModel(modelId).size() == expectedObjects);
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Catalog Writer Survives A Throwing Command", "[Model]") {
+    std::recursive_mutex batchMutex;
+    std::atomic<int> commits(0);
+    CatalogWriter writer([&]() { batchMutex.lock(); },
+                         [&]() { commits++; batchMutex.unlock(); },
+                         16, std::chrono::milliseconds(5));
+
+    std::future<int> failed = writer.submit([]() -> int { throw std::runtime_error("disk on fire"); });
+    std::future<int> next = writer.submit([]() { return 7; });
+
+    // The failure reaches whoever waits on it; later commands still run
+    bool threw = false;
+    try {
+        failed.get();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    REQUIRE(threw);
+    REQUIRE(next.get() == 7);
+    writer.flush();
+    REQUIRE(commits.load() >= 1);
+
+    // The batch lock was released, so other writers don't hang
+    REQUIRE(batchMutex.try_lock());
+    batchMutex.unlock();
+}
+
+TEST_CASE("Model: Catalog Writer Holds No Lock While Collecting", "[Model]") {
+    std::recursive_mutex batchMutex;
+    CatalogWriter writer([&]() { batchMutex.lock(); },
+                         [&]() { batchMutex.unlock(); },
+                         16, std::chrono::milliseconds(300));
+
+    // The writer is waiting for more commands; synchronous writers get in
+    std::future<int> queued = writer.submit([]() { return 1; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE(queued.wait_for(std::chrono::seconds(0)) == std::future_status::timeout);
+    REQUIRE(batchMutex.try_lock());
+    batchMutex.unlock();
+
+    REQUIRE(queued.get() == 1);
+    writer.flush();
+}
+
+TEST_CASE("Model: Tag Bitmap Index", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+
+    {
+        Model model(testDir);
+        REQUIRE(model.insertModel({0, "A", "", "{}", "", {}, "", "/a.g", "Library", false, false, true, {}}));
+        REQUIRE(model.insertModel({0, "B", "", "{}", "", {}, "", "/b.g", "Library", false, false, true, {}}));
+        REQUIRE(model.insertModel({0, "C", "", "{}", "", {}, "", "/c.g", "Library", false, false, true, {}}));
+        REQUIRE(model.insertModel({0, "D", "", "{}", "", {}, "", "/d.g", "Library", false, false, true, {}}));
+        int aId = model.getModelByFilePath("/a.g").id;
+        int bId = model.getModelByFilePath("/b.g").id;
+        int cId = model.getModelByFilePath("/c.g").id;
+        int dId = model.getModelByFilePath("/d.g").id;
+        REQUIRE(model.addTagToModel(aId, "steel"));
+        REQUIRE(model.addTagToModel(aId, "bolt"));
+        REQUIRE(model.addTagToModel(bId, "steel"));
+        REQUIRE(model.addTagToModel(bId, "nut"));
+        REQUIRE(model.addTagToModel(bId, "obsolete"));
+        REQUIRE(model.addTagToModel(cId, "steel"));
+        REQUIRE(model.addTagToModel(cId, "nut"));
+        REQUIRE(model.addTagToModel(dId, "old part"));
+
+        SECTION("Boolean Expressions") {
+            std::vector<int> steelParts = {aId, cId};
+            REQUIRE(model.modelsMatchingTags("steel AND (bolt OR nut) AND NOT obsolete") == steelParts);
+            std::vector<int> nuts = {bId, cId};
+            REQUIRE(model.modelsMatchingTags("steel nut") == nuts);
+            std::vector<int> untagged = {dId};
+            REQUIRE(model.modelsMatchingTags("not steel") == untagged);
+            REQUIRE(model.modelsMatchingTags("\"old part\"") == untagged);
+            REQUIRE(model.modelsMatchingTags("").size() == 4);
+            REQUIRE(model.modelsMatchingTags("unknown").empty());
+            REQUIRE(model.modelsMatchingTags("steel AND (bolt").empty());
+            REQUIRE(model.modelsMatchingTags("steel OR").empty());
+        }
+
+        SECTION("Facet Counts") {
+            std::map<std::string, int> facets = model.tagFacets("steel");
+            REQUIRE(facets["steel"] == 3);
+            REQUIRE(facets["nut"] == 2);
+            REQUIRE(facets["bolt"] == 1);
+            REQUIRE(facets["old part"] == 0);
+            REQUIRE(model.tagFacets("NOT nut")["steel"] == 1);
+        }
+
+        SECTION("Writes Keep The Index Current") {
+            REQUIRE(model.removeTagFromModel(bId, "obsolete"));
+            std::vector<int> nuts = {bId, cId};
+            REQUIRE(model.modelsMatchingTags("steel AND nut AND NOT obsolete") == nuts);
+
+            ModelData retagged = model.getModelById(cId);
+            retagged.tags = {"bolt"};
+            REQUIRE(model.updateModelFields(cId, retagged, Model::TagsField));
+            std::vector<int> bolts = {aId, cId};
+            REQUIRE(model.modelsMatchingTags("bolt") == bolts);
+
+            REQUIRE(model.removeAllTagsFromModel(aId));
+            REQUIRE(model.deleteModel(dId));
+            std::vector<int> untagged = {aId};
+            REQUIRE(model.modelsMatchingTags("NOT (steel OR bolt)") == untagged);
+            REQUIRE(model.modelsMatchingTags("\"old part\"").empty());
+        }
+
+        SECTION("Transactions Reach The Index On Commit") {
+            std::vector<int> steel = {aId, bId, cId};
+            model.beginTransaction();
+            REQUIRE(model.addTagToModel(dId, "steel"));
+            REQUIRE(model.removeTagFromModel(aId, "steel"));
+            REQUIRE(model.modelsMatchingTags("steel") == steel);
+            model.commitTransaction();
+
+            std::vector<int> committed = {bId, cId, dId};
+            REQUIRE(model.modelsMatchingTags("steel") == committed);
+        }
+    }
+
+    SECTION("Rebuilt On Load") {
+        Model reopened(testDir);
+        REQUIRE(reopened.modelsMatchingTags("steel AND nut").size() == 2);
+        REQUIRE(reopened.tagFacets("")["steel"] == 3);
+    }
+
+    SECTION("Dense Containers") {
+        TagBitmap evens, threes;
+        for (uint32_t i = 0; i < 200000; i += 2) evens.add(i);
+        for (uint32_t i = 0; i < 200000; i += 3) threes.add(i);
+        REQUIRE(evens.cardinality() == 100000);
+        REQUIRE(TagBitmap::intersectCount(evens, threes) == 33334);
+        REQUIRE(TagBitmap::intersect(evens, threes).cardinality() == 33334);
+        REQUIRE(TagBitmap::unite(evens, threes).cardinality() == 133333);
+
+        TagBitmap odds = TagBitmap::subtract(TagBitmap::unite(evens, threes), evens);
+        REQUIRE(odds.cardinality() == 33333);
+        REQUIRE(odds.contains(3));
+        REQUIRE_FALSE(odds.contains(6));
+        for (uint32_t i = 0; i < 200000; i += 2) evens.remove(i);
+        REQUIRE(evens.empty());
+    }
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Object Closure Table", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+
+    int modelId = 0;
+    int allId = 0, regionId = 0, solidId = 0, otherId = 0;
+    {
+        Model model(testDir);
+        REQUIRE(model.insertModel({0, "Tank", "", "{}", "", {}, "", "/tank.g", "Library", false, false, true, {}}));
+        REQUIRE(model.insertModel({0, "Truck", "", "{}", "", {}, "", "/truck.g", "Library", false, false, true, {}}));
+        modelId = model.getModelByFilePath("/tank.g").id;
+        int truckId = model.getModelByFilePath("/truck.g").id;
+
+        allId = model.insertObject({0, modelId, "all.g", -1, true});
+        regionId = model.insertObject({0, modelId, "hull.r", allId, false});
+        solidId = model.insertObject({0, modelId, "wheel.s", regionId, false});
+        otherId = model.insertObject({0, modelId, "turret.r", allId, false});
+        model.insertObject({0, truckId, "wheel.s", -1, false});
+
+        SECTION("Subtree And Ancestors") {
+            std::vector<ObjectData> subtree = model.getSubtree(allId);
+            REQUIRE(subtree.size() == 4);
+            REQUIRE(subtree.front().object_id == allId);
+            REQUIRE(subtree.back().object_id == solidId);
+            REQUIRE(model.getSubtree(regionId).size() == 2);
+
+            std::vector<ObjectData> ancestors = model.getAncestors(solidId);
+            REQUIRE(ancestors.size() == 2);
+            REQUIRE(ancestors[0].object_id == regionId);
+            REQUIRE(ancestors[1].object_id == allId);
+
+            REQUIRE(model.getObjectDepth(allId) == 0);
+            REQUIRE(model.getObjectDepth(solidId) == 2);
+            REQUIRE(model.getObjectDepth(999999) == -1);
+
+            std::vector<int> expectedModels = {modelId, truckId};
+            REQUIRE(model.getModelsContainingObject("wheel.s") == expectedModels);
+        }
+
+        SECTION("Reparenting Moves The Subtree") {
+            REQUIRE(model.updateObjectParentId(regionId, otherId));
+            REQUIRE(model.getObjectDepth(solidId) == 3);
+            REQUIRE(model.getSubtree(otherId).size() == 3);
+
+            std::vector<ObjectData> ancestors = model.getAncestors(solidId);
+            REQUIRE(ancestors.size() == 3);
+            REQUIRE(ancestors[1].object_id == otherId);
+        }
+
+        SECTION("Deleting Objects Clears Their Rows") {
+            REQUIRE(model.deleteObjectsForModel(modelId));
+            REQUIRE(model.getSubtree(allId).empty());
+            REQUIRE(model.getObjectDepth(solidId) == -1);
+        }
+    }
+
+    SECTION("Backfilled For Existing Databases") {
+        sqlite3* raw = nullptr;
+        std::string dbFile = testDir + "/.cadventory/metadata.db";
+        REQUIRE(sqlite3_open(dbFile.c_str(), &raw) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(raw, "DROP TABLE object_closure;", nullptr, nullptr, nullptr) == SQLITE_OK);
+        sqlite3_close(raw);
+
+        Model reopened(testDir);
+        REQUIRE(reopened.getObjectDepth(solidId) == 2);
+        REQUIRE(reopened.getSubtree(allId).size() == 4);
+    }
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Packed Object Trees", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+    Model model(testDir);
+
+    // Added out of preorder on purpose: the turret comes before the hull's wheel
+    ObjectTreeBuilder builder;
+    int all = builder.addNode("all.g", -1);
+    int hull = builder.addNode("hull.r", all);
+    builder.addNode("turret.r", all);
+    builder.addNode("wheel.s", hull);
+    builder.addNode("ground.s", -1);
+
+    SECTION("Encode And Decode") {
+        ObjectTree tree(builder.encode());
+        REQUIRE(tree.isValid());
+        REQUIRE(tree.size() == 5);
+        REQUIRE(tree.name(0) == "all.g");
+        REQUIRE(tree.name(1) == "hull.r");
+        REQUIRE(tree.name(2) == "wheel.s");
+        REQUIRE(tree.name(3) == "turret.r");
+        REQUIRE(tree.parent(2) == 1);
+        REQUIRE(tree.parent(4) == -1);
+        REQUIRE(tree.subtreeEnd(0) == 4);
+
+        std::vector<size_t> roots = {0, 4};
+        REQUIRE(tree.children(-1) == roots);
+        std::vector<size_t> underAll = {1, 3};
+        REQUIRE(tree.children(0) == underAll);
+        REQUIRE(tree.hasChildren(1));
+        REQUIRE_FALSE(tree.hasChildren(2));
+    }
+
+    SECTION("Rejects Damaged Blobs") {
+        std::vector<char> bytes = builder.encode();
+        bytes.pop_back();
+        REQUIRE_FALSE(ObjectTree(bytes).isValid());
+        REQUIRE_FALSE(ObjectTree(std::vector<char>{'n', 'o', 'p', 'e'}).isValid());
+        REQUIRE_FALSE(ObjectTree().isValid());
+    }
+
+    SECTION("Stored Per Model") {
+        REQUIRE(model.insertModel({0, "Tank", "", "{}", "", {}, "", "/tank.g", "Library", false, false, true, {}}));
+        int modelId = model.getModelByFilePath("/tank.g").id;
+        REQUIRE_FALSE(model.getObjectTree(modelId).isValid());
+
+        REQUIRE(model.setObjectTreeAsync(modelId, builder.encode()).get());
+        model.flushWrites();
+        ObjectTree stored = model.getObjectTree(modelId);
+        REQUIRE(stored.isValid());
+        REQUIRE(stored.size() == 5);
+        REQUIRE(stored.name(4) == "ground.s");
+
+        REQUIRE(model.deleteObjectsForModel(modelId));
+        REQUIRE_FALSE(model.getObjectTree(modelId).isValid());
+    }
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Processing Stages", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+
+    int modelId = 0;
+    {
+        Model model(testDir);
+        REQUIRE(model.insertModel({0, "Tank", "", "{}", "", {}, "", "/tank.g", "Library", false, true, true, {}}));
+        modelId = model.getModelByFilePath("/tank.g").id;
+        REQUIRE(model.getStageStatus(modelId).empty());
+
+        REQUIRE(model.setStageState(modelId, Model::MetadataStage | Model::HierarchyStage, Model::StageDone));
+        REQUIRE(model.setStageStateAsync(modelId, Model::ThumbnailStage, Model::StageFailed, "rt timed out").get());
+        model.flushWrites();
+
+        std::vector<StageStatus> stages = model.getStageStatus(modelId);
+        REQUIRE(stages.size() == 3);
+        REQUIRE(stages[2].stage == Model::ThumbnailStage);
+        REQUIRE(stages[2].state == Model::StageFailed);
+        REQUIRE(stages[2].error == "rt timed out");
+        REQUIRE(stages[0].error.empty());
+        REQUIRE(stages[0].updated_at > 0);
+
+        // Only finished stages count, so the failed thumbnail is resumed
+        auto signatures = model.getIncludedFileSignatures();
+        REQUIRE(signatures.size() == 1);
+        unsigned int expectedDone = Model::MetadataStage | Model::HierarchyStage;
+        REQUIRE(signatures[0].stages_done == expectedDone);
+
+        REQUIRE(model.setStageState(modelId, Model::ThumbnailStage, Model::StageDone));
+        unsigned int fullSizeDone = expectedDone | Model::ThumbnailStage;
+        REQUIRE(model.getIncludedFileSignatures()[0].stages_done == fullSizeDone);
+        REQUIRE(model.setStageState(modelId, Model::PreviewStage, Model::StageDone));
+        REQUIRE(model.getIncludedFileSignatures()[0].stages_done == Model::IndexingStages);
+
+        REQUIRE(model.resetStages(Model::ThumbnailStage | Model::PreviewStage));
+        REQUIRE(model.getIncludedFileSignatures()[0].stages_done == expectedDone);
+        REQUIRE(model.getStageStatus(modelId).size() == 2);
+    }
+
+    SECTION("Backfilled From is_processed") {
+        sqlite3* raw = nullptr;
+        std::string dbFile = testDir + "/.cadventory/metadata.db";
+        REQUIRE(sqlite3_open(dbFile.c_str(), &raw) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(raw, "DROP TABLE model_stages;", nullptr, nullptr, nullptr) == SQLITE_OK);
+        sqlite3_close(raw);
+
+        Model reopened(testDir);
+        // Processed, but no thumbnail was ever stored
+        std::vector<StageStatus> stages = reopened.getStageStatus(modelId);
+        REQUIRE(stages.size() == 2);
+        REQUIRE(stages[0].stage == Model::MetadataStage);
+        REQUIRE(stages[1].stage == Model::HierarchyStage);
+    }
+
+    SECTION("Dropped With The Model") {
+        Model reopened(testDir);
+        REQUIRE(reopened.deleteModel(modelId));
+        REQUIRE(reopened.getStageStatus(modelId).empty());
+    }
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Stage Failure Quarantine", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+
+    Model model(testDir);
+    REQUIRE(model.insertModel({0, "Tank", "", "{}", "", {}, "", "/tank.g", "Library", false, true, true, {}}));
+    REQUIRE(model.insertModel({0, "Copy", "", "{}", "", {}, "", "/copy/tank.g", "Library", false, true, true, {}}));
+    REQUIRE(model.insertModel({0, "Truck", "", "{}", "", {}, "", "/truck.g", "Library", false, true, true, {}}));
+    int tankId = model.getModelByFilePath("/tank.g").id;
+    int copyId = model.getModelByFilePath("/copy/tank.g").id;
+    int truckId = model.getModelByFilePath("/truck.g").id;
+
+    // Nothing to key on until the contents have been hashed
+    REQUIRE(model.recordStageAttempt(tankId, Model::ThumbnailStage));
+    REQUIRE(model.getQuarantinedStages().empty());
+
+    REQUIRE(model.setFileSignature(tankId, 10, 20, 0xABCDu));
+    REQUIRE(model.setFileSignature(copyId, 10, 30, 0xABCDu));
+    REQUIRE(model.setFileSignature(truckId, 40, 50, 0x1234u));
+
+    // An attempt counts before the stage runs, so a crash still backs off
+    REQUIRE(model.recordStageAttemptAsync(tankId, Model::ThumbnailStage).get());
+    model.flushWrites();
+    auto quarantined = model.getQuarantinedStages();
+    REQUIRE(quarantined.size() == 2);
+    REQUIRE(quarantined[tankId] == Model::ThumbnailStage);
+    REQUIRE(quarantined[copyId] == Model::ThumbnailStage);
+    REQUIRE(quarantined.count(truckId) == 0);
+
+    REQUIRE(model.setStageState(tankId, Model::ThumbnailStage, Model::StageFailed, "rt timed out"));
+    REQUIRE(model.recordStageAttempt(tankId, Model::ThumbnailStage | Model::GistStage));
+    unsigned int expected = Model::ThumbnailStage | Model::GistStage;
+    REQUIRE(model.getQuarantinedStages()[tankId] == expected);
+
+    // Doubling backoff, capped
+    REQUIRE(Model::quarantineDelay(1) == Model::kQuarantineBaseDelay);
+    REQUIRE(Model::quarantineDelay(3) == 4 * Model::kQuarantineBaseDelay);
+    REQUIRE(Model::quarantineDelay(1000) == Model::kQuarantineMaxDelay);
+
+    sqlite3* raw = nullptr;
+    std::string dbFile = testDir + "/.cadventory/metadata.db";
+    REQUIRE(sqlite3_open(dbFile.c_str(), &raw) == SQLITE_OK);
+    sqlite3_stmt* stmt = nullptr;
+    REQUIRE(sqlite3_prepare_v2(raw, "SELECT attempts, error FROM stage_failures WHERE stage = 4;",
+                               -1, &stmt, nullptr) == SQLITE_OK);
+    REQUIRE(sqlite3_step(stmt) == SQLITE_ROW);
+    REQUIRE(sqlite3_column_int(stmt, 0) == 2);
+    std::string error = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    REQUIRE(error == "rt timed out");
+    sqlite3_finalize(stmt);
+
+    // Past one base delay the single gist attempt may retry, but two
+    // thumbnail attempts wait twice as long
+    std::string backdate = "UPDATE stage_failures SET last_attempt = strftime('%s', 'now') - " +
+                           std::to_string(Model::kQuarantineBaseDelay + 60) + ";";
+    REQUIRE(sqlite3_exec(raw, backdate.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK);
+    sqlite3_close(raw);
+    expected = Model::ThumbnailStage;
+    REQUIRE(model.getQuarantinedStages()[tankId] == expected);
+
+    // Success on any copy lifts it for the shared contents
+    REQUIRE(model.setStageState(copyId, Model::ThumbnailStage, Model::StageDone));
+    REQUIRE(model.getQuarantinedStages().count(tankId) == 0);
+
+    // Edited contents start over
+    REQUIRE(model.recordStageAttempt(tankId, Model::HierarchyStage));
+    REQUIRE(model.setFileSignature(copyId, 11, 31, 0xBEEFu));
+    quarantined = model.getQuarantinedStages();
+    REQUIRE(quarantined.count(tankId) == 1);
+    REQUIRE(quarantined.count(copyId) == 0);
+
+    REQUIRE(model.clearQuarantine());
+    REQUIRE(model.getQuarantinedStages().empty());
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Query Statistics", "[Model]") {
+    REQUIRE(QueryStats::normalize("SELECT *  FROM models\n   WHERE id = 42 AND name = 'it''s';") ==
+            "SELECT * FROM models WHERE id = ? AND name = ?");
+    REQUIRE(QueryStats::normalize("SELECT id FROM t WHERE id IN (?, ?, ?) AND x = ?1") ==
+            "SELECT id FROM t WHERE id IN (?) AND x = ?1");
+    REQUIRE(QueryStats::normalize("SELECT col2 FROM t2") == "SELECT col2 FROM t2");
+
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+
+    QueryStats& stats = QueryStats::global();
+    stats.reset();
+    stats.setEnabled(true);
+    {
+        // Connections are attached as they are opened
+        Model model(testDir);
+        for (int i = 0; i < 20; ++i) {
+            std::string path = "/m" + std::to_string(i) + ".g";
+            REQUIRE(model.insertModel({0, "M", "", "{}", "", {}, "", path, "Library", false, true, true, {}}));
+        }
+        for (int i = 0; i < 20; ++i) {
+            REQUIRE(model.getModelByFilePath("/m" + std::to_string(i) + ".g").id > 0);
+        }
+        REQUIRE(model.getIncludedFileSignatures().size() == 20);
+    }
+    stats.setEnabled(false);
+
+    std::vector<QueryTemplateStats> templates = stats.snapshot();
+    REQUIRE_FALSE(templates.empty());
+    for (size_t i = 1; i < templates.size(); ++i) {
+        REQUIRE(templates[i - 1].totalMs >= templates[i].totalMs);
+    }
+
+    auto byPath = std::find_if(templates.begin(), templates.end(), [](const QueryTemplateStats& entry) {
+        return entry.sql.find("FROM models WHERE file_path = ?") != std::string::npos &&
+               entry.sql.find("SELECT id, short_name") == 0;
+    });
+    REQUIRE(byPath != templates.end());
+    REQUIRE(byPath->calls == 20);
+    REQUIRE(byPath->rows == 20);
+    REQUIRE(byPath->p50Ms <= byPath->p99Ms);
+    REQUIRE(byPath->p99Ms <= byPath->maxMs);
+    REQUIRE(byPath->totalMs >= byPath->maxMs);
+
+    auto signatures = std::find_if(templates.begin(), templates.end(), [](const QueryTemplateStats& entry) {
+        return entry.sql.find("SELECT id, file_path, is_processed") != std::string::npos;
+    });
+    REQUIRE(signatures != templates.end());
+    REQUIRE(signatures->rows == 20);
+
+    std::string json = stats.toJson();
+    REQUIRE(json.rfind("{\"queries\": [", 0) == 0);
+    REQUIRE(json.find("\"p99_ms\": ") != std::string::npos);
+
+    // Disabled collection leaves new connections untraced
+    stats.reset();
+    {
+        Model model(testDir);
+        model.getModelByFilePath("/m1.g");
+    }
+    REQUIRE(stats.snapshot().empty());
+    REQUIRE(stats.toJson() == "{\"queries\": []}\n");
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Streaming Thumbnails", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+
+    Model model(testDir);
+    REQUIRE(model.insertModel({0, "Tank", "", "{}", "", {}, "", "/tank.g", "Library", false, true, true, {}}));
+    int modelId = model.getModelByFilePath("/tank.g").id;
+    REQUIRE(model.openThumbnail(modelId) == nullptr);
+    REQUIRE(model.readThumbnail(modelId).isNull());
+
+    // Several write chunks long, with a tail that does not fill one
+    std::string payload(200 * 1024 + 123, '\0');
+    for (size_t i = 0; i < payload.size(); ++i) {
+        payload[i] = static_cast<char>((i * 131) ^ (i >> 7));
+    }
+    QByteArray bytes(payload.data(), static_cast<int>(payload.size()));
+    QBuffer source(&bytes);
+    REQUIRE(source.open(QIODevice::ReadOnly));
+    REQUIRE(model.writeThumbnail(modelId, source));
+
+    {
+        std::unique_ptr<BlobDevice> device = model.openThumbnail(modelId);
+        REQUIRE(device != nullptr);
+        REQUIRE(device->size() == static_cast<qint64>(payload.size()));
+        REQUIRE_FALSE(device->isSequential());
+
+        // Read in odd-sized pieces, then jump back and re-read
+        std::string streamed;
+        char piece[7777];
+        qint64 got = 0;
+        while ((got = device->read(piece, sizeof(piece))) > 0) {
+            streamed.append(piece, static_cast<size_t>(got));
+        }
+        REQUIRE(streamed == payload);
+        REQUIRE(device->read(piece, sizeof(piece)) == 0);
+
+        REQUIRE(device->seek(100000));
+        REQUIRE(device->read(piece, 16) == 16);
+        REQUIRE(std::string(piece, 16) == payload.substr(100000, 16));
+    }
+
+    // Whole-row reads still see the same bytes
+    std::vector<char> copied = model.getModelById(modelId).thumbnail;
+    REQUIRE(std::string(copied.begin(), copied.end()) == payload);
+
+    // Writing from a file on the writer thread replaces the old image
+    std::string pngPath = testDir + "/render.png";
+    {
+        std::ofstream png(pngPath, std::ios::binary);
+        png << "not really a png";
+    }
+    REQUIRE(model.writeThumbnailFileAsync(modelId, pngPath).get());
+    model.flushWrites();
+    {
+        std::unique_ptr<BlobDevice> device = model.openThumbnail(modelId);
+        REQUIRE(device != nullptr);
+        QByteArray stored = device->readAll();
+        REQUIRE(std::string(stored.constData(), stored.size()) == "not really a png");
+    }
+
+    REQUIRE_FALSE(model.writeThumbnailFileAsync(modelId, testDir + "/missing.png").get());
+    QBuffer empty;
+    REQUIRE(empty.open(QIODevice::ReadOnly));
+    REQUIRE_FALSE(model.writeThumbnail(modelId, empty));
+    source.seek(0);
+    REQUIRE_FALSE(model.writeThumbnail(modelId + 1000, source));
+
+    // One thread holding more open thumbnails than there are read
+    // connections shares its lease instead of waiting on itself
+    auto nested = std::async(std::launch::async, [&]() {
+        std::vector<std::unique_ptr<BlobDevice>> devices;
+        for (int i = 0; i < 6; ++i) {
+            devices.push_back(model.openThumbnail(modelId));
+        }
+        return model.getModelById(modelId).short_name;
+    });
+    REQUIRE(nested.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    REQUIRE(nested.get() == "Tank");
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Bulk Object Insert", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+
+    {
+        Model model(testDir);
+        REQUIRE(model.insertModel({0, "Truck", "", "{}", "", {}, "", "/truck.g", "Library", false, true, true, {}}));
+        int modelId = model.getModelByFilePath("/truck.g").id;
+
+        // all.g > chassis.c > axle.c > wheel.r, parents given by index
+        std::vector<ObjectData> objects = {
+            {0, modelId, "all.g", -1, true},
+            {0, modelId, "chassis.c", 0, false},
+            {0, modelId, "axle.c", 1, false},
+            {0, modelId, "wheel.r", 2, false},
+            {0, modelId, "wheel.r", 2, false},
+            {0, modelId, "cab.r", 0, false},
+        };
+        std::vector<int> ids = model.insertObjectsAsync(objects).get();
+        model.flushWrites();
+        REQUIRE(ids.size() == objects.size());
+
+        REQUIRE(model.getObjectById(ids[0]).parent_object_id == -1);
+        REQUIRE(model.getObjectById(ids[3]).parent_object_id == ids[2]);
+        REQUIRE(model.getObjectById(ids[5]).parent_object_id == ids[0]);
+        REQUIRE(model.getObjectById(ids[0]).is_selected);
+        REQUIRE(model.getObjectsForModel(modelId).size() == objects.size());
+        REQUIRE(model.getObjectDepth(ids[4]) == 3);
+        REQUIRE(model.getSubtree(ids[1]).size() == 4);
+
+        // A parent listed after its child is rejected as a whole
+        std::vector<ObjectData> unordered = {
+            {0, modelId, "orphan.r", 1, false},
+            {0, modelId, "late.c", -1, false},
+        };
+        REQUIRE(model.insertObjects(unordered).empty());
+        REQUIRE(model.getObjectsForModel(modelId).size() == objects.size());
+        REQUIRE(model.insertObjects({}).empty());
+    }
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Render Cache", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+    std::string cacheDir = testDir + "/render-cache";
+
+    auto key = [](uint64_t hash, const std::string& object) {
+        return RenderCache::Key{hash, object, "rt default", 512, "png"};
+    };
+
+    SECTION("Store and Fetch") {
+        RenderCache cache(cacheDir);
+        std::string bytes;
+        REQUIRE_FALSE(cache.fetch(key(7, "all.g"), bytes));
+        REQUIRE(cache.store(key(7, "all.g"), "image"));
+        REQUIRE(cache.fetch(key(7, "all.g"), bytes));
+        REQUIRE(bytes == "image");
+
+        // Every part of the key counts
+        RenderCache::Key smaller = key(7, "all.g");
+        smaller.size = 64;
+        REQUIRE_FALSE(cache.contains(smaller));
+        REQUIRE_FALSE(cache.contains(key(8, "all.g")));
+        REQUIRE_FALSE(cache.contains(key(7, "wheel.r")));
+
+        // Contents that were never hashed are not cached
+        REQUIRE_FALSE(cache.store(key(0, "all.g"), "image"));
+
+        std::string copy = testDir + "/copy.png";
+        REQUIRE(cache.fetchFile(key(7, "all.g"), copy));
+        std::ifstream in(copy, std::ios::binary);
+        std::string copied((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        REQUIRE(copied == "image");
+
+        // A new instance finds what an earlier one stored
+        RenderCache reopened(cacheDir);
+        REQUIRE(reopened.entryCount() == 1);
+        REQUIRE(reopened.totalBytes() == 5);
+        REQUIRE(reopened.contains(key(7, "all.g")));
+    }
+
+    SECTION("Least Recently Used Eviction") {
+        RenderCache cache(cacheDir, 1000);
+        std::string image(300, 'x');
+        REQUIRE(cache.store(key(1, "a"), image));
+        REQUIRE(cache.store(key(1, "b"), image));
+        REQUIRE(cache.store(key(1, "c"), image));
+
+        std::string bytes;
+        REQUIRE(cache.fetch(key(1, "a"), bytes));
+        REQUIRE(cache.store(key(1, "d"), image));
+
+        // b was used least recently
+        REQUIRE(cache.totalBytes() <= 1000);
+        REQUIRE_FALSE(cache.contains(key(1, "b")));
+        REQUIRE(cache.contains(key(1, "a")));
+        REQUIRE(cache.contains(key(1, "d")));
+
+        cache.setMaxBytes(300);
+        REQUIRE(cache.entryCount() == 1);
+        REQUIRE(cache.contains(key(1, "d")));
+    }
+
+    SECTION("Garbage Collection of Stale Contents") {
+        Model model(testDir);
+        REQUIRE(model.insertModel({0, "Truck", "", "{}", "", {}, "", "/truck.g", "Library", false, true, true, {}}));
+        int modelId = model.getModelByFilePath("/truck.g").id;
+        REQUIRE(model.getContentHash(modelId) == 0);
+        REQUIRE(model.setFileSignature(modelId, 100, 200, 42));
+        REQUIRE(model.getContentHash(modelId) == 42);
+        REQUIRE(model.getContentHashes() == std::set<uint64_t>{42});
+
+        RenderCache& cache = model.renderCache();
+        REQUIRE(cache.store(key(42, "all.g"), "current"));
+        REQUIRE(cache.store(key(41, "all.g"), "edited away"));
+        REQUIRE(cache.collectGarbage(model.getContentHashes()) == 1);
+        REQUIRE(cache.contains(key(42, "all.g")));
+        REQUIRE_FALSE(cache.contains(key(41, "all.g")));
+    }
+
+    SECTION("Temporaries") {
+        RenderCache writer(cacheDir);
+        REQUIRE(writer.store(key(42, "all.g"), "current"));
+        std::string entry;
+        for (const auto& file : std::filesystem::directory_iterator(cacheDir)) {
+            entry = file.path().string();
+        }
+        std::string inFlight = entry + ".part7";
+        std::string abandoned = entry + ".part3";
+        std::ofstream(inFlight) << "half written";
+        std::ofstream(abandoned) << "half written";
+        std::filesystem::last_write_time(abandoned, std::filesystem::file_time_type::clock::now() - std::chrono::hours(1));
+
+        // Not entries, and only the abandoned one is swept
+        RenderCache cache(cacheDir);
+        REQUIRE(cache.entryCount() == 1);
+        REQUIRE(cache.totalBytes() == 7);
+        REQUIRE(std::filesystem::exists(inFlight));
+        REQUIRE_FALSE(std::filesystem::exists(abandoned));
+        REQUIRE(cache.collectGarbage({42}) == 0);
+        REQUIRE(std::filesystem::exists(inFlight));
+    }
+
+    SECTION("Disabled Without a Directory") {
+        RenderCache cache("");
+        REQUIRE_FALSE(cache.store(key(7, "all.g"), "image"));
+        REQUIRE_FALSE(cache.contains(key(7, "all.g")));
+        REQUIRE(cache.entryCount() == 0);
+    }
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Thumbnail Levels", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+
+    Model model(testDir);
+    REQUIRE(model.insertModel({0, "Tank", "", "{}", "", {}, "", "/tank.g", "Library", false, true, true, {}}));
+    int modelId = model.getModelByFilePath("/tank.g").id;
+
+    auto stored = [&](int minSize) {
+        std::unique_ptr<BlobDevice> device = model.openThumbnail(modelId, minSize);
+        if (!device) return std::string();
+        QByteArray bytes = device->readAll();
+        return std::string(bytes.constData(), bytes.size());
+    };
+
+    std::map<int, QByteArray> levels = {{64, "level 64"}, {128, "level 128"}, {256, "level 256"}};
+    REQUIRE(model.writeThumbnailAsync(modelId, "full size", levels).get());
+    model.flushWrites();
+
+    // The smallest image that covers the request
+    REQUIRE(stored(0) == "full size");
+    REQUIRE(stored(48) == "level 64");
+    REQUIRE(stored(64) == "level 64");
+    REQUIRE(stored(80) == "level 128");
+    REQUIRE(stored(200) == "level 256");
+    REQUIRE(stored(512) == "full size");
+
+    // A new thumbnail drops the levels made from the old one
+    REQUIRE(model.writeThumbnailAsync(modelId, "preview").get());
+    model.flushWrites();
+    REQUIRE(stored(80) == "preview");
+
+    REQUIRE(model.writeThumbnailLevels(modelId, {{128, "new 128"}}));
+    REQUIRE(stored(80) == "new 128");
+    REQUIRE(model.writeThumbnailLevels(modelId, {}));
+
+    // Deleting the model takes its levels along
+    REQUIRE(model.deleteModel(modelId));
+    REQUIRE(model.openThumbnail(modelId, 80) == nullptr);
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Render Cost", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+
+    {
+        Model model(testDir);
+        REQUIRE(model.insertModel({0, "Truck", "", "{}", "", {}, "", "/truck.g", "Library", false, true, true, {}}));
+        int modelId = model.getModelByFilePath("/truck.g").id;
+
+        // Unknown until something measures it
+        REQUIRE(model.getRenderCost(modelId) == 0);
+        REQUIRE(model.getIncludedFileSignatures().front().render_cost == 0);
+
+        REQUIRE(model.setRenderCostAsync(modelId, 1234).get());
+        model.flushWrites();
+        REQUIRE(model.getRenderCost(modelId) == 1234);
+        REQUIRE(model.getIncludedFileSignatures().front().render_cost == 1234);
+    }
+
+    // Kept across sessions
+    {
+        Model model(testDir);
+        REQUIRE(model.getRenderCost(model.getModelByFilePath("/truck.g").id) == 1234);
+    }
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Geometry Statistics", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+
+    Model model(testDir);
+    REQUIRE(model.insertModel({0, "Truck", "", "{}", "", {}, "", "/truck.g", "Library", false, true, true, {}}));
+    REQUIRE(model.insertModel({0, "Bolt", "", "{}", "", {}, "", "/bolt.g", "Library", false, true, true, {}}));
+    int truckId = model.getModelByFilePath("/truck.g").id;
+    int boltId = model.getModelByFilePath("/bolt.g").id;
+
+    // Nothing stored yet
+    REQUIRE(model.getModelGeometry(truckId).primitives == 0);
+    REQUIRE_FALSE(model.getModelGeometry(truckId).has_bounds);
+
+    ModelGeometry truck;
+    truck.primitives = 1200;
+    truck.regions = 300;
+    truck.combinations = 340;
+    truck.has_bounds = true;
+    truck.min[0] = -2500; truck.min[1] = -1000; truck.min[2] = 0;
+    truck.max[0] = 2500;  truck.max[1] = 1000;  truck.max[2] = 2200;
+    truck.units = "in";
+    truck.primitive_types = {{"arb8", 900}, {"tgc", 300}};
+    truck.shaders = {{"plastic", 250}, {"glass", 50}};
+    truck.materials = {{"steel", 280}};
+    REQUIRE(model.setModelGeometryAsync(truckId, truck).get());
+
+    ModelGeometry bolt;
+    bolt.primitives = 12;
+    bolt.regions = 1;
+    bolt.combinations = 1;
+    bolt.has_bounds = true;
+    bolt.max[0] = 10; bolt.max[1] = 10; bolt.max[2] = 40;
+    bolt.units = "mm";
+    bolt.primitive_types = {{"tgc", 12}};
+    bolt.shaders = {{"plastic", 1}};
+    REQUIRE(model.setModelGeometry(boltId, bolt));
+    model.flushWrites();
+
+    ModelGeometry stored = model.getModelGeometry(truckId);
+    REQUIRE(stored.primitives == 1200);
+    REQUIRE(stored.regions == 300);
+    REQUIRE(stored.combinations == 340);
+    REQUIRE(stored.has_bounds);
+    REQUIRE(stored.min[0] == -2500);
+    REQUIRE(stored.max[2] == 2200);
+    REQUIRE(stored.units == "in");
+    REQUIRE(stored.primitive_types == truck.primitive_types);
+    REQUIRE(stored.shaders == truck.shaders);
+    REQUIRE(stored.materials == truck.materials);
+
+    SECTION("Filters and orders by the first numeric field") {
+        REQUIRE((model.modelsMatchingGeometry("primitives>100") == std::vector<int>{truckId}));
+        REQUIRE((model.modelsMatchingGeometry("size<100") == std::vector<int>{boltId}));
+        REQUIRE((model.modelsMatchingGeometry("height>=40 width<=5000") == std::vector<int>{boltId, truckId}));
+        REQUIRE((model.modelsMatchingGeometry("shader=plastic primitives>0") == std::vector<int>{boltId, truckId}));
+        REQUIRE((model.modelsMatchingGeometry("material=steel") == std::vector<int>{truckId}));
+        REQUIRE((model.modelsMatchingGeometry("shader!=glass") == std::vector<int>{boltId}));
+        REQUIRE((model.modelsMatchingGeometry("type=arb8 units=in") == std::vector<int>{truckId}));
+        REQUIRE(model.modelsMatchingGeometry("units=ft").empty());
+    }
+
+    SECTION("Malformed expressions match nothing") {
+        REQUIRE(model.modelsMatchingGeometry("weight>10").empty());
+        REQUIRE(model.modelsMatchingGeometry("primitives>many").empty());
+        REQUIRE(model.modelsMatchingGeometry("shader<plastic").empty());
+        REQUIRE(model.modelsMatchingGeometry("primitives").empty());
+    }
+
+    SECTION("Reprocessing replaces the counts") {
+        bolt.shaders = {{"glass", 1}};
+        REQUIRE(model.setModelGeometry(boltId, bolt));
+        REQUIRE(model.getModelGeometry(boltId).shaders == bolt.shaders);
+        REQUIRE((model.modelsMatchingGeometry("shader=plastic") == std::vector<int>{truckId}));
+    }
+
+    SECTION("Unknown bounds keep the known ones") {
+        // Rendered by rt or from the render cache: nothing was measured
+        ModelGeometry unmeasured = bolt;
+        unmeasured.has_bounds = false;
+        REQUIRE(model.setModelGeometry(boltId, unmeasured));
+        REQUIRE(model.getModelGeometry(boltId).has_bounds);
+        REQUIRE(model.getModelGeometry(boltId).max[2] == 40);
+
+        // A duplicate file takes them from its twin
+        REQUIRE(model.insertModel({0, "Bolt Copy", "", "{}", "", {}, "", "/copy/bolt.g", "Library", false, true, true, {}}));
+        int copyId = model.getModelByFilePath("/copy/bolt.g").id;
+        REQUIRE(model.setFileSignature(boltId, 100, 1, 77));
+        REQUIRE(model.setFileSignature(copyId, 100, 2, 77));
+        REQUIRE(model.setModelGeometry(copyId, unmeasured));
+        REQUIRE(model.getModelGeometry(copyId).has_bounds);
+        REQUIRE((model.modelsMatchingGeometry("size<100") == std::vector<int>{boltId, copyId}));
+
+        // With neither, the model has none
+        REQUIRE(model.insertModel({0, "Nut", "", "{}", "", {}, "", "/nut.g", "Library", false, true, true, {}}));
+        int nutId = model.getModelByFilePath("/nut.g").id;
+        REQUIRE(model.setModelGeometry(nutId, unmeasured));
+        REQUIRE_FALSE(model.getModelGeometry(nutId).has_bounds);
+    }
+
+    SECTION("Deleting a model drops its geometry") {
+        REQUIRE(model.deleteModel(truckId));
+        REQUIRE((model.modelsMatchingGeometry("primitives>0") == std::vector<int>{boltId}));
+        REQUIRE(model.getModelGeometry(truckId).primitive_types.empty());
+    }
+
+    cleanupTestDirectory(testDir);
+}
+
+TEST_CASE("Model: Object Attributes", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+
+    Model model(testDir);
+    REQUIRE(model.insertModel({0, "Truck", "", "{}", "", {}, "", "/truck.g", "Library", false, true, true, {}}));
+    REQUIRE(model.insertModel({0, "Bolt", "", "{}", "", {}, "", "/bolt.g", "Library", false, true, true, {}}));
+    int truckId = model.getModelByFilePath("/truck.g").id;
+    int boltId = model.getModelByFilePath("/bolt.g").id;
+
+    REQUIRE(model.setModelAttributesAsync(truckId, {
+        {Model::kGlobalObject, "classification", "unclassified"},
+        {"cab.r", "region_id", "1001"},
+        {"cab.r", "material_id", "7"},
+        {"cab.r", "los", "50"},
+        {"tire.r", "material_id", "12"},
+        {"tire.r", "vendor", "Goodyear"},
+    }).get());
+    REQUIRE(model.setModelAttributes(boltId, {
+        {"bolt.r", "region_id", "2001"},
+        {"bolt.r", "material_id", "7"},
+    }));
+    model.flushWrites();
+
+    SECTION("Read back per model and per object") {
+        REQUIRE(model.getAttributesForModel(truckId).size() == 6);
+        auto cab = model.getAttributesForModel(truckId, "cab.r");
+        REQUIRE(cab.size() == 3);
+        REQUIRE(cab[0].key == "los");
+        REQUIRE(cab[0].value == "50");
+    }
+
+    SECTION("Filter on keys and values") {
+        REQUIRE((model.modelsMatchingAttributes("material_id=7") == std::vector<int>{truckId, boltId}));
+        REQUIRE((model.modelsMatchingAttributes("material_id=12") == std::vector<int>{truckId}));
+        REQUIRE((model.modelsMatchingAttributes("vendor") == std::vector<int>{truckId}));
+        REQUIRE((model.modelsMatchingAttributes("region_id=2*") == std::vector<int>{boltId}));
+        REQUIRE((model.modelsMatchingAttributes("material_id=7 vendor!=Goodyear") == std::vector<int>{boltId}));
+        REQUIRE(model.modelsMatchingAttributes("material_id=99").empty());
+        REQUIRE(model.modelsMatchingAttributes("=7").empty());
+        REQUIRE(model.modelsMatchingAttributes("material_id=").empty());
+        REQUIRE(model.attributeKeys()["material_id"] == 2);
+        REQUIRE(model.attributeKeys()["vendor"] == 1);
+    }
+
+    SECTION("Searchable and shown as global properties") {
+        REQUIRE((model.searchModels("goodyear") == std::vector<int>{truckId}));
+        auto properties = model.getPropertiesForModel(truckId);
+        REQUIRE(properties["global.classification"] == "unclassified");
+        REQUIRE(properties.count("global.vendor") == 0);
+        REQUIRE(model.setPropertyForModel(truckId, "global.classification", "secret") == false);
+    }
+
+    SECTION("Reprocessing replaces a model's attributes") {
+        REQUIRE(model.setModelAttributes(truckId, {{"cab.r", "region_id", "1001"}}));
+        REQUIRE(model.getAttributesForModel(truckId).size() == 1);
+        REQUIRE(model.searchModels("goodyear").empty());
+        REQUIRE((model.modelsMatchingAttributes("material_id=7") == std::vector<int>{boltId}));
+    }
+
+    SECTION("Deleting a model drops its attributes") {
+        REQUIRE(model.deleteModel(boltId));
+        REQUIRE(model.getAttributesForModel(boltId).empty());
+        REQUIRE(model.modelsMatchingAttributes("region_id=2001").empty());
+    }
+
+    cleanupTestDirectory(testDir);
+}
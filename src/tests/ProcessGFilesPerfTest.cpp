@@ -0,0 +1,193 @@
+#include "ProcessGFiles.h"
+#include "Model.h"
+#include <brlcad/ged.h>
+#include <brlcad/raytrace.h>
+#include <brlcad/wdb.h>
+#include <QCoreApplication>
+#include <chrono>
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+const std::string PERF_LIBRARY_PATH = "./temp_perf_library";
+const std::string PERF_G_FILE = PERF_LIBRARY_PATH + "/assembly.g";
+
+// Objects in each combination's instanced subtree, itself included; with
+// every use expanded, the catalog holds the subtrees of the top-level ones
+std::map<std::string, size_t> instancedSize;
+
+void writeComb(struct rt_wdb* wdbp, const std::string& name, const std::vector<std::string>& members, bool region) {
+    struct wmember head;
+    BU_LIST_INIT(&head.l);
+    for (const auto& member : members) {
+        mk_addmember(member.c_str(), &head.l, nullptr, WMOP_UNION);
+    }
+    mk_lcomb(wdbp, name.c_str(), &head, region ? 1 : 0, nullptr, nullptr, nullptr, 0);
+    size_t size = 1;
+    for (const auto& member : members) {
+        size += instancedSize.count(member) ? instancedSize[member] : 1;
+    }
+    instancedSize[name] = size;
+}
+
+// A plain tree: fanout^depth regions under distinct assemblies
+std::string writeTree(struct rt_wdb* wdbp, const std::string& prefix, int depth, int fanout) {
+    if (depth == 0) {
+        std::string region = prefix + ".r";
+        writeComb(wdbp, region, {"ball.s"}, true);
+        return region;
+    }
+    std::vector<std::string> members;
+    for (int i = 0; i < fanout; ++i) {
+        members.push_back(writeTree(wdbp, prefix + "_" + std::to_string(i), depth - 1, fanout));
+    }
+    std::string assembly = prefix + ".c";
+    writeComb(wdbp, assembly, members, false);
+    return assembly;
+}
+
+// Sub-assemblies shared across levels: each of the width assemblies on a
+// level uses every assembly of the level below, so the instanced tree has
+// width^levels regions while the database holds width * levels combinations
+std::string writeSharedDag(struct rt_wdb* wdbp, int levels, int width) {
+    std::vector<std::string> below;
+    for (int i = 0; i < width; ++i) {
+        below.push_back("part_" + std::to_string(i) + ".r");
+        writeComb(wdbp, below.back(), {"ball.s"}, true);
+    }
+    for (int level = 1; level <= levels; ++level) {
+        std::vector<std::string> current;
+        for (int i = 0; i < width; ++i) {
+            current.push_back("sub_" + std::to_string(level) + "_" + std::to_string(i) + ".c");
+            writeComb(wdbp, current.back(), below, false);
+        }
+        below = current;
+    }
+    writeComb(wdbp, "shared.c", below, false);
+    return "shared.c";
+}
+
+void writeAssembly() {
+    struct rt_wdb* wdbp = wdb_fopen(PERF_G_FILE.c_str());
+    assert(wdbp);
+    point_t center = {0, 0, 0};
+    mk_sph(wdbp, "ball.s", center, 10.0);
+    writeTree(wdbp, "tree", 4, 10);
+    writeSharedDag(wdbp, 5, 6);
+    wdb_close(wdbp);
+}
+
+void testHierarchyExtractionPerformance() {
+    std::filesystem::remove_all(PERF_LIBRARY_PATH);
+    std::filesystem::create_directories(PERF_LIBRARY_PATH);
+    writeAssembly();
+
+    Model model(PERF_LIBRARY_PATH);
+    model.insertModel({0, "assembly", "", "{}", "", {}, "", PERF_G_FILE, "Perf", false, false, true, {}});
+    ModelData modelData = model.getModelByFilePath(PERF_G_FILE);
+    ProcessGFiles processor(&model);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    processor.processGFile(modelData, Model::HierarchyStage);
+    model.flushWrites();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    size_t objects = model.getObjectsForModel(modelData.id).size();
+    std::chrono::duration<double, std::milli> duration = end - start;
+    auto rate = objects / (duration.count() / 1000.0);
+    std::cout << "Extracting " << objects << " objects took " << duration.count() << " ms" << std::endl;
+    std::cout << "Extraction rate is " << rate << " objects/sec" << std::endl;
+
+    // Both top-level assemblies with every instance of the shared
+    // sub-assemblies, though each was decoded once
+    assert(objects == instancedSize["tree.c"] + instancedSize["shared.c"]);
+    assert(rate > 5000); // 5k objects/sec
+
+    std::filesystem::remove_all(PERF_LIBRARY_PATH);
+}
+
+// A catalog of many small files, where opening and closing each database
+// costs more than reading it
+void testSmallFileOpenOverhead() {
+    const int fileCount = 200;
+    std::filesystem::remove_all(PERF_LIBRARY_PATH);
+    std::filesystem::create_directories(PERF_LIBRARY_PATH);
+
+    std::vector<std::string> paths;
+    for (int i = 0; i < fileCount; ++i) {
+        paths.push_back(PERF_LIBRARY_PATH + "/part_" + std::to_string(i) + ".g");
+        struct rt_wdb* wdbp = wdb_fopen(paths.back().c_str());
+        assert(wdbp);
+        point_t center = {0, 0, 0};
+        mk_sph(wdbp, "ball.s", center, 10.0);
+        writeComb(wdbp, "ball.r", {"ball.s"}, true);
+        writeComb(wdbp, "all.g", {"ball.r"}, false);
+        wdb_close(wdbp);
+    }
+
+    // Open and close alone: a full GED context against librt's directory
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const auto& path : paths) {
+        struct ged* gedp = ged_open("db", path.c_str(), 0);
+        assert(gedp != GED_NULL);
+        ged_close(gedp);
+    }
+    std::chrono::duration<double, std::milli> gedDuration = std::chrono::high_resolution_clock::now() - start;
+
+    start = std::chrono::high_resolution_clock::now();
+    for (const auto& path : paths) {
+        struct db_i* dbip = db_open(path.c_str(), DB_OPEN_READONLY);
+        assert(dbip != DBI_NULL);
+        int built = db_dirbuild(dbip);
+        assert(built >= 0);
+        (void)built;
+        db_update_nref(dbip, &rt_uniresource);
+        db_close(dbip);
+    }
+    std::chrono::duration<double, std::milli> dbDuration = std::chrono::high_resolution_clock::now() - start;
+
+    std::cout << "ged_open/ged_close took " << gedDuration.count() / fileCount << " ms per file" << std::endl;
+    std::cout << "db_open/db_dirbuild/db_close took " << dbDuration.count() / fileCount << " ms per file" << std::endl;
+    assert(dbDuration < gedDuration);
+
+    // The whole first pass, which opens each file the lean way
+    Model model(PERF_LIBRARY_PATH);
+    for (int i = 0; i < fileCount; ++i) {
+        model.insertModel({0, "part_" + std::to_string(i), "", "{}", "", {}, "", paths[i], "Perf", false, false, true, {}});
+    }
+    ProcessGFiles processor(&model);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (const auto& path : paths) {
+        processor.processGFile(model.getModelByFilePath(path), Model::MetadataStage | Model::HierarchyStage);
+    }
+    model.flushWrites();
+    std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+
+    auto rate = fileCount / (duration.count() / 1000.0);
+    std::cout << "Processing " << fileCount << " small files took " << duration.count() << " ms" << std::endl;
+    std::cout << "Processing rate is " << rate << " files/sec" << std::endl;
+
+    // Every file read, with its title and hierarchy
+    ModelData last = model.getModelByFilePath(paths.back());
+    assert(last.is_processed);
+    assert(model.getObjectsForModel(last.id).size() == 3);
+    assert(rate > 100); // 100 files/sec
+
+    std::filesystem::remove_all(PERF_LIBRARY_PATH);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    testHierarchyExtractionPerformance();
+    testSmallFileOpenOverhead();
+
+    return 0;
+}
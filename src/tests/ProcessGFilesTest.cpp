@@ -3,6 +3,8 @@
 #include <catch2/catch_test_macros.hpp>
 #include "../ProcessGFiles.h"
 #include "../Model.h"
+#include "../ThumbnailRenderer.h"
+#include <brlcad/ged.h>
 #include <filesystem>
 #include <memory>
 #include <QDir>
@@ -133,3 +135,86 @@ TEST_CASE("ProcessGFiles - Generate Gist Report and Check PDF Output", "[Process
 
     cleanupTestLibraryPath();
 }
+
+// Test rendering in-process with librt, deadline and cancellation included
+TEST_CASE("ProcessGFiles - In-Process Thumbnail Renderer", "[ProcessGFiles]") {
+    std::string inputFilePath = "../src/tests/annual_gift_man.g";
+    if (!std::filesystem::exists(inputFilePath)) {
+        WARN("annual_gift_man.g file not found, skipping test");
+        return;
+    }
+
+    struct ged* gedp = ged_open("db", inputFilePath.c_str(), 0);
+    REQUIRE(gedp != GED_NULL);
+    struct directory** dir = nullptr;
+    size_t dir_count = db_ls(gedp->dbip, DB_LS_TOPS, nullptr, &dir);
+    REQUIRE(dir_count > 0);
+    std::string top(dir[0]->d_namep);
+    bu_free(dir, "free directory list");
+
+    std::string error;
+    ThumbnailRenderer missing;
+    REQUIRE_FALSE(missing.prepare(gedp->dbip, "no_such_object", error));
+    REQUIRE(!error.empty());
+
+    ThumbnailRenderer renderer;
+    error.clear();
+    REQUIRE(renderer.prepare(gedp->dbip, top, error));
+    // The renderer keeps its own reference to the database
+    ged_close(gedp);
+
+    auto later = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+    QImage image;
+
+    SECTION("Renders the object") {
+        REQUIRE(renderer.render(32, later, nullptr, image, error) == ThumbnailRenderer::Result::Done);
+        REQUIRE(image.width() == 32);
+        REQUIRE(image.height() == 32);
+        bool anyGeometry = false;
+        for (int y = 0; y < image.height(); ++y) {
+            for (int x = 0; x < image.width(); ++x) {
+                anyGeometry = anyGeometry || (image.pixel(x, y) & 0xFFFFFF) != 0;
+            }
+        }
+        REQUIRE(anyGeometry);
+    }
+
+    SECTION("Stops when cancelled") {
+        std::atomic<bool> cancel(true);
+        REQUIRE(renderer.render(32, later, &cancel, image, error) == ThumbnailRenderer::Result::Cancelled);
+    }
+
+    SECTION("Stops at the deadline") {
+        auto past = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+        REQUIRE(renderer.render(32, past, nullptr, image, error) == ThumbnailRenderer::Result::TimedOut);
+    }
+}
+
+TEST_CASE("ProcessGFiles - Render Cost Estimates", "[ProcessGFiles]") {
+    // More primitives, more instances or a bigger file never look cheaper
+    REQUIRE(ProcessGFiles::estimateRenderCost(10, 10) > 0);
+    REQUIRE(ProcessGFiles::estimateRenderCost(10, 10) < ProcessGFiles::estimateRenderCost(10000, 10000));
+    REQUIRE(ProcessGFiles::estimateRenderCost(100, 100) < ProcessGFiles::estimateRenderCost(100, 1000000));
+    REQUIRE(ProcessGFiles::estimateRenderCost(int64_t(2000)) < ProcessGFiles::estimateRenderCost(int64_t(50000000)));
+    REQUIRE(ProcessGFiles::estimateFirstPassCost(1000, 100) < ProcessGFiles::estimateFirstPassCost(50000000, 100000));
+
+    QSettings settings;
+    QVariant previewTimer = settings.value("previewTimer");
+    settings.setValue("previewTimer", 30);
+
+    using std::chrono::milliseconds;
+    // No measurement yet: the configured limit
+    REQUIRE(ProcessGFiles::renderTimeLimit(0, 512) == milliseconds(30000));
+    // A few times the estimate, scaled to the image size
+    REQUIRE(ProcessGFiles::renderTimeLimit(4000, 512) == milliseconds(16000));
+    REQUIRE(ProcessGFiles::renderTimeLimit(4000 * 64, 64) == milliseconds(16000));
+    // Never below the floor or above the setting
+    REQUIRE(ProcessGFiles::renderTimeLimit(1, 512) == milliseconds(5000));
+    REQUIRE(ProcessGFiles::renderTimeLimit(1000000, 512) == milliseconds(30000));
+
+    if (previewTimer.isValid()) {
+        settings.setValue("previewTimer", previewTimer);
+    } else {
+        settings.remove("previewTimer");
+    }
+}